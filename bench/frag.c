@@ -0,0 +1,278 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   frag.c                                             :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/16 15:21:09 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/16 15:21:09 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+/* Memory efficiency over time: a phased workload on a table of live blocks,
+ * sampled every N operations.
+ *
+ *   frag [-n every] [-s scale] [-b budget_bytes]
+ *
+ * Phases (LIVE = 20000 * scale blocks):
+ *   ramp       allocate LIVE small blocks (16..527 bytes)
+ *   churn      10 * LIVE random replacements, same sizes
+ *   shift      4 * LIVE replacements with bigger sizes (256 B..32 KiB)
+ *   bulk_free  free 9 blocks out of 10
+ *   trim       malloc_trim(0)
+ *   reramp     refill the freed slots with small blocks
+ *   drain      free everything
+ *
+ * One CSV row per sample on stdout:
+ *   allocator,ops,phase,rss_bytes,mapped_bytes,live_bytes,requested_bytes,frag
+ * rss from /proc/self/statm; mapped/live from ft_malloc_stats() on this
+ * library, from mallinfo2() on glibc (both found through dlsym, 0 if
+ * neither); requested is what the workload asked for; frag is the share of
+ * mapped memory not holding requested bytes. With -b, exits 1 if the peak
+ * RSS went over the budget. The driver's own tables are mmap'd (and count
+ * in rss for a constant 16 bytes per slot). */
+
+#include "malloc.h"
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define BASE_LIVE 20000
+
+typedef struct s_slot {
+	void* p;
+	size_t size;
+} t_slot;
+
+/* glibc's struct mallinfo2 (not reachable: includes/malloc.h shadows it) */
+typedef struct s_mallinfo2 {
+	size_t arena, ordblks, smblks, hblks, hblkhd, usmblks, fsmblks, uordblks, fordblks, keepcost;
+} t_mallinfo2;
+
+static struct {
+	t_slot* slots;
+	size_t n_slots;
+	size_t every;
+	size_t ops;
+	size_t requested;
+	size_t peak_rss;
+	const char* allocator;
+	void (*ft_stats)(ft_malloc_stats_t*);
+	t_mallinfo2 (*mallinfo2)(void);
+	uint64_t rng;
+} g = {.every = 1000, .rng = 0x9e3779b97f4a7c15ull};
+
+static uint64_t rnd(void)
+{
+	g.rng ^= g.rng << 13;
+	g.rng ^= g.rng >> 7;
+	g.rng ^= g.rng << 17;
+	return g.rng;
+}
+
+/* 16..527, every power of two equally likely */
+static size_t small_size(void)
+{
+	return ((size_t)16 << (rnd() % 5)) + (size_t)(rnd() % 16);
+}
+
+/* 70% 256..1023, 30% 2..32 KiB */
+static size_t shifted_size(void)
+{
+	if (rnd() % 10 < 7)
+		return 256 + (size_t)(rnd() % 768);
+	return 2048 + (size_t)(rnd() % (30 * 1024));
+}
+
+/* ---------------- sampling ---------------- */
+
+static size_t rss_bytes(void)
+{
+	char buf[128];
+	int fd = open("/proc/self/statm", O_RDONLY);
+	if (fd < 0)
+		return 0;
+	ssize_t n = read(fd, buf, sizeof buf - 1);
+	close(fd);
+	if (n <= 0)
+		return 0;
+	buf[n] = '\0';
+	char* p = strchr(buf, ' ');
+	return p ? (size_t)strtoul(p + 1, NULL, 10) * (size_t)sysconf(_SC_PAGESIZE) : 0;
+}
+
+static void alloc_counters(size_t* mapped, size_t* live)
+{
+	*mapped = 0;
+	*live = 0;
+	if (g.ft_stats) {
+		ft_malloc_stats_t st;
+		g.ft_stats(&st);
+		for (int k = 0; k < FT_STATS_NCLASSES; ++k) {
+			*mapped += (size_t)st.classes[k].mapped_bytes;
+			*live += (size_t)st.classes[k].live_bytes;
+		}
+	} else if (g.mallinfo2) {
+		t_mallinfo2 mi = g.mallinfo2();
+		*mapped = mi.arena + mi.hblkhd;
+		*live = mi.uordblks + mi.hblkhd;
+	}
+}
+
+static void sample(const char* phase)
+{
+	size_t rss = rss_bytes(), mapped, live;
+	alloc_counters(&mapped, &live);
+	if (rss > g.peak_rss)
+		g.peak_rss = rss;
+	double frag = mapped ? 1.0 - (double)g.requested / (double)mapped : 0.0;
+	printf("%s,%zu,%s,%zu,%zu,%zu,%zu,%.4f\n", g.allocator, g.ops, phase, rss, mapped, live,
+		   g.requested, frag);
+}
+
+static void tick(const char* phase)
+{
+	if (++g.ops % g.every == 0)
+		sample(phase);
+}
+
+/* last row of a phase, unless tick() just printed it */
+static void end_phase(const char* phase)
+{
+	if (g.ops % g.every)
+		sample(phase);
+}
+
+/* ---------------- workload ---------------- */
+
+static void put(size_t i, size_t size)
+{
+	char* p = malloc(size);
+	if (!p) {
+		fprintf(stderr, "frag: malloc(%zu) failed\n", size);
+		exit(1);
+	}
+	p[0] = p[size - 1] = 1;
+	g.slots[i] = (t_slot){p, size};
+	g.requested += size;
+}
+
+static void drop(size_t i)
+{
+	if (!g.slots[i].p)
+		return;
+	free(g.slots[i].p);
+	g.requested -= g.slots[i].size;
+	g.slots[i] = (t_slot){NULL, 0};
+}
+
+static void fill(const char* phase, size_t (*size_of)(void))
+{
+	for (size_t i = 0; i < g.n_slots; ++i) {
+		if (g.slots[i].p)
+			continue;
+		put(i, size_of());
+		tick(phase);
+	}
+	end_phase(phase);
+}
+
+static void churn(const char* phase, size_t ops, size_t (*size_of)(void))
+{
+	for (size_t k = 0; k < ops; ++k) {
+		size_t i = (size_t)(rnd() % g.n_slots);
+		drop(i);
+		put(i, size_of());
+		tick(phase);
+	}
+	end_phase(phase);
+}
+
+static size_t gcd(size_t a, size_t b)
+{
+	while (b) {
+		size_t t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+/* frees every slot but one in 'keep_every' (0: all), visiting them in a
+ * scattered order: a stride coprime with the slot count */
+static void release(const char* phase, int keep_every)
+{
+	size_t start = (size_t)(rnd() % g.n_slots);
+	size_t stride = 7919;
+	while (gcd(stride, g.n_slots) != 1)
+		++stride;
+	for (size_t k = 0, i = start; k < g.n_slots; ++k, i = (i + stride) % g.n_slots) {
+		if (keep_every && i % (size_t)keep_every == 0)
+			continue;
+		if (g.slots[i].p) {
+			drop(i);
+			tick(phase);
+		}
+	}
+	end_phase(phase);
+}
+
+static int usage(const char* self)
+{
+	fprintf(stderr, "usage: %s [-n every] [-s scale] [-b budget_bytes]\n", self);
+	return 2;
+}
+
+int main(int argc, char** argv)
+{
+	size_t scale = 1, budget = 0;
+	for (int i = 1; i < argc; ++i) {
+		if (i + 1 >= argc)
+			return usage(argv[0]);
+		size_t v = (size_t)strtoull(argv[i + 1], NULL, 10);
+		if (strcmp(argv[i], "-n") == 0 && v)
+			g.every = v;
+		else if (strcmp(argv[i], "-s") == 0 && v)
+			scale = v;
+		else if (strcmp(argv[i], "-b") == 0)
+			budget = v;
+		else
+			return usage(argv[0]);
+		++i;
+	}
+
+	g.ft_stats = (void (*)(ft_malloc_stats_t*))dlsym(RTLD_DEFAULT, "ft_malloc_stats");
+	g.mallinfo2 = (t_mallinfo2(*)(void))dlsym(RTLD_DEFAULT, "mallinfo2");
+	g.allocator = g.ft_stats ? "ft_malloc" : "system";
+	g.n_slots = BASE_LIVE * scale;
+	g.slots = mmap(NULL, g.n_slots * sizeof(t_slot), PROT_READ | PROT_WRITE,
+				   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (g.slots == MAP_FAILED) {
+		perror("mmap");
+		return 1;
+	}
+
+	printf("allocator,ops,phase,rss_bytes,mapped_bytes,live_bytes,requested_bytes,frag\n");
+	sample("start");
+	fill("ramp", small_size);
+	churn("churn", 10 * g.n_slots, small_size);
+	churn("shift", 4 * g.n_slots, shifted_size);
+	release("bulk_free", 10);
+	malloc_trim(0);
+	sample("trim");
+	fill("reramp", small_size);
+	release("drain", 0);
+	fflush(stdout);
+
+	if (budget && g.peak_rss > budget) {
+		fprintf(stderr, "frag: peak rss %zu bytes over the %zu byte budget\n", g.peak_rss, budget);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,140 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   memcpy.c                                           :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/19 11:24:05 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/19 11:24:05 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+/* Copy and fill throughput of the ft_memcpy/ft_memset variants this CPU runs
+ * (lib/helpers/memops.c, linked in), next to the libc ones and the byte loop
+ * they replace. One CSV row per (op, impl, size, streaming):
+ *
+ *   op,impl,bytes,nt,gib_per_s
+ *
+ * nt=1 rows force non-temporal stores (threshold 0), nt=0 rows disable them;
+ * they are only run from NT_FROM bytes up, where the choice matters. Every
+ * cell moves about TRAFFIC bytes, best of REPEAT runs. */
+
+#include "helpers/memops.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#define MAX_BYTES (64u << 20)
+#define TRAFFIC (512ull << 20)
+#define REPEAT 3
+#define NT_FROM (256u << 10)
+
+static const size_t g_sizes[] = {64, 256, 4096, 65536, 1u << 20, 16u << 20, MAX_BYTES};
+#define N_SIZES (sizeof g_sizes / sizeof g_sizes[0])
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* the loop ft_memcpy used to be; the barrier keeps the compiler from
+ * vectorizing it or turning it into a memcpy call */
+static void* byte_copy(void* dst, const void* src, size_t n)
+{
+	unsigned char* d = dst;
+	const unsigned char* s = src;
+	for (size_t i = 0; i < n; ++i) {
+		d[i] = s[i];
+		__asm__ volatile("" ::: "memory");
+	}
+	return dst;
+}
+
+static void* byte_set(void* dst, int c, size_t n)
+{
+	unsigned char* d = dst;
+	for (size_t i = 0; i < n; ++i) {
+		d[i] = (unsigned char)c;
+		__asm__ volatile("" ::: "memory");
+	}
+	return dst;
+}
+
+static const t_memops g_byte = {"byte", byte_copy, byte_set};
+static const t_memops g_libc = {"libc", memcpy, memset};
+
+static unsigned char* g_src;
+static unsigned char* g_dst;
+
+static double run_cell(const t_memops* v, int copy, size_t bytes)
+{
+	size_t iters = (size_t)(TRAFFIC / bytes);
+	double best = 0;
+
+	if (v == &g_byte && iters > 1)
+		iters = iters / 64 + 1; /* a few seconds otherwise */
+	for (int r = 0; r < REPEAT; ++r) {
+		uint64_t t0 = now_ns();
+		for (size_t i = 0; i < iters; ++i) {
+			if (copy)
+				v->copy(g_dst, g_src, bytes);
+			else
+				v->set(g_dst, (int)i, bytes);
+			__asm__ volatile("" ::: "memory");
+		}
+		double s = (double)(now_ns() - t0) / 1e9;
+		double gib = (double)bytes * (double)iters / (double)(1u << 30) / s;
+		if (gib > best)
+			best = gib;
+	}
+	return best;
+}
+
+static void row(const t_memops* v, int copy, size_t bytes, const char* nt)
+{
+	printf("%s,%s,%zu,%s,%.2f\n", copy ? "copy" : "set", v->name, bytes, nt,
+		   run_cell(v, copy, bytes));
+	fflush(stdout);
+}
+
+int main(void)
+{
+	g_src = mmap(NULL, MAX_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	g_dst = mmap(NULL, MAX_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (g_src == MAP_FAILED || g_dst == MAP_FAILED) {
+		perror("mmap");
+		return 1;
+	}
+	memset(g_src, 0x5a, MAX_BYTES); /* fault everything in before timing */
+	memset(g_dst, 0xa5, MAX_BYTES);
+
+	size_t n;
+	const t_memops* all = ft_memops_available(&n);
+	size_t nt_default = (ft_memops_current(), g_memops_nt_threshold);
+
+	fprintf(stderr, "# default variant %s, non-temporal from %zu bytes\n",
+			ft_memops_current()->name, nt_default);
+	printf("op,impl,bytes,nt,gib_per_s\n");
+	for (int copy = 1; copy >= 0; --copy) {
+		for (size_t s = 0; s < N_SIZES; ++s) {
+			size_t bytes = g_sizes[s];
+			row(&g_libc, copy, bytes, "-");
+			row(&g_byte, copy, bytes, "-");
+			for (size_t i = 0; i < n; ++i) {
+				g_memops_nt_threshold = SIZE_MAX;
+				row(&all[i], copy, bytes, "0");
+				if (i == 0 || bytes < NT_FROM)
+					continue; /* scalar never streams */
+				g_memops_nt_threshold = 0;
+				row(&all[i], copy, bytes, "1");
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,324 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   micro.c                                            :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/15 09:47:12 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/15 09:47:12 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+/* Allocator microbenchmarks: one cell per (block size, access pattern), every
+ * operation timed on its own (rdtsc on x86, clock_gettime elsewhere), and
+ * reported as ops/s and p50/p99/p99.9 latency.
+ *
+ *   micro                  run on the process's malloc, print one table
+ *   micro --lib <lib.so>   run twice (system malloc, then <lib.so> through
+ *                          LD_PRELOAD) and print both side by side
+ *
+ * Patterns, on batches of BATCH blocks:
+ *   lifo      allocate the batch, free it newest first
+ *   fifo      allocate the batch, free it oldest first
+ *   random    allocate the batch, free it in a random order
+ *   pingpong  malloc then free right away, one block at a time
+ *   realloc   malloc, grow to 2x, shrink back, free
+ *
+ * Timings and results live in mmap'd memory so the driver stays out of the
+ * allocator's way. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BATCH 512
+#define SMALL_OPS 200000 /* timed mallocs per cell up to 1 KiB */
+#define LARGE_OPS 20000	 /* ... above */
+#define MAX_OPS (SMALL_OPS * 2)
+
+static const size_t g_sizes[] = {16, 64, 128, 256, 512, 1024, 4096, 65536};
+#define N_SIZES (sizeof g_sizes / sizeof g_sizes[0])
+
+enum { P_LIFO, P_FIFO, P_RANDOM, P_PINGPONG, P_REALLOC, N_PATTERNS };
+static const char* const g_pattern_names[N_PATTERNS] = {"lifo", "fifo", "random", "pingpong",
+														"realloc"};
+
+enum { OP_MALLOC, OP_FREE, OP_REALLOC, N_OPS };
+static const char* const g_op_names[N_OPS] = {"malloc", "free", "realloc"};
+
+typedef struct s_result {
+	double ops_per_s;
+	double p50, p99, p999; /* ns */
+} t_result;
+
+/* latencies of the current cell, per op, in ticks */
+static uint64_t* g_lat[N_OPS];
+static size_t g_nlat[N_OPS];
+static double g_ns_per_tick = 1.0;
+
+/* ---------------- timing ---------------- */
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t ticks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#else
+	return now_ns();
+#endif
+}
+
+static void calibrate(void)
+{
+	uint64_t n0 = now_ns(), t0 = ticks();
+	struct timespec ts = {0, 50 * 1000 * 1000};
+	nanosleep(&ts, NULL);
+	uint64_t n1 = now_ns(), t1 = ticks();
+	if (t1 > t0)
+		g_ns_per_tick = (double)(n1 - n0) / (double)(t1 - t0);
+}
+
+static void* xmap(size_t bytes)
+{
+	void* p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED) {
+		perror("mmap");
+		exit(1);
+	}
+	return p;
+}
+
+#define TIMED(op, expr)                                                                            \
+	do {                                                                                           \
+		uint64_t t0_ = ticks();                                                                    \
+		expr;                                                                                      \
+		g_lat[op][g_nlat[op]++] = ticks() - t0_;                                                   \
+	} while (0)
+
+/* ---------------- patterns ---------------- */
+
+static uint64_t g_rng = 0x9e3779b97f4a7c15ull;
+
+static uint64_t rnd(void)
+{
+	g_rng ^= g_rng << 13;
+	g_rng ^= g_rng >> 7;
+	g_rng ^= g_rng << 17;
+	return g_rng;
+}
+
+static void run_batch(int pattern, size_t size, void** slots)
+{
+	size_t order[BATCH];
+
+	for (size_t i = 0; i < BATCH; ++i) {
+		TIMED(OP_MALLOC, slots[i] = malloc(size));
+		*(volatile char*)slots[i] = 1;
+	}
+	for (size_t i = 0; i < BATCH; ++i)
+		order[i] = (pattern == P_LIFO) ? BATCH - 1 - i : i;
+	if (pattern == P_RANDOM) {
+		for (size_t i = BATCH - 1; i > 0; --i) {
+			size_t j = (size_t)(rnd() % (i + 1));
+			size_t t = order[i];
+			order[i] = order[j];
+			order[j] = t;
+		}
+	}
+	for (size_t i = 0; i < BATCH; ++i)
+		TIMED(OP_FREE, free(slots[order[i]]));
+}
+
+static void run_pingpong(size_t size)
+{
+	for (size_t i = 0; i < BATCH; ++i) {
+		void* p;
+		TIMED(OP_MALLOC, p = malloc(size));
+		*(volatile char*)p = 1;
+		TIMED(OP_FREE, free(p));
+	}
+}
+
+static void run_realloc(size_t size)
+{
+	for (size_t i = 0; i < BATCH; ++i) {
+		void* p;
+		TIMED(OP_MALLOC, p = malloc(size));
+		*(volatile char*)p = 1;
+		TIMED(OP_REALLOC, p = realloc(p, size * 2));
+		((volatile char*)p)[size * 2 - 1] = 1;
+		TIMED(OP_REALLOC, p = realloc(p, size));
+		TIMED(OP_FREE, free(p));
+	}
+}
+
+/* ---------------- statistics ---------------- */
+
+static int cmp_u64(const void* a, const void* b)
+{
+	uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+	return (x > y) - (x < y);
+}
+
+/* sorts the samples in place; runs after the timed part */
+static t_result summarize(int op)
+{
+	t_result r = {0, 0, 0, 0};
+	size_t n = g_nlat[op];
+	if (!n)
+		return r;
+	uint64_t* v = g_lat[op];
+	uint64_t sum = 0;
+	for (size_t i = 0; i < n; ++i)
+		sum += v[i];
+	qsort(v, n, sizeof *v, cmp_u64);
+	r.ops_per_s = sum ? (double)n / ((double)sum * g_ns_per_tick / 1e9) : 0;
+	r.p50 = (double)v[n / 2] * g_ns_per_tick;
+	r.p99 = (double)v[n * 99 / 100] * g_ns_per_tick;
+	r.p999 = (double)v[n * 999 / 1000] * g_ns_per_tick;
+	return r;
+}
+
+/* results[size][pattern][op] */
+static void run_all(t_result res[N_SIZES][N_PATTERNS][N_OPS])
+{
+	void** slots = xmap(BATCH * sizeof(void*));
+	for (int op = 0; op < N_OPS; ++op)
+		g_lat[op] = xmap(MAX_OPS * sizeof(uint64_t));
+
+	for (size_t s = 0; s < N_SIZES; ++s) {
+		size_t size = g_sizes[s];
+		size_t rounds = ((size <= 1024) ? SMALL_OPS : LARGE_OPS) / BATCH;
+		for (int p = 0; p < N_PATTERNS; ++p) {
+			/* warm-up round, not recorded */
+			for (int op = 0; op < N_OPS; ++op)
+				g_nlat[op] = 0;
+			if (p == P_PINGPONG)
+				run_pingpong(size);
+			else if (p == P_REALLOC)
+				run_realloc(size);
+			else
+				run_batch(p, size, slots);
+
+			for (int op = 0; op < N_OPS; ++op)
+				g_nlat[op] = 0;
+			for (size_t r = 0; r < rounds; ++r) {
+				if (p == P_PINGPONG)
+					run_pingpong(size);
+				else if (p == P_REALLOC)
+					run_realloc(size);
+				else
+					run_batch(p, size, slots);
+			}
+			for (int op = 0; op < N_OPS; ++op)
+				res[s][p][op] = summarize(op);
+		}
+	}
+}
+
+/* ---------------- output ---------------- */
+
+static void print_one(const t_result* r)
+{
+	printf(" %12.0f %7.0f %7.0f %8.0f", r->ops_per_s, r->p50, r->p99, r->p999);
+}
+
+static void print_table(t_result a[N_SIZES][N_PATTERNS][N_OPS], const char* la,
+						t_result b[N_SIZES][N_PATTERNS][N_OPS], const char* lb)
+{
+	printf("%-8s %-9s %-8s %38s", "size", "pattern", "op", la);
+	if (b)
+		printf(" | %38s | %7s", lb, "speedup");
+	printf("\n%-8s %-9s %-8s %12s %7s %7s %8s", "", "", "", "ops/s", "p50", "p99", "p99.9");
+	if (b)
+		printf(" | %12s %7s %7s %8s |", "ops/s", "p50", "p99", "p99.9");
+	printf("\n");
+	for (size_t s = 0; s < N_SIZES; ++s)
+		for (int p = 0; p < N_PATTERNS; ++p)
+			for (int op = 0; op < N_OPS; ++op) {
+				if (a[s][p][op].ops_per_s == 0)
+					continue;
+				printf("%-8zu %-9s %-8s", g_sizes[s], g_pattern_names[p], g_op_names[op]);
+				print_one(&a[s][p][op]);
+				if (b) {
+					printf(" |");
+					print_one(&b[s][p][op]);
+					printf(" | %6.2fx", b[s][p][op].ops_per_s / a[s][p][op].ops_per_s);
+				}
+				printf("\n");
+			}
+	printf("latencies in ns\n");
+}
+
+/* run "<self> --raw" (optionally preloading 'lib') and read its results */
+static int run_child(const char* self, const char* lib, t_result res[N_SIZES][N_PATTERNS][N_OPS])
+{
+	int fds[2];
+	if (pipe(fds) != 0)
+		return -1;
+	pid_t pid = fork();
+	if (pid == 0) {
+		dup2(fds[1], 1);
+		close(fds[0]);
+		close(fds[1]);
+		if (lib)
+			setenv("LD_PRELOAD", lib, 1);
+		else
+			unsetenv("LD_PRELOAD");
+		execl(self, self, "--raw", (char*)NULL);
+		_exit(127);
+	}
+	close(fds[1]);
+	size_t want = sizeof(t_result) * N_SIZES * N_PATTERNS * N_OPS, got = 0;
+	while (got < want) {
+		ssize_t n = read(fds[0], (char*)res + got, want - got);
+		if (n <= 0)
+			break;
+		got += (size_t)n;
+	}
+	close(fds[0]);
+	int st = 0;
+	waitpid(pid, &st, 0);
+	return (got == want && WIFEXITED(st) && WEXITSTATUS(st) == 0) ? 0 : -1;
+}
+
+int main(int argc, char** argv)
+{
+	static t_result a[N_SIZES][N_PATTERNS][N_OPS];
+	static t_result b[N_SIZES][N_PATTERNS][N_OPS];
+
+	if (argc == 2 && strcmp(argv[1], "--raw") == 0) {
+		calibrate();
+		run_all(a);
+		return write(1, a, sizeof a) == (ssize_t)sizeof a ? 0 : 1;
+	}
+	if (argc == 3 && strcmp(argv[1], "--lib") == 0) {
+		if (run_child("/proc/self/exe", NULL, a) != 0 ||
+			run_child("/proc/self/exe", argv[2], b) != 0) {
+			fprintf(stderr, "micro: a benchmark run failed\n");
+			return 1;
+		}
+		print_table(a, "system malloc", b, argv[2]);
+		return 0;
+	}
+	if (argc != 1) {
+		fprintf(stderr, "usage: %s [--lib <malloc.so>]\n", argv[0]);
+		return 2;
+	}
+	calibrate();
+	run_all(a);
+	print_table(a, "this process's malloc", NULL, NULL);
+	return 0;
+}
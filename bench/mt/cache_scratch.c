@@ -0,0 +1,54 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   cache_scratch.c                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/16 10:02:41 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/16 10:02:41 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+/* Hoard's cache-scratch: passive false sharing. The main thread allocates one
+ * small block per worker back to back (likely on the same cache lines) and
+ * hands them out; each worker frees its block, then repeatedly mallocs an
+ * OBJ_SIZE block, writes it WRITES times and frees it. An allocator that
+ * gives the freed neighbour slots back to their new owners makes the workers
+ * fight over the same lines and the curve goes flat.
+ * One op = one byte-write pass over the block. */
+
+#include "mt.h"
+
+#define ITERATIONS 20000
+#define WRITES 50
+#define OBJ_SIZE 8
+
+static void* g_seed[MT_MAX_THREADS];
+
+static void setup(int n)
+{
+	for (int t = 0; t < n; ++t)
+		g_seed[t] = malloc(OBJ_SIZE);
+}
+
+static uint64_t run(int id, int n)
+{
+	(void)n;
+	free(g_seed[id]);
+
+	for (int it = 0; it < ITERATIONS; ++it) {
+		volatile char* p = malloc(OBJ_SIZE);
+		for (int w = 0; w < WRITES; ++w)
+			for (int i = 0; i < OBJ_SIZE; ++i)
+				p[i] = (char)(p[i] + 1);
+		free((void*)p);
+	}
+	return (uint64_t)ITERATIONS * WRITES;
+}
+
+int main(int argc, char** argv)
+{
+	static const t_mt_bench b = {"cache_scratch", setup, run, NULL};
+	return mt_main(&b, argc, argv);
+}
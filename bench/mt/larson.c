@@ -0,0 +1,79 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   larson.c                                           :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/16 10:02:41 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/16 10:02:41 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+/* Larson & Krishnan server simulation. Every thread owns a table of SLOTS
+ * live blocks of random sizes and, for OPS_PER_EPOCH steps, frees a random
+ * slot and refills it with a new random size. After each epoch the tables
+ * rotate one thread over, as if each connection moved to another worker:
+ * from then on a thread frees blocks another thread allocated.
+ * One op = one free + one malloc. */
+
+#include "mt.h"
+
+#define SLOTS 1000
+#define EPOCHS 8
+#define OPS_PER_EPOCH 20000
+#define MIN_SIZE 16
+#define MAX_SIZE 512
+
+static void** g_tables[MT_MAX_THREADS];
+static pthread_barrier_t g_epoch;
+
+static size_t rnd_size(uint64_t* s)
+{
+	return MIN_SIZE + (size_t)(mt_rnd(s) % (MAX_SIZE - MIN_SIZE + 1));
+}
+
+static void setup(int n)
+{
+	uint64_t s = 0x2545f4914f6cdd1dull;
+	for (int t = 0; t < n; ++t) {
+		g_tables[t] = mt_map(SLOTS * sizeof(void*));
+		for (int i = 0; i < SLOTS; ++i)
+			g_tables[t][i] = malloc(rnd_size(&s));
+	}
+	pthread_barrier_init(&g_epoch, NULL, (unsigned)n);
+}
+
+static uint64_t run(int id, int n)
+{
+	uint64_t s = 0x9e3779b97f4a7c15ull * (uint64_t)(id + 1);
+
+	for (int e = 0; e < EPOCHS; ++e) {
+		void** tab = g_tables[(id + e) % n];
+		for (int i = 0; i < OPS_PER_EPOCH; ++i) {
+			size_t k = (size_t)(mt_rnd(&s) % SLOTS);
+			size_t sz = rnd_size(&s);
+			free(tab[k]);
+			tab[k] = malloc(sz);
+			*(volatile char*)tab[k] = (char)sz;
+		}
+		pthread_barrier_wait(&g_epoch);
+	}
+	return (uint64_t)EPOCHS * OPS_PER_EPOCH;
+}
+
+static void teardown(int n)
+{
+	for (int t = 0; t < n; ++t) {
+		for (int i = 0; i < SLOTS; ++i)
+			free(g_tables[t][i]);
+		munmap(g_tables[t], SLOTS * sizeof(void*));
+	}
+	pthread_barrier_destroy(&g_epoch);
+}
+
+int main(int argc, char** argv)
+{
+	static const t_mt_bench b = {"larson", setup, run, teardown};
+	return mt_main(&b, argc, argv);
+}
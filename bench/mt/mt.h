@@ -0,0 +1,154 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   mt.h                                               :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/16 10:02:41 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/16 10:02:41 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef BENCH_MT_H
+#define BENCH_MT_H
+
+/* Shared driver of the multithreaded benchmarks (one program per benchmark).
+ *
+ *   <bench> [max_threads]
+ *
+ * runs the benchmark with 1, 2, ..., max_threads threads (default: online
+ * CPUs, at most 16) and prints one CSV row per run:
+ *
+ *   bench,allocator,threads,ops,seconds,ops_per_sec
+ *
+ * 'allocator' is "ft_malloc" when the process runs on this library (found
+ * through dlsym, so LD_PRELOAD counts) and "system" otherwise. Work is fixed
+ * per thread, so perfect scaling shows as ops_per_sec growing linearly.
+ * Each run: setup(n) on the main thread, n workers started together on a
+ * barrier, the clock runs from the barrier to the last join, then
+ * teardown(n). Everything the harness needs itself is mmap'd. */
+
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MT_MAX_THREADS 64
+
+typedef struct s_mt_bench {
+	const char* name;
+	void (*setup)(int nthreads);				/* may be NULL */
+	uint64_t (*run)(int id, int nthreads);		/* returns the ops done */
+	void (*teardown)(int nthreads);				/* may be NULL */
+} t_mt_bench;
+
+typedef struct s_mt_worker {
+	const t_mt_bench* bench;
+	pthread_barrier_t* start;
+	int id;
+	int nthreads;
+	uint64_t ops;
+} t_mt_worker;
+
+static inline uint64_t mt_now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline void* mt_map(size_t bytes)
+{
+	void* p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED) {
+		perror("mmap");
+		exit(1);
+	}
+	return p;
+}
+
+/* xorshift64, one state per thread */
+static inline uint64_t mt_rnd(uint64_t* s)
+{
+	*s ^= *s << 13;
+	*s ^= *s >> 7;
+	*s ^= *s << 17;
+	return *s;
+}
+
+static inline const char* mt_allocator(void)
+{
+	return dlsym(RTLD_DEFAULT, "ft_malloc_stats") ? "ft_malloc" : "system";
+}
+
+static void* mt_worker_main(void* arg)
+{
+	t_mt_worker* w = (t_mt_worker*)arg;
+	pthread_barrier_wait(w->start);
+	w->ops = w->bench->run(w->id, w->nthreads);
+	return NULL;
+}
+
+static int mt_run_once(const t_mt_bench* b, int n)
+{
+	pthread_t th[MT_MAX_THREADS];
+	t_mt_worker w[MT_MAX_THREADS];
+	pthread_barrier_t start;
+
+	if (b->setup)
+		b->setup(n);
+	pthread_barrier_init(&start, NULL, (unsigned)n + 1);
+	for (int i = 0; i < n; ++i) {
+		w[i] = (t_mt_worker){b, &start, i, n, 0};
+		if (pthread_create(&th[i], NULL, mt_worker_main, &w[i]) != 0) {
+			fprintf(stderr, "%s: pthread_create failed\n", b->name);
+			return -1;
+		}
+	}
+	pthread_barrier_wait(&start);
+	uint64_t t0 = mt_now_ns();
+	uint64_t ops = 0;
+	for (int i = 0; i < n; ++i) {
+		pthread_join(th[i], NULL);
+		ops += w[i].ops;
+	}
+	double secs = (double)(mt_now_ns() - t0) / 1e9;
+	pthread_barrier_destroy(&start);
+	if (b->teardown)
+		b->teardown(n);
+
+	printf("%s,%s,%d,%llu,%.6f,%.0f\n", b->name, mt_allocator(), n, (unsigned long long)ops, secs,
+		   secs > 0 ? (double)ops / secs : 0.0);
+	fflush(stdout);
+	return 0;
+}
+
+static inline int mt_main(const t_mt_bench* b, int argc, char** argv)
+{
+	long max = sysconf(_SC_NPROCESSORS_ONLN);
+	if (max > 16)
+		max = 16;
+	if (argc == 2)
+		max = strtol(argv[1], NULL, 10);
+	else if (argc != 1) {
+		fprintf(stderr, "usage: %s [max_threads]\n", argv[0]);
+		return 2;
+	}
+	if (max < 1 || max > MT_MAX_THREADS) {
+		fprintf(stderr, "%s: max_threads must be in 1..%d\n", argv[0], MT_MAX_THREADS);
+		return 2;
+	}
+
+	printf("bench,allocator,threads,ops,seconds,ops_per_sec\n");
+	for (int n = 1; n <= (int)max; ++n)
+		if (mt_run_once(b, n) != 0)
+			return 1;
+	return 0;
+}
+
+#endif /* BENCH_MT_H */
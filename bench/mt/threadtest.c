@@ -0,0 +1,58 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   threadtest.c                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/16 10:02:41 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/16 10:02:41 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+/* Hoard's threadtest: every thread, ITERATIONS times, allocates OBJECTS
+ * blocks of OBJ_SIZE bytes, touches them, then frees them all. Nothing is
+ * shared, so an allocator that scales keeps the threads out of each other's
+ * way entirely. One op = one malloc + one free. */
+
+#include "mt.h"
+
+#define ITERATIONS 50
+#define OBJECTS 2000
+#define OBJ_SIZE 64
+
+static void** g_objs[MT_MAX_THREADS];
+
+static void setup(int n)
+{
+	for (int t = 0; t < n; ++t)
+		g_objs[t] = mt_map(OBJECTS * sizeof(void*));
+}
+
+static uint64_t run(int id, int n)
+{
+	(void)n;
+	void** objs = g_objs[id];
+
+	for (int it = 0; it < ITERATIONS; ++it) {
+		for (int i = 0; i < OBJECTS; ++i) {
+			objs[i] = malloc(OBJ_SIZE);
+			*(volatile char*)objs[i] = (char)i;
+		}
+		for (int i = 0; i < OBJECTS; ++i)
+			free(objs[i]);
+	}
+	return (uint64_t)ITERATIONS * OBJECTS;
+}
+
+static void teardown(int n)
+{
+	for (int t = 0; t < n; ++t)
+		munmap(g_objs[t], OBJECTS * sizeof(void*));
+}
+
+int main(int argc, char** argv)
+{
+	static const t_mt_bench b = {"threadtest", setup, run, teardown};
+	return mt_main(&b, argc, argv);
+}
@@ -0,0 +1,103 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   xmalloc.c                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/16 10:02:41 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/16 10:02:41 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+/* xmalloc-test style producer/consumer. The threads form a ring: thread i
+ * mallocs BLOCKS blocks and hands them to thread i+1 through a lock-free
+ * single-producer/single-consumer queue, while freeing what thread i-1 sends
+ * it. Every block is thus freed by a thread other than its allocator (with
+ * one thread, by itself). One op = one malloc + one (remote) free. */
+
+#include <sched.h>
+#include <stdatomic.h>
+
+#include "mt.h"
+
+#define BLOCKS 100000
+#define RING 1024 /* power of two */
+
+typedef struct s_queue {
+	_Alignas(64) _Atomic size_t head; /* consumer */
+	_Alignas(64) _Atomic size_t tail; /* producer */
+	void* slots[RING];
+} t_queue;
+
+static t_queue* g_queues; /* g_queues[i]: from thread i to thread i+1 */
+
+static int push(t_queue* q, void* p)
+{
+	size_t t = atomic_load_explicit(&q->tail, memory_order_relaxed);
+	if (t - atomic_load_explicit(&q->head, memory_order_acquire) == RING)
+		return 0;
+	q->slots[t & (RING - 1)] = p;
+	atomic_store_explicit(&q->tail, t + 1, memory_order_release);
+	return 1;
+}
+
+static void* pop(t_queue* q)
+{
+	size_t h = atomic_load_explicit(&q->head, memory_order_relaxed);
+	if (h == atomic_load_explicit(&q->tail, memory_order_acquire))
+		return NULL;
+	void* p = q->slots[h & (RING - 1)];
+	atomic_store_explicit(&q->head, h + 1, memory_order_release);
+	return p;
+}
+
+static void setup(int n)
+{
+	g_queues = mt_map((size_t)n * sizeof(t_queue));
+}
+
+static uint64_t run(int id, int n)
+{
+	t_queue* out = &g_queues[id];
+	t_queue* in = &g_queues[(id + n - 1) % n];
+	uint64_t s = 0x9e3779b97f4a7c15ull * (uint64_t)(id + 1);
+	size_t made = 0, freed = 0;
+	void* pending = NULL;
+
+	while (made < BLOCKS || freed < BLOCKS) {
+		int moved = 0;
+		if (made < BLOCKS) {
+			if (!pending) {
+				size_t sz = 16 + (size_t)(mt_rnd(&s) % 241);
+				pending = malloc(sz);
+				*(volatile char*)pending = (char)sz;
+			}
+			if (push(out, pending)) {
+				pending = NULL;
+				++made;
+				moved = 1;
+			}
+		}
+		void* p = pop(in);
+		if (p) {
+			free(p);
+			++freed;
+			moved = 1;
+		}
+		if (!moved)
+			sched_yield(); /* full or empty queue: let the neighbour run */
+	}
+	return BLOCKS;
+}
+
+static void teardown(int n)
+{
+	munmap(g_queues, (size_t)n * sizeof(t_queue));
+}
+
+int main(int argc, char** argv)
+{
+	static const t_mt_bench b = {"xmalloc", setup, run, teardown};
+	return mt_main(&b, argc, argv);
+}
@@ -0,0 +1,79 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   realloc_loop.c                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/19 14:06:40 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/19 14:06:40 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+/* Append-style growth: one buffer realloc'ed 'step' bytes bigger at a time,
+ * the way a string builder or a C vector grows, up to 'final' bytes.
+ *
+ *   realloc_loop [final_bytes]
+ *
+ * One CSV row per step size:
+ *   allocator,step,final_bytes,reallocs,moves,copied_bytes,seconds,ns_per_realloc
+ * moves counts the reallocs that returned a new address (each one copied the
+ * buffer, counted in copied_bytes). With geometric headroom moves grow with
+ * log(final); without it, with final / page size. */
+
+#include "malloc.h"
+
+#include <dlfcn.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_FINAL (64u << 20)
+
+static const size_t g_steps[] = {16, 256, 4096};
+#define N_STEPS (sizeof g_steps / sizeof g_steps[0])
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char** argv)
+{
+	size_t final = (argc > 1) ? (size_t)strtoull(argv[1], NULL, 0) : DEFAULT_FINAL;
+	const char* allocator = dlsym(RTLD_DEFAULT, "ft_malloc_stats") ? "ft_malloc" : "system";
+
+	printf("allocator,step,final_bytes,reallocs,moves,copied_bytes,seconds,ns_per_realloc\n");
+	for (size_t i = 0; i < N_STEPS; ++i) {
+		size_t step = g_steps[i];
+		size_t reallocs = 0;
+		size_t moves = 0;
+		size_t copied = 0;
+		unsigned char* p = NULL;
+
+		uint64_t t0 = now_ns();
+		for (size_t len = step; len <= final; len += step) {
+			unsigned char* np = realloc(p, len);
+			if (!np) {
+				fprintf(stderr, "realloc(%zu) failed\n", len);
+				return 1;
+			}
+			if (np != p && p) {
+				moves++;
+				copied += len - step;
+			}
+			p = np;
+			p[len - 1] = (unsigned char)len; /* touch the new tail, like an append */
+			reallocs++;
+		}
+		double s = (double)(now_ns() - t0) / 1e9;
+		free(p);
+		printf("%s,%zu,%zu,%zu,%zu,%zu,%.4f,%.1f\n", allocator, step, final, reallocs, moves, copied,
+			   s, s * 1e9 / (double)reallocs);
+		fflush(stdout);
+	}
+	return 0;
+}
@@ -0,0 +1,467 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   replay.c                                           :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/14 10:03:29 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/14 10:03:29 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+/* Replay an allocation trace (lib/trace/trace_format.h) against whatever
+ * malloc the process runs on: glibc when started plainly, ft_malloc under
+ * LD_PRELOAD (see `make replay TRACE=...`).
+ *
+ * Every traced thread gets a replay thread. Records are put back in global
+ * tsc order and each one waits for its turn, so the exact interleaving of the
+ * recording is reproduced (and replay is serialized, by design). Old
+ * addresses are mapped to the new blocks through a hash table that, like all
+ * of the driver's own bookkeeping, lives in mmap'd memory so the allocator
+ * under test only sees the traced calls. Allocated pages are touched (outside
+ * the timed region) so RSS reflects a program that uses its memory.
+ *
+ * A realloc is recorded in two halves. Its FT_TRACE_REALLOC record only takes
+ * the old block out of the map, as the recording released it then; the call
+ * is replayed at its FT_TRACE_REALLOC_RET record, where the result is known. */
+
+#include "malloc.h"
+#include "trace/trace_format.h"
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_THREADS 256
+#define MAPS_SAMPLE_EVERY 65536 /* ops between /proc/self/maps samples */
+#define PAGE 4096
+
+typedef struct s_slot {
+	uint64_t old;
+	void* cur;
+} t_slot;
+
+typedef struct s_worker {
+	pthread_t th;
+	uint32_t tid;
+	size_t* idx; /* its records, in global order */
+	size_t n;
+	int holding; /* between the two halves of a realloc */
+	void* held;	 /* the block it is reallocating */
+} t_worker;
+
+static struct {
+	t_trace_rec* recs;
+	size_t n;
+	uint32_t* lat_ns;
+	t_slot* map;
+	size_t map_cap;
+	size_t turn;
+	size_t skipped;
+	size_t peak_maps;
+	size_t peak_hblks; /* glibc only: mmap'd chunks, from mallinfo2 */
+	int touch;
+} g;
+
+/* ---------------- driver memory (never from malloc) ---------------- */
+
+static void* xmap(size_t bytes)
+{
+	void* p = mmap(NULL, bytes ? bytes : 1, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+				   -1, 0);
+	if (p == MAP_FAILED) {
+		perror("mmap");
+		exit(1);
+	}
+	return p;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* ---------------- trace loading ---------------- */
+
+static void load_trace(const char* path)
+{
+	int fd = open(path, O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0) {
+		perror(path);
+		exit(1);
+	}
+	t_trace_file_header hdr;
+	if (read(fd, &hdr, sizeof hdr) != (ssize_t)sizeof hdr ||
+		memcmp(hdr.magic, FT_TRACE_MAGIC, 8) != 0 || hdr.version != FT_TRACE_VERSION ||
+		hdr.record_size != sizeof(t_trace_rec)) {
+		fprintf(stderr, "%s: not a version %d allocation trace\n", path, FT_TRACE_VERSION);
+		exit(1);
+	}
+	/* a trace cut short has n_records == 0: go by the file size */
+	size_t avail = ((size_t)st.st_size - sizeof hdr) / sizeof(t_trace_rec);
+	g.n = (hdr.n_records && hdr.n_records < avail) ? hdr.n_records : avail;
+	g.recs = xmap(g.n * sizeof(t_trace_rec));
+	size_t want = g.n * sizeof(t_trace_rec), got = 0;
+	while (got < want) {
+		ssize_t r = read(fd, (char*)g.recs + got, want - got);
+		if (r <= 0)
+			break;
+		got += (size_t)r;
+	}
+	g.n = got / sizeof(t_trace_rec);
+	close(fd);
+	if (hdr.n_dropped)
+		fprintf(stderr, "warning: %llu events were dropped while recording\n",
+				(unsigned long long)hdr.n_dropped);
+}
+
+/* stable bottom-up merge sort by tsc: per-thread order is kept on ties */
+static void sort_by_tsc(void)
+{
+	t_trace_rec* a = g.recs;
+	t_trace_rec* b = xmap(g.n * sizeof(*b));
+	for (size_t w = 1; w < g.n; w *= 2) {
+		for (size_t lo = 0; lo < g.n; lo += 2 * w) {
+			size_t mid = (lo + w < g.n) ? lo + w : g.n;
+			size_t hi = (lo + 2 * w < g.n) ? lo + 2 * w : g.n;
+			size_t i = lo, j = mid, k = lo;
+			while (i < mid && j < hi)
+				b[k++] = (a[j].tsc < a[i].tsc) ? a[j++] : a[i++];
+			while (i < mid)
+				b[k++] = a[i++];
+			while (j < hi)
+				b[k++] = a[j++];
+		}
+		t_trace_rec* t = a;
+		a = b;
+		b = t;
+	}
+	if (a != g.recs)
+		memcpy(g.recs, a, g.n * sizeof(*a));
+	munmap(a != g.recs ? a : b, g.n * sizeof(*a));
+}
+
+/* ---------------- address map ---------------- */
+
+static size_t map_home(uint64_t old)
+{
+	uint64_t h = old >> 4;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33;
+	return (size_t)h & (g.map_cap - 1);
+}
+
+static t_slot* map_find(uint64_t old)
+{
+	for (size_t i = map_home(old);; i = (i + 1) & (g.map_cap - 1))
+		if (g.map[i].old == old || g.map[i].old == 0)
+			return &g.map[i];
+}
+
+static void map_put(uint64_t old, void* cur)
+{
+	t_slot* d = map_find(old);
+	d->old = old;
+	d->cur = cur;
+}
+
+static void map_del(t_slot* s)
+{
+	size_t mask = g.map_cap - 1;
+	size_t i = (size_t)(s - g.map);
+	for (size_t j = (i + 1) & mask; g.map[j].old; j = (j + 1) & mask) {
+		size_t home = map_home(g.map[j].old);
+		if (i <= j ? (home <= i || home > j) : (home <= i && home > j)) {
+			g.map[i] = g.map[j];
+			i = j;
+		}
+	}
+	g.map[i].old = 0;
+}
+
+/* ---------------- replay ---------------- */
+
+static void touch_pages(void* p, size_t n)
+{
+	if (!g.touch || !p)
+		return;
+	for (size_t off = 0; off < n; off += PAGE)
+		((volatile char*)p)[off] = 1;
+	if (n)
+		((volatile char*)p)[n - 1] = 1;
+}
+
+/* glibc's struct mallinfo2 (its <malloc.h> is shadowed by ours) */
+typedef struct s_mallinfo2 {
+	size_t arena, ordblks, smblks, hblks, hblkhd, usmblks, fsmblks, uordblks, fordblks, keepcost;
+} t_mallinfo2;
+
+/* glibc does not count its mmap calls; the number of mmap'd chunks alive
+ * (mallinfo2 hblks) is the closest it reports. 0 without mallinfo2. */
+static size_t count_hblks(void)
+{
+	static t_mallinfo2 (*info)(void);
+	if (!info)
+		info = (t_mallinfo2(*)(void))dlsym(RTLD_DEFAULT, "mallinfo2");
+	return info ? info().hblks : 0;
+}
+
+static size_t count_maps(void)
+{
+	int fd = open("/proc/self/maps", O_RDONLY);
+	if (fd < 0)
+		return 0;
+	char buf[8192];
+	size_t lines = 0;
+	ssize_t r;
+	while ((r = read(fd, buf, sizeof buf)) > 0)
+		for (ssize_t i = 0; i < r; ++i)
+			lines += buf[i] == '\n';
+	close(fd);
+	return lines;
+}
+
+/* the release half of a realloc: the old block leaves the map */
+static void replay_realloc_release(t_worker* w, const t_trace_rec* r)
+{
+	t_slot* s = r->ptr ? map_find(r->ptr) : NULL;
+
+	/* an old block allocated before the trace started cannot be replayed */
+	w->holding = !s || s->old != 0;
+	w->held = (s && s->old) ? s->cur : NULL;
+	if (s && s->old)
+		map_del(s);
+}
+
+static void replay_one(t_worker* w, size_t i)
+{
+	const t_trace_rec* r = &g.recs[i];
+	t_slot* s = NULL;
+	void* in = NULL;
+	void* out = NULL;
+
+	if (r->op == FT_TRACE_REALLOC) {
+		replay_realloc_release(w, r);
+		return;
+	}
+	if (r->op == FT_TRACE_FREE) {
+		s = r->ptr ? map_find(r->ptr) : NULL;
+		if (s && s->old == 0) {
+			/* allocated before the trace started */
+			g.skipped++;
+			return;
+		}
+		in = s ? s->cur : NULL;
+	} else if (r->op == FT_TRACE_REALLOC_RET) {
+		if (!w->holding) {
+			/* its release half was not replayed (or was dropped) */
+			g.skipped++;
+			return;
+		}
+		w->holding = 0;
+		in = w->held;
+		if (r->ret == 0 && r->size && r->ptr)
+			map_put(r->ptr, in); /* failed: the old block stays */
+	}
+	if (r->op != FT_TRACE_FREE && r->ret == 0 && r->size) {
+		g.skipped++; /* failed in the recording */
+		return;
+	}
+
+	uint64_t t0 = now_ns();
+	switch (r->op) {
+	case FT_TRACE_MALLOC:
+		out = malloc(r->size);
+		break;
+	case FT_TRACE_ALIGNED_ALLOC:
+		out = aligned_alloc((size_t)1 << r->align_log2, r->size);
+		break;
+	case FT_TRACE_REALLOC_RET:
+		out = realloc(in, r->size);
+		break;
+	case FT_TRACE_FREE:
+		free(in);
+		break;
+	default:
+		g.skipped++;
+		return;
+	}
+	uint64_t dt = now_ns() - t0;
+	g.lat_ns[i] = dt > UINT32_MAX ? UINT32_MAX : (uint32_t)dt;
+
+	if (s && s->old)
+		map_del(s);
+	if (out && r->ret) {
+		map_put(r->ret, out);
+		touch_pages(out, r->size);
+	}
+	if (i % MAPS_SAMPLE_EVERY == 0) {
+		size_t m = count_maps();
+		if (m > g.peak_maps)
+			g.peak_maps = m;
+		m = count_hblks();
+		if (m > g.peak_hblks)
+			g.peak_hblks = m;
+	}
+}
+
+static void* worker_main(void* arg)
+{
+	t_worker* w = (t_worker*)arg;
+	for (size_t k = 0; k < w->n; ++k) {
+		size_t i = w->idx[k];
+		for (unsigned spins = 0; __atomic_load_n(&g.turn, __ATOMIC_ACQUIRE) != i; ++spins)
+			if (spins > 64)
+				sched_yield();
+		replay_one(w, i);
+		__atomic_store_n(&g.turn, i + 1, __ATOMIC_RELEASE);
+	}
+	return NULL;
+}
+
+/* ---------------- report ---------------- */
+
+static int cmp_u32(const void* a, const void* b)
+{
+	uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+	return (x > y) - (x < y);
+}
+
+static void report_op(const char* name, int op, uint32_t* tmp)
+{
+	size_t n = 0;
+	for (size_t i = 0; i < g.n; ++i)
+		if (g.recs[i].op == op && g.lat_ns[i] != UINT32_MAX)
+			tmp[n++] = g.lat_ns[i];
+	if (!n)
+		return;
+	qsort(tmp, n, sizeof *tmp, cmp_u32);
+	printf("%-14s %10zu %8u %8u %8u %8u %10u\n", name, n, tmp[n / 2], tmp[n * 90 / 100],
+		   tmp[n * 99 / 100], tmp[n * 999 / 1000], tmp[n - 1]);
+}
+
+static size_t rss_kb(void)
+{
+	FILE* f = fopen("/proc/self/statm", "r");
+	unsigned long size = 0, res = 0;
+	if (f) {
+		if (fscanf(f, "%lu %lu", &size, &res) != 2)
+			res = 0;
+		fclose(f);
+	}
+	return (size_t)res * ((size_t)sysconf(_SC_PAGESIZE) / 1024);
+}
+
+int main(int argc, char** argv)
+{
+	int argi = 1;
+	g.touch = 1;
+	if (argi < argc && strcmp(argv[argi], "--no-touch") == 0) {
+		g.touch = 0;
+		argi++;
+	}
+	if (argi + 1 != argc) {
+		fprintf(stderr, "usage: %s [--no-touch] <trace file>\n", argv[0]);
+		return 2;
+	}
+
+	load_trace(argv[argi]);
+	sort_by_tsc();
+
+	g.map_cap = 1024;
+	while (g.map_cap < g.n * 2)
+		g.map_cap *= 2;
+	g.map = xmap(g.map_cap * sizeof(t_slot));
+	g.lat_ns = xmap(g.n * sizeof(uint32_t));
+	memset(g.lat_ns, 0xff, g.n * sizeof(uint32_t)); /* UINT32_MAX: not replayed */
+
+	/* one worker per traced thread, each with its records in global order */
+	static t_worker workers[MAX_THREADS];
+	size_t nw = 0;
+	size_t* owner = xmap(g.n * sizeof(size_t));
+	for (size_t i = 0; i < g.n; ++i) {
+		size_t w = 0;
+		while (w < nw && workers[w].tid != g.recs[i].tid)
+			++w;
+		if (w == nw) {
+			if (nw == MAX_THREADS) {
+				fprintf(stderr, "more than %d threads in trace\n", MAX_THREADS);
+				return 1;
+			}
+			workers[nw++].tid = g.recs[i].tid;
+		}
+		owner[i] = w;
+		workers[w].n++;
+	}
+	for (size_t w = 0; w < nw; ++w) {
+		workers[w].idx = xmap(workers[w].n * sizeof(size_t));
+		workers[w].n = 0;
+	}
+	for (size_t i = 0; i < g.n; ++i) {
+		t_worker* w = &workers[owner[i]];
+		w->idx[w->n++] = i;
+	}
+
+	void (*stats)(ft_malloc_stats_t*) =
+		(void (*)(ft_malloc_stats_t*))dlsym(RTLD_DEFAULT, "ft_malloc_stats");
+	ft_malloc_stats_t before = {0}, after = {0};
+	if (stats)
+		stats(&before);
+	size_t base_rss = rss_kb();
+	g.peak_maps = count_maps();
+	g.peak_hblks = count_hblks();
+
+	uint64_t t0 = now_ns();
+	for (size_t w = 0; w < nw; ++w)
+		pthread_create(&workers[w].th, NULL, worker_main, &workers[w]);
+	for (size_t w = 0; w < nw; ++w)
+		pthread_join(workers[w].th, NULL);
+	uint64_t wall = now_ns() - t0;
+
+	struct rusage ru;
+	getrusage(RUSAGE_SELF, &ru);
+	if (stats)
+		stats(&after);
+	size_t end_maps = count_maps();
+	if (end_maps > g.peak_maps)
+		g.peak_maps = end_maps;
+	size_t end_hblks = count_hblks();
+	if (end_hblks > g.peak_hblks)
+		g.peak_hblks = end_hblks;
+
+	printf("allocator      %s\n", stats ? "ft_malloc" : "system");
+	printf("records        %zu (%zu threads, %zu skipped)\n", g.n, nw, g.skipped);
+	printf("total time     %.3f ms (includes turn waits and page touching)\n", (double)wall / 1e6);
+	printf("%-14s %10s %8s %8s %8s %8s %10s\n", "op (ns)", "count", "p50", "p90", "p99", "p99.9",
+		   "max");
+	uint32_t* tmp = xmap(g.n * sizeof(uint32_t));
+	report_op("malloc", FT_TRACE_MALLOC, tmp);
+	report_op("free", FT_TRACE_FREE, tmp);
+	report_op("realloc", FT_TRACE_REALLOC_RET, tmp);
+	report_op("aligned_alloc", FT_TRACE_ALIGNED_ALLOC, tmp);
+	printf("peak RSS       %ld KiB (%zu KiB before replay)\n", ru.ru_maxrss, base_rss);
+	printf("peak mappings  %zu (sampled from /proc/self/maps)\n", g.peak_maps);
+	if (stats)
+		printf("mmap calls     %llu (munmap %llu)\n",
+			   (unsigned long long)(after.n_mmap - before.n_mmap),
+			   (unsigned long long)(after.n_munmap - before.n_munmap));
+	else
+		printf("mmap'd chunks  peak %zu, %zu at end (mallinfo2 hblks; glibc keeps no mmap call "
+			   "count)\n",
+			   g.peak_hblks, end_hblks);
+	return 0;
+}
@@ -0,0 +1,102 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   sizetune.c                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/19 17:02:47 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/19 17:02:47 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+/* Bin sizes for a recorded workload (lib/sizehist/sizetune.c, linked in).
+ *
+ *   sizetune <histogram> [tiny small]
+ *
+ * <histogram> is a file written with FT_MALLOC_SIZEHIST=<file>. Prints the
+ * rounding waste of the current bins (the defaults, or 'tiny small') and of
+ * the best pair, then the line to load the best pair with:
+ *
+ *   bins,tiny,small,waste_bytes,waste_per_request
+ *   FT_MALLOC_BINS=<tiny>,<small>
+ *
+ * Requests above FT_SIZEHIST_MAX are LARGE whatever the bins; they are
+ * counted in the header comment only. */
+
+#include "sizehist/sizehist.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define DEFAULT_TINY 128
+#define DEFAULT_SMALL 1024
+
+static char* read_file(const char* path, size_t* len)
+{
+	FILE* f = fopen(path, "rb");
+	if (!f)
+		return NULL;
+	size_t cap = 1 << 16;
+	char* buf = malloc(cap);
+	*len = 0;
+	for (size_t got; buf && (got = fread(buf + *len, 1, cap - *len, f)) > 0;) {
+		*len += got;
+		if (*len == cap)
+			buf = realloc(buf, cap *= 2);
+	}
+	fclose(f);
+	return buf;
+}
+
+static void row(const char* name, const ft_sizehist_t* h, uint64_t requests, size_t tiny,
+				size_t small, size_t page)
+{
+	uint64_t waste = ft_sizetune_waste(h, tiny, small, page);
+	printf("%s,%zu,%zu,%llu,%.1f\n", name, tiny, small, (unsigned long long)waste,
+		   (double)waste / (double)requests);
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 2 && argc != 4) {
+		fprintf(stderr, "usage: %s <histogram> [tiny small]\n", argv[0]);
+		return 2;
+	}
+	size_t tiny = (argc == 4) ? (size_t)strtoull(argv[2], NULL, 0) : DEFAULT_TINY;
+	size_t small = (argc == 4) ? (size_t)strtoull(argv[3], NULL, 0) : DEFAULT_SMALL;
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+
+	size_t len;
+	char* text = read_file(argv[1], &len);
+	if (!text) {
+		perror(argv[1]);
+		return 1;
+	}
+	static ft_sizehist_t h;
+	if (ft_sizehist_parse(text, len, &h)) {
+		fprintf(stderr, "%s: not a size histogram\n", argv[1]);
+		return 1;
+	}
+	free(text);
+
+	uint64_t fine = 0, coarse = 0;
+	for (size_t i = 0; i < FT_SIZEHIST_FINE; ++i)
+		fine += h.fine[i];
+	for (size_t e = 0; e < FT_SIZEHIST_COARSE; ++e)
+		coarse += h.coarse[e];
+
+	t_sizetune best;
+	if (ft_sizetune(&h, page, &best)) {
+		fprintf(stderr, "%s: no request up to %d bytes\n", argv[1], FT_SIZEHIST_MAX);
+		return 1;
+	}
+	printf("# %llu requests up to %d bytes, %llu above\n", (unsigned long long)fine,
+		   FT_SIZEHIST_MAX, (unsigned long long)coarse);
+	printf("bins,tiny,small,waste_bytes,waste_per_request\n");
+	row("current", &h, fine, tiny, small, page);
+	row("tuned", &h, fine, best.tiny, best.small, page);
+	printf("%s=%zu,%zu\n", FT_BINS_ENV, best.tiny, best.small);
+	return 0;
+}
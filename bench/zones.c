@@ -0,0 +1,228 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   zones.c                                            :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/17 09:12:30 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/17 09:12:30 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+/* Zone-count scalability: cost of one malloc, free and realloc on a heap that
+ * already holds 10, 1k, 100k and 1M live blocks of one class.
+ *
+ *   zones <libft_malloc.so> [max_live]
+ *
+ * The library is dlopen'ed and driven through its heap instances
+ * (ft_heap_create/alloc/dealloc/reallocate/destroy): one fresh heap per
+ * (class, live count), torn down right after, while the driver itself stays
+ * on the system allocator. For each level, SAMPLES random live blocks are
+ * freed and replaced (free, then malloc of the same size) and SAMPLES random
+ * live blocks are realloc'ed in place; every op is timed alone and the median
+ * is reported.
+ *
+ * Paths that walk the zone lists are O(zones), so per-op cost may grow
+ * linearly with the live count, no faster: between two levels the median may
+ * grow at most SLACK times the live-count ratio, otherwise the run fails.
+ * SLACK absorbs the cache and TLB misses of walking thousands of zone headers
+ * a page or more apart (about 5x per visited zone at 1M blocks), while a
+ * quadratic path (x100 for x10 blocks) still trips it.
+ * LARGE blocks are one mapping each, so their count is capped to half of
+ * vm.max_map_count. */
+
+#include "malloc.h"
+
+#include <dlfcn.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#define SAMPLES 301
+#define SLACK 8.0
+#define DEFAULT_MAX_LIVE 1000000
+
+static const size_t g_levels[] = {10, 1000, 100000, 1000000};
+#define N_LEVELS (sizeof g_levels / sizeof g_levels[0])
+
+/* one request size per class, on a default-config heap (bins 128 / 1024) */
+static const char* const g_class_names[] = {"TINY", "SMALL", "LARGE"};
+static const size_t g_class_sizes[] = {64, 512, 2048};
+#define N_CLASSES 3
+
+enum { OP_MALLOC, OP_FREE, OP_REALLOC, N_OPS };
+static const char* const g_op_names[N_OPS] = {"malloc", "free", "realloc"};
+
+static struct {
+	ft_heap_t* (*create)(const ft_heap_config_t*);
+	void* (*alloc)(ft_heap_t*, size_t);
+	void (*dealloc)(ft_heap_t*, void*);
+	void* (*reallocate)(ft_heap_t*, void*, size_t);
+	void (*destroy)(ft_heap_t*);
+	void (*stats)(const ft_heap_t*, ft_malloc_stats_t*);
+} g_lib;
+
+static uint64_t g_rng = 0x9e3779b97f4a7c15ull;
+
+static uint64_t rnd(void)
+{
+	g_rng ^= g_rng << 13;
+	g_rng ^= g_rng >> 7;
+	g_rng ^= g_rng << 17;
+	return g_rng;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int cmp_u64(const void* a, const void* b)
+{
+	uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+	return (x > y) - (x < y);
+}
+
+static uint64_t median(uint64_t* v, size_t n)
+{
+	qsort(v, n, sizeof *v, cmp_u64);
+	return v[n / 2];
+}
+
+static int load(const char* path)
+{
+	void* h = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+	if (!h) {
+		fprintf(stderr, "zones: %s\n", dlerror());
+		return -1;
+	}
+	*(void**)&g_lib.create = dlsym(h, "ft_heap_create");
+	*(void**)&g_lib.alloc = dlsym(h, "ft_heap_alloc");
+	*(void**)&g_lib.dealloc = dlsym(h, "ft_heap_dealloc");
+	*(void**)&g_lib.reallocate = dlsym(h, "ft_heap_reallocate");
+	*(void**)&g_lib.destroy = dlsym(h, "ft_heap_destroy");
+	*(void**)&g_lib.stats = dlsym(h, "ft_heap_stats");
+	if (!g_lib.create || !g_lib.alloc || !g_lib.dealloc || !g_lib.reallocate ||
+		!g_lib.destroy || !g_lib.stats) {
+		fprintf(stderr, "zones: %s lacks the ft_heap_* API\n", path);
+		return -1;
+	}
+	return 0;
+}
+
+static size_t max_map_count(void)
+{
+	FILE* f = fopen("/proc/sys/vm/max_map_count", "r");
+	unsigned long v = 65530;
+	if (f) {
+		if (fscanf(f, "%lu", &v) != 1)
+			v = 65530;
+		fclose(f);
+	}
+	return (size_t)v;
+}
+
+/* medians[op] in ns for one (class, live) level; returns the zone count */
+static long measure(int k, size_t live, uint64_t medians[N_OPS])
+{
+	static uint64_t lat[N_OPS][SAMPLES];
+	const size_t size = g_class_sizes[k];
+	void** blocks = mmap(NULL, live * sizeof(void*), PROT_READ | PROT_WRITE,
+						 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	ft_heap_t* h = g_lib.create(NULL);
+	if (blocks == MAP_FAILED || !h)
+		return -1;
+
+	for (size_t i = 0; i < live; ++i)
+		if (!(blocks[i] = g_lib.alloc(h, size)))
+			return -1;
+
+	for (size_t s = 0; s < SAMPLES; ++s) {
+		size_t i = (size_t)(rnd() % live);
+		uint64_t t0 = now_ns();
+		g_lib.dealloc(h, blocks[i]);
+		uint64_t t1 = now_ns();
+		blocks[i] = g_lib.alloc(h, size);
+		uint64_t t2 = now_ns();
+		lat[OP_FREE][s] = t1 - t0;
+		lat[OP_MALLOC][s] = t2 - t1;
+		if (!blocks[i])
+			return -1;
+
+		/* same bin: moves nothing, only the owner lookup and bookkeeping */
+		i = (size_t)(rnd() % live);
+		t0 = now_ns();
+		void* p = g_lib.reallocate(h, blocks[i], size - 8);
+		lat[OP_REALLOC][s] = now_ns() - t0;
+		if (!p)
+			return -1;
+		blocks[i] = p;
+	}
+
+	ft_malloc_stats_t st;
+	g_lib.stats(h, &st);
+	g_lib.destroy(h);
+	munmap(blocks, live * sizeof(void*));
+	for (int op = 0; op < N_OPS; ++op)
+		medians[op] = median(lat[op], SAMPLES);
+	return (long)st.classes[k].zones;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2 || argc > 3) {
+		fprintf(stderr, "usage: %s <libft_malloc.so> [max_live]\n", argv[0]);
+		return 2;
+	}
+	size_t max_live = (argc == 3) ? (size_t)strtoull(argv[2], NULL, 10) : DEFAULT_MAX_LIVE;
+	if (load(argv[1]) != 0)
+		return 1;
+
+	int failed = 0;
+	printf("%-6s %9s %7s %10s %10s %10s   (median ns per op)\n", "class", "live", "zones",
+		   g_op_names[OP_MALLOC], g_op_names[OP_FREE], g_op_names[OP_REALLOC]);
+	for (int k = 0; k < N_CLASSES; ++k) {
+		size_t cap = (k == 2) ? max_map_count() / 2 : max_live;
+		if (cap > max_live)
+			cap = max_live;
+		size_t prev_live = 0;
+		uint64_t prev[N_OPS] = {0};
+
+		for (size_t l = 0; l < N_LEVELS; ++l) {
+			size_t live = g_levels[l] < cap ? g_levels[l] : cap;
+			if (live <= prev_live)
+				break;
+			uint64_t med[N_OPS];
+			long zones = measure(k, live, med);
+			if (zones < 0) {
+				fprintf(stderr, "zones: allocation failed at %s x %zu\n", g_class_names[k], live);
+				return 1;
+			}
+			printf("%-6s %9zu %7ld %10llu %10llu %10llu", g_class_names[k], live, zones,
+				   (unsigned long long)med[OP_MALLOC], (unsigned long long)med[OP_FREE],
+				   (unsigned long long)med[OP_REALLOC]);
+			for (int op = 0; op < N_OPS && prev_live; ++op) {
+				double growth = (double)med[op] / (double)(prev[op] ? prev[op] : 1);
+				double bound = SLACK * (double)live / (double)prev_live;
+				if (growth > bound) {
+					printf("  SUPER-LINEAR %s: x%.1f for x%.0f blocks", g_op_names[op], growth,
+						   (double)live / (double)prev_live);
+					failed = 1;
+				}
+			}
+			printf("\n");
+			fflush(stdout);
+			prev_live = live;
+			memcpy(prev, med, sizeof prev);
+		}
+	}
+	if (failed)
+		fprintf(stderr, "zones: per-op cost grows faster than the live block count\n");
+	return failed;
+}
@@ -0,0 +1,173 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   new_delete.cpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/08 14:20:05 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/08 14:20:05 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+/* Replaceable operator new/delete routed to libft_malloc.
+ * - sized delete       -> free_sized: no search for LARGE, one class for slabs
+ * - std::align_val_t   -> aligned_alloc / free_aligned_sized: aligned slabs
+ * - nothrow            -> same paths, nullptr instead of std::bad_alloc
+ * The C entry points are resolved like any malloc symbol: link libft_malloc
+ * before libc or LD_PRELOAD it, as for the C API. */
+
+#include <cstddef>
+#include <new>
+
+#include "malloc.h"
+
+namespace {
+
+void* ft_new(std::size_t n)
+{
+	for (;;) {
+		if (void* p = malloc(n))
+			return p;
+		std::new_handler handler = std::get_new_handler();
+		if (!handler)
+			throw std::bad_alloc();
+		handler();
+	}
+}
+
+void* ft_new_aligned(std::size_t n, std::align_val_t al)
+{
+	for (;;) {
+		if (void* p = aligned_alloc(static_cast<std::size_t>(al), n))
+			return p;
+		std::new_handler handler = std::get_new_handler();
+		if (!handler)
+			throw std::bad_alloc();
+		handler();
+	}
+}
+
+void* ft_new_nothrow(std::size_t n) noexcept
+{
+	try {
+		return ft_new(n);
+	} catch (...) {
+		return nullptr;
+	}
+}
+
+void* ft_new_aligned_nothrow(std::size_t n, std::align_val_t al) noexcept
+{
+	try {
+		return ft_new_aligned(n, al);
+	} catch (...) {
+		return nullptr;
+	}
+}
+
+} // namespace
+
+/* ---- new ---- */
+
+FT_API void* operator new(std::size_t n)
+{
+	return ft_new(n);
+}
+
+FT_API void* operator new[](std::size_t n)
+{
+	return ft_new(n);
+}
+
+FT_API void* operator new(std::size_t n, const std::nothrow_t&) noexcept
+{
+	return ft_new_nothrow(n);
+}
+
+FT_API void* operator new[](std::size_t n, const std::nothrow_t&) noexcept
+{
+	return ft_new_nothrow(n);
+}
+
+FT_API void* operator new(std::size_t n, std::align_val_t al)
+{
+	return ft_new_aligned(n, al);
+}
+
+FT_API void* operator new[](std::size_t n, std::align_val_t al)
+{
+	return ft_new_aligned(n, al);
+}
+
+FT_API void* operator new(std::size_t n, std::align_val_t al, const std::nothrow_t&) noexcept
+{
+	return ft_new_aligned_nothrow(n, al);
+}
+
+FT_API void* operator new[](std::size_t n, std::align_val_t al, const std::nothrow_t&) noexcept
+{
+	return ft_new_aligned_nothrow(n, al);
+}
+
+/* ---- delete ---- */
+
+FT_API void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+FT_API void operator delete[](void* p) noexcept
+{
+	free(p);
+}
+
+FT_API void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+	free(p);
+}
+
+FT_API void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+	free(p);
+}
+
+FT_API void operator delete(void* p, std::size_t n) noexcept
+{
+	free_sized(p, n);
+}
+
+FT_API void operator delete[](void* p, std::size_t n) noexcept
+{
+	free_sized(p, n);
+}
+
+FT_API void operator delete(void* p, std::align_val_t) noexcept
+{
+	free(p);
+}
+
+FT_API void operator delete[](void* p, std::align_val_t) noexcept
+{
+	free(p);
+}
+
+FT_API void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	free(p);
+}
+
+FT_API void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	free(p);
+}
+
+FT_API void operator delete(void* p, std::size_t n, std::align_val_t al) noexcept
+{
+	free_aligned_sized(p, static_cast<std::size_t>(al), n);
+}
+
+FT_API void operator delete[](void* p, std::size_t n, std::align_val_t al) noexcept
+{
+	free_aligned_sized(p, static_cast<std::size_t>(al), n);
+}
@@ -0,0 +1,258 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ft_pool_allocator.hpp                              :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/09 09:41:33 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/09 09:41:33 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef FT_POOL_ALLOCATOR_HPP
+#define FT_POOL_ALLOCATOR_HPP
+
+/* STL front end for the fixed-size object pools (ft_pool_*).
+ *
+ * ft::pool_allocator<T>
+ *   Single-object allocations (every node of std::map/std::list/
+ *   std::unordered_map) come from one pool per (sizeof(T), alignof(T)), so
+ *   nodes of the same shape pack back to back in the same slab pages. Each
+ *   thread keeps a small cache per pool, refilled and drained in bulk, so the
+ *   pool lock is taken once per FT_POOL_CACHE_REFILL nodes. Arrays (n != 1,
+ *   bucket tables) and over-aligned types go to operator new.
+ *
+ * ft::pool_resource
+ *   std::pmr::memory_resource with one exact-fit pool per distinct block
+ *   size (up to FT_POOL_RESOURCE_SLOTS sizes <= FT_POOL_RESOURCE_MAX_SIZE),
+ *   everything else is forwarded upstream. Destroying the resource releases
+ *   all its pools at once. Like std::pmr::unsynchronized_pool_resource, one
+ *   resource must not be used by several threads without external locking.
+ */
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+
+#include "malloc.h"
+
+#ifndef FT_POOL_CACHE_SIZE
+#define FT_POOL_CACHE_SIZE 64
+#endif
+#define FT_POOL_CACHE_REFILL (FT_POOL_CACHE_SIZE / 2)
+
+#ifndef FT_POOL_RESOURCE_SLOTS
+#define FT_POOL_RESOURCE_SLOTS 8
+#endif
+#ifndef FT_POOL_RESOURCE_MAX_SIZE
+#define FT_POOL_RESOURCE_MAX_SIZE 1024
+#endif
+
+namespace ft {
+
+namespace detail {
+
+/* One process-wide pool per object shape, never destroyed: nodes may be freed
+ * by static destructors after main(). */
+template <std::size_t Size, std::size_t Align>
+ft_pool_t* shared_pool()
+{
+	static ft_pool_t* const pool = ft_pool_create(Size, Align);
+	return pool;
+}
+
+/* Per-thread magazine in front of a shared pool. */
+template <std::size_t Size, std::size_t Align>
+struct pool_cache {
+	void* slots[FT_POOL_CACHE_SIZE];
+	std::size_t n = 0;
+
+	/* Set once the thread's cache is destroyed. Trivially destructible and
+	 * apart from the cache, so later thread_local destructors that free
+	 * through the allocator still read it. */
+	static inline thread_local bool gone = false;
+
+	~pool_cache()
+	{
+		gone = true;
+		ft_pool_free_bulk(shared_pool<Size, Align>(), slots, n);
+		n = 0;
+	}
+
+	/* The thread's cache, or nullptr once it was destroyed. */
+	static pool_cache* local()
+	{
+		if (gone)
+			return nullptr;
+		thread_local pool_cache cache;
+		return &cache;
+	}
+
+	static void* pop()
+	{
+		ft_pool_t* pool = shared_pool<Size, Align>();
+		pool_cache* c = local();
+		if (!c)
+			return ft_pool_alloc(pool);
+		if (c->n == 0) {
+			// refill in ascending address order, hand out from the low end
+			void* fresh[FT_POOL_CACHE_REFILL];
+			std::size_t got = ft_pool_alloc_bulk(pool, fresh, FT_POOL_CACHE_REFILL);
+			while (got)
+				c->slots[c->n++] = fresh[--got];
+			if (c->n == 0)
+				return nullptr;
+		}
+		return c->slots[--c->n];
+	}
+
+	static void push(void* p)
+	{
+		ft_pool_t* pool = shared_pool<Size, Align>();
+		pool_cache* c = local();
+		if (!c) {
+			ft_pool_free(pool, p);
+			return;
+		}
+		if (c->n == FT_POOL_CACHE_SIZE) {
+			ft_pool_free_bulk(pool, c->slots + FT_POOL_CACHE_REFILL, FT_POOL_CACHE_REFILL);
+			c->n = FT_POOL_CACHE_REFILL;
+		}
+		c->slots[c->n++] = p;
+	}
+};
+
+} // namespace detail
+
+template <class T>
+class pool_allocator {
+  public:
+	using value_type = T;
+
+	pool_allocator() noexcept = default;
+	template <class U>
+	pool_allocator(const pool_allocator<U>&) noexcept
+	{
+	}
+
+	T* allocate(std::size_t n)
+	{
+		if (n == 1 && pooled) {
+			if (void* p = cache::pop())
+				return static_cast<T*>(p);
+			throw std::bad_alloc();
+		}
+		if (n > static_cast<std::size_t>(-1) / sizeof(T))
+			throw std::bad_alloc();
+		return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+	}
+
+	void deallocate(T* p, std::size_t n) noexcept
+	{
+		if (n == 1 && pooled) {
+			cache::push(p);
+			return;
+		}
+		::operator delete(p, n * sizeof(T), std::align_val_t(alignof(T)));
+	}
+
+  private:
+	using cache = detail::pool_cache<sizeof(T), alignof(T)>;
+	static constexpr bool pooled = alignof(T) <= 16;
+};
+
+template <class T, class U>
+bool operator==(const pool_allocator<T>&, const pool_allocator<U>&) noexcept
+{
+	return true;
+}
+
+template <class T, class U>
+bool operator!=(const pool_allocator<T>&, const pool_allocator<U>&) noexcept
+{
+	return false;
+}
+
+class pool_resource : public std::pmr::memory_resource {
+  public:
+	explicit pool_resource(
+		std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) noexcept
+		: upstream_(upstream)
+	{
+	}
+
+	pool_resource(const pool_resource&) = delete;
+	pool_resource& operator=(const pool_resource&) = delete;
+
+	~pool_resource() override
+	{
+		for (slot& s : slots_)
+			ft_pool_destroy(s.pool);
+	}
+
+	std::pmr::memory_resource* upstream_resource() const noexcept
+	{
+		return upstream_;
+	}
+
+  protected:
+	void* do_allocate(std::size_t bytes, std::size_t align) override
+	{
+		if (ft_pool_t* pool = pool_for(bytes, align, true)) {
+			if (void* p = ft_pool_alloc(pool))
+				return p;
+			throw std::bad_alloc();
+		}
+		return upstream_->allocate(bytes, align);
+	}
+
+	void do_deallocate(void* p, std::size_t bytes, std::size_t align) override
+	{
+		if (ft_pool_t* pool = pool_for(bytes, align, false)) {
+			ft_pool_free(pool, p);
+			return;
+		}
+		upstream_->deallocate(p, bytes, align);
+	}
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+	{
+		return this == &other;
+	}
+
+  private:
+	struct slot {
+		std::size_t size = 0;
+		std::size_t align = 0;
+		ft_pool_t* pool = nullptr;
+	};
+
+	ft_pool_t* pool_for(std::size_t bytes, std::size_t align, bool create)
+	{
+		if (bytes == 0 || bytes > FT_POOL_RESOURCE_MAX_SIZE || align > 16 || bytes % align)
+			return nullptr;
+		for (slot& s : slots_) {
+			if (s.pool && s.size == bytes && s.align == align)
+				return s.pool;
+			if (!s.pool) {
+				if (!create)
+					return nullptr;
+				s.pool = ft_pool_create(bytes, align);
+				if (!s.pool)
+					return nullptr;
+				s.size = bytes;
+				s.align = align;
+				return s.pool;
+			}
+		}
+		return nullptr;
+	}
+
+	std::pmr::memory_resource* upstream_;
+	slot slots_[FT_POOL_RESOURCE_SLOTS];
+};
+
+} // namespace ft
+
+#endif /* FT_POOL_ALLOCATOR_HPP */
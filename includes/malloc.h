@@ -15,14 +15,320 @@
 #define FT_MALLOC_H
 
 #include <stddef.h>
+#include <stdint.h>
 #include <errno.h>
 
 // exposes these functions as shared_lib
 #define FT_API __attribute__((visibility("default")))
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 FT_API void free(void* ptr);
 FT_API void* malloc(size_t size);
 FT_API void* realloc(void* ptr, size_t size);
-FT_API void show_alloc_mem();
+FT_API void show_alloc_mem(void);
+
+/* C11 aligned allocation: 'alignment' must be a power of two (EINVAL otherwise). */
+FT_API void* aligned_alloc(size_t alignment, size_t size);
+
+/* C23 sized deallocation: 'size' (and 'alignment') must be the values the block
+ * was requested with. A LARGE block is then found from its address alone, a
+ * slab block among the zones of its class only. */
+FT_API void free_sized(void* ptr, size_t size);
+FT_API void free_aligned_sized(void* ptr, size_t alignment, size_t size);
+
+/* glibc-compatible: returns 1 if some memory was given back to the OS, else 0.
+ * Trims the default heap, see ft_heap_trim() for the policy. */
+FT_API int malloc_trim(size_t pad);
+
+/* ---- heap instances ----
+ * Independent heaps with their own zones: memory of one heap is never handed
+ * out by another, and ft_heap_destroy() releases everything at once.
+ * malloc/free/realloc use the default instance. Each heap has one lock: calls
+ * on it from several threads are serialized, except ft_heap_destroy(), which
+ * must not race with anything else on that heap. */
+typedef struct s_heap ft_heap_t;
+
+typedef struct s_heap_config {
+	size_t tiny_bin_size;	 /* requests up to this go to TINY slabs (0 = 128) */
+	size_t small_bin_size;	 /* requests up to this go to SMALL slabs (0 = 1024) */
+	size_t tiny_min_blocks;	 /* blocks per TINY slab (0 = 128) */
+	size_t small_min_blocks; /* blocks per SMALL slab (0 = 128) */
+} ft_heap_config_t;
+
+/* NULL with errno = EINVAL unless the bins (after defaults) are multiples of
+ * 16 with tiny < small <= FT_SIZEHIST_MAX. */
+FT_API ft_heap_t* ft_heap_create(const ft_heap_config_t* config);
+FT_API void* ft_heap_alloc(ft_heap_t* h, size_t n);
+FT_API void ft_heap_dealloc(ft_heap_t* h, void* p);
+FT_API void* ft_heap_reallocate(ft_heap_t* h, void* p, size_t n);
+FT_API void ft_heap_destroy(ft_heap_t* h);
+
+/* Resize p to at least n bytes without ever moving it (like jemalloc's
+ * xallocx): a LARGE block grows into the rest of its mapping or gives back
+ * the whole pages past its new end; a slab block keeps its bin. Returns the
+ * usable size of p afterwards (>= n if it worked), 0 if p is not a live
+ * block of the heap. */
+FT_API size_t ft_resize_in_place(void* p, size_t n); /* default heap */
+FT_API size_t ft_heap_resize_in_place(ft_heap_t* h, void* p, size_t n);
+
+/* ---- persistent heaps ----
+ * A heap whose zones live in the file 'path', mapped MAP_SHARED at the fixed
+ * address 'base' (page aligned, NULL = FT_PHEAP_BASE). A new (empty) file is
+ * sized to 'size' bytes, all the heap will ever hold. An existing one is
+ * re-attached as it was last closed: zone headers, lists, blocks and the root
+ * pointer are where they were, so pointers stored in its blocks stay valid
+ * and a restart costs one mmap; 'size' is then ignored and 'base' must be
+ * NULL or the address the file was created at.
+ * One process at a time has the file open (flock, EBUSY otherwise). A file
+ * that was never closed (its process died) may have been left half-updated
+ * and is refused with EUCLEAN. ft_heap_close_file() syncs it to disk and
+ * unmaps it; allocate with ft_heap_alloc() & co. in between. Returns NULL
+ * with errno set on failure. */
+#define FT_PHEAP_BASE ((void*)0x600000000000)
+
+FT_API ft_heap_t* ft_heap_open_file(const char* path, void* base, size_t size);
+FT_API int ft_heap_close_file(ft_heap_t* h);
+/* Where the application finds its data again after re-attaching. */
+FT_API void* ft_heap_root(const ft_heap_t* h); /* NULL for other heaps */
+FT_API int ft_heap_set_root(ft_heap_t* h, void* root);
+
+/* ---- shared-memory heaps ----
+ * A heap in a shared memory segment mapped by several processes, each at its
+ * own address. ft_shm_create() makes one, either named (shm_open, attached
+ * with ft_shm_open()) or anonymous (name NULL: a memfd, inherited across
+ * fork() or passed as a descriptor to ft_shm_open_fd()). Any process mapping
+ * it allocates and frees blocks; the others read them in place. Addresses
+ * differ between processes: hand blocks over as ft_shm_offset() and turn them
+ * back with ft_shm_ptr(); ft_shm_set_root() publishes one offset to everyone.
+ * The lock is process-shared and robust: a process that dies holding it does
+ * not block the others (the call it was in is not rolled back, and may leak
+ * its memory). If the lock cannot be taken (ENOTRECOVERABLE after a recovery
+ * was abandoned), ft_shm_alloc() returns NULL and ft_shm_free() leaves the
+ * block alone, both with errno set. ft_shm_close() unmaps the caller's view;
+ * the segment is gone once every view is closed and the name unlinked. */
+typedef struct s_shm ft_shm_t;
+
+FT_API ft_shm_t* ft_shm_create(const char* name, size_t size);
+FT_API ft_shm_t* ft_shm_open(const char* name);
+FT_API ft_shm_t* ft_shm_open_fd(int fd); /* the descriptor is duplicated */
+FT_API int ft_shm_fd(const ft_shm_t* s);
+FT_API void ft_shm_close(ft_shm_t* s);
+FT_API int ft_shm_unlink(const char* name);
+FT_API void* ft_shm_alloc(ft_shm_t* s, size_t n);
+FT_API void ft_shm_free(ft_shm_t* s, void* p);
+FT_API uint64_t ft_shm_offset(const ft_shm_t* s, const void* p); /* 0 for NULL */
+FT_API void* ft_shm_ptr(const ft_shm_t* s, uint64_t off);		 /* NULL for 0 */
+FT_API uint64_t ft_shm_root(const ft_shm_t* s);
+FT_API void ft_shm_set_root(ft_shm_t* s, uint64_t off);
+
+/* ---- statistics ----
+ * Always-on counters kept per heap. Counters (n_*) only grow; gauges
+ * (live/mapped/retained/wasted/zones) are current values, and signed so a
+ * diff can go down. Classes are indexed TINY, SMALL, LARGE.
+ * wasted_bytes = mapped_bytes - live_bytes: headers, occupancy maps, free and
+ * retained blocks, page slack. Blocks count for their full bin size.
+ * Take a snapshot before and after a phase and ft_malloc_stats_diff() them to
+ * get the allocator work done by that phase. */
+enum { FT_STATS_TINY, FT_STATS_SMALL, FT_STATS_LARGE, FT_STATS_NCLASSES };
+
+typedef struct s_ft_class_stats {
+	uint64_t n_alloc;		/* blocks handed out */
+	uint64_t n_free;		/* blocks given back */
+	int64_t live_blocks;	/* blocks currently in use */
+	int64_t live_bytes;		/* bytes of those blocks */
+	int64_t mapped_bytes;	/* bytes mapped by the zones of this class */
+	int64_t retained_bytes; /* bytes of empty slab zones kept mapped */
+	int64_t wasted_bytes;	/* mapped_bytes - live_bytes (filled on read) */
+	int64_t zones;			/* zones currently mapped */
+} ft_class_stats_t;
+
+typedef struct s_ft_malloc_stats {
+	ft_class_stats_t classes[FT_STATS_NCLASSES];
+	uint64_t n_malloc;		 /* malloc/aligned_alloc calls */
+	uint64_t n_free;		 /* free calls (NULL excluded) */
+	uint64_t n_realloc;		 /* realloc calls */
+	uint64_t n_invalid_free; /* frees of pointers the heap does not own */
+	uint64_t n_mmap;		 /* zones mapped */
+	uint64_t n_munmap;		 /* zones unmapped */
+	uint64_t trimmed_bytes;	 /* bytes given back by trim */
+} ft_malloc_stats_t;
+
+FT_API void ft_malloc_stats(ft_malloc_stats_t* out); /* default heap */
+FT_API void ft_heap_stats(const ft_heap_t* h, ft_malloc_stats_t* out);
+FT_API void ft_malloc_stats_diff(const ft_malloc_stats_t* before,
+								 const ft_malloc_stats_t* after,
+								 ft_malloc_stats_t* out);
+
+/* ---- latency histograms ----
+ * Opt-in self-timing of malloc, free and realloc with the CPU timestamp
+ * counter: FT_MALLOC_LATENCY=1 in the environment, or
+ * ft_malloc_latency_enable(1). Every thread fills its own histograms, one per
+ * (op, size class, path); the slow path is a call that mapped or unmapped a
+ * zone. Buckets are log-linear (HDR style): exact below 2^FT_LAT_SUB_BITS
+ * ticks, then 2^FT_LAT_SUB_BITS buckets per power of two (12.5% wide).
+ * ft_malloc_latency() sums the histograms of all threads, past and present;
+ * threads still running may be a few calls ahead of the copy. The struct is
+ * large (~53 KiB): keep it off small stacks. Reset only while quiet. */
+enum { FT_LAT_MALLOC, FT_LAT_FREE, FT_LAT_REALLOC, FT_LAT_NOPS };
+enum { FT_LAT_FAST, FT_LAT_SLOW, FT_LAT_NPATHS };
+
+#define FT_LAT_SUB_BITS 3
+#define FT_LAT_MAX_LOG2 47 /* longer calls land in the last bucket */
+#define FT_LAT_BUCKETS ((FT_LAT_MAX_LOG2 - FT_LAT_SUB_BITS + 2) << FT_LAT_SUB_BITS)
+
+typedef struct s_ft_lat_hist {
+	uint64_t count;
+	uint64_t sum_ticks;
+	uint64_t max_ticks;
+	uint64_t buckets[FT_LAT_BUCKETS];
+} ft_lat_hist_t;
+
+typedef struct s_ft_malloc_latency {
+	double ticks_per_ns; /* measured since the first enable, 0 if unknown */
+	ft_lat_hist_t hist[FT_LAT_NOPS][FT_STATS_NCLASSES][FT_LAT_NPATHS];
+} ft_malloc_latency_t;
+
+FT_API int ft_malloc_latency_enable(int on); /* returns the previous state */
+FT_API void ft_malloc_latency(ft_malloc_latency_t* out);
+FT_API void ft_malloc_latency_reset(void);
+/* Upper bound, in ticks, of the bucket holding the q-quantile (0 <= q <= 1),
+ * capped at max_ticks; 0 for an empty histogram. */
+FT_API uint64_t ft_lat_hist_quantile(const ft_lat_hist_t* h, double q);
+
+/* ---- request-size histogram ----
+ * Opt-in count of malloc, realloc and aligned_alloc requests by size:
+ * FT_MALLOC_SIZEHIST=<file> in the environment, or
+ * ft_malloc_sizehist_enable(1). Requests are rounded up to 16 bytes, one
+ * bucket per size up to FT_SIZEHIST_MAX, then one per power of two. With the
+ * variable set the histogram is written to <file> at exit (the
+ * ft_malloc_sizehist_dump() text format); `make sizetune HIST=<file>` turns it
+ * into the TINY/SMALL bin sizes that lose the fewest bytes to rounding, to be
+ * loaded with FT_MALLOC_BINS=<tiny>,<small>. That variable is read when the
+ * library loads and applies to the default heap, unless slab zones were
+ * already mapped by then. Reset only while quiet. */
+#define FT_SIZEHIST_MAX 32768 /* largest bin FT_MALLOC_BINS accepts */
+#define FT_SIZEHIST_FINE (FT_SIZEHIST_MAX / 16)
+#define FT_SIZEHIST_COARSE 64
+
+typedef struct s_ft_sizehist {
+	uint64_t fine[FT_SIZEHIST_FINE];	 /* fine[i]: (16 * i, 16 * (i + 1)] bytes, 0 in fine[0] */
+	uint64_t coarse[FT_SIZEHIST_COARSE]; /* coarse[e]: above FT_SIZEHIST_MAX, [2^e, 2^(e+1)) */
+} ft_sizehist_t;
+
+FT_API int ft_malloc_sizehist_enable(int on); /* returns the previous state */
+FT_API void ft_malloc_sizehist(ft_sizehist_t* out);
+FT_API void ft_malloc_sizehist_reset(void);
+/* One "<bytes> <count>" line per non-empty bucket after a header line; bytes
+ * is the bucket's upper bound (fine) or "2^<e>" (coarse). Returns 0, or -1
+ * with errno = EBADF for a negative fd. */
+FT_API int ft_malloc_sizehist_dump(int fd);
+
+/* ---- inspection ----
+ * show_alloc_mem_ex() prints like show_alloc_mem(), restricted by 'filter'
+ * (NULL shows everything), and with runs of adjacent used blocks printed as a
+ * single "begin - end : bytes" range. A block is shown when its class is in
+ * 'classes' (0 = all), it starts in [lo, hi) (hi == NULL: no upper bound)
+ * and its block size is at least min_size. Returns the bytes listed. */
+enum { FT_SHOW_TINY = 1 << 0, FT_SHOW_SMALL = 1 << 1, FT_SHOW_LARGE = 1 << 2 };
+
+typedef struct s_ft_show_filter {
+	unsigned classes; /* FT_SHOW_* mask */
+	const void* lo;
+	const void* hi;
+	size_t min_size;
+} ft_show_filter_t;
+
+FT_API size_t show_alloc_mem_ex(const ft_show_filter_t* filter);
+
+/* Machine-readable report written to 'fd': per class and per zone capacity,
+ * free blocks, bin size, mapped and live bytes, fragmentation ratio
+ * ((mapped - live) / mapped) and retained empty slabs.
+ * FT_MALLOC_INFO_XML follows glibc malloc_info(): one <heap> per class, zones
+ * as extra <zone> elements. Building the report never allocates from the heap
+ * it describes; the heap is only locked while its zones are summed, not while
+ * the report is written. Returns 0, or -1 with errno = EINVAL for an unknown
+ * format or ENOMEM if no memory could be mapped for the summary. */
+enum { FT_MALLOC_INFO_JSON, FT_MALLOC_INFO_XML };
+
+FT_API int ft_malloc_info(int fd, int format); /* default heap */
+FT_API int ft_heap_malloc_info(const ft_heap_t* h, int fd, int format);
+
+/* ---- iteration ----
+ * ft_heap_iterate() calls cb(ptr, size, arg) for every block in use that
+ * starts in [base, base + size): slab blocks with their bin size, LARGE
+ * blocks with their payload size. Blocks are visited zone by zone, in no
+ * particular order. The heap is locked for the walk; the callback must not
+ * allocate or free from that heap.
+ * ft_heap_disable() freezes a heap: every other thread calling into it
+ * blocks until ft_heap_enable(). The freezing thread may iterate, read stats,
+ * take snapshots and print reports, any number of times, but must not
+ * allocate from the heap meanwhile. Freezes nest: each ft_heap_disable()
+ * needs its ft_heap_enable(). The default heap is also frozen across fork(),
+ * so the child never inherits it half-updated (a frozen thread may fork).
+ * Returns 0, or -1 with errno = EINVAL for a NULL heap or callback. */
+typedef void (*ft_iterate_cb_t)(uintptr_t ptr, size_t size, void* arg);
+
+FT_API int ft_malloc_iterate(uintptr_t base, size_t size, ft_iterate_cb_t cb, void* arg);
+FT_API int ft_heap_iterate(const ft_heap_t* h, uintptr_t base, size_t size, ft_iterate_cb_t cb,
+						   void* arg);
+FT_API void ft_malloc_disable(void); /* default heap */
+FT_API void ft_malloc_enable(void);
+FT_API void ft_heap_disable(ft_heap_t* h);
+FT_API void ft_heap_enable(ft_heap_t* h);
+
+/* ---- snapshots ----
+ * ft_heap_snapshot() records the occupancy of every class and zone (blocks
+ * used, live and mapped bytes; LARGE blocks by power-of-two size bucket) into
+ * its own mapping, outside the heap. ft_heap_snapshot_diff() writes to 'fd'
+ * what changed from 'a' to 'b', one line each:
+ *   class TINY zones 1 -> 3 (+2) used ... live ... mapped ...
+ *   total zones ... live ... mapped ...
+ *   zone SMALL + 0x...  (mapped since a)    '-' unmapped, '~' occupancy changed
+ *   large 2^16 count 0 -> 4 (+4) bytes 0 -> 300000 (+300000)
+ * Unchanged zones and buckets are left out. NULL with errno = ENOMEM if the
+ * snapshot cannot be mapped; diff returns 0, or -1 with errno = EINVAL. */
+typedef struct s_heap_snapshot ft_heap_snapshot_t;
+
+FT_API ft_heap_snapshot_t* ft_malloc_snapshot(void); /* default heap */
+FT_API ft_heap_snapshot_t* ft_heap_snapshot(const ft_heap_t* h);
+FT_API int ft_heap_snapshot_diff(const ft_heap_snapshot_t* a, const ft_heap_snapshot_t* b, int fd);
+FT_API void ft_heap_snapshot_free(ft_heap_snapshot_t* s);
+
+/* ---- sampling heap profiler ----
+ * Records about one allocation per 'interval' bytes (random, exponentially
+ * distributed gaps) with its call stack, until that block is freed. Enable it
+ * with ft_malloc_profile_start() or FT_MALLOC_SAMPLE=<bytes> in the
+ * environment (e.g. 524288); stacks are walked through frame pointers.
+ * ft_malloc_profile_dump() writes the live samples in pprof's heap_v2 text
+ * format (`pprof <binary> <file>`), from a copy taken under the profiler
+ * lock: sampling goes on while it writes. Stopping forgets every sample.
+ * Returns 0, or -1 with errno = EBADF for a negative fd, ENOMEM if no memory
+ * was left for the copy. */
+FT_API void ft_malloc_profile_start(size_t interval);
+FT_API void ft_malloc_profile_stop(void);
+FT_API int ft_malloc_profile_dump(int fd);
+
+/* ---- fixed-size object pools ----
+ * Every block is exactly obj_size bytes (rounded up to 'align' only).
+ * align == 0 picks the natural alignment of obj_size (capped at 16).
+ * ft_pool_free() must get a pointer from the same pool; it does no lookup.
+ * ft_pool_destroy() releases every object of the pool at once.
+ * A pool may be shared between threads; the bulk calls take its lock once
+ * for n objects (alloc_bulk returns how many it could get). */
+typedef struct s_pool ft_pool_t;
+
+FT_API ft_pool_t* ft_pool_create(size_t obj_size, size_t align);
+FT_API void* ft_pool_alloc(ft_pool_t* pool);
+FT_API void ft_pool_free(ft_pool_t* pool, void* p);
+FT_API size_t ft_pool_alloc_bulk(ft_pool_t* pool, void** out, size_t n);
+FT_API void ft_pool_free_bulk(ft_pool_t* pool, void* const* ptrs, size_t n);
+FT_API void ft_pool_destroy(ft_pool_t* pool);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
 
 #endif
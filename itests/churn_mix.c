@@ -29,7 +29,8 @@ int main(void) {
     }
     // verify a sample
     for (int i = 0; i < N; i += 137) {
-        if (ptrs[i][0] != (unsigned char)(i & 0xFF)) { fprintf(stderr, "pattern mismatch\n"); return 1; }
+        unsigned char want = (unsigned char)(i & 0xFF);
+        if (ptrs[i][0] != want || ptrs[i][sizes[i] - 1] != want) { fprintf(stderr, "pattern mismatch\n"); return 1; }
     }
     // free in a different order
     for (int i = N-1; i >= 0; --i) free(ptrs[i]);
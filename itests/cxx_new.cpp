@@ -0,0 +1,77 @@
+// itests/cxx_new.cpp
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <list>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#define CHECK(cond)                                                  \
+    do {                                                             \
+        if (!(cond)) {                                               \
+            std::fprintf(stderr, "cxx_new: FAIL %s (line %d)\n", #cond, __LINE__); \
+            return 1;                                                \
+        }                                                            \
+    } while (0)
+
+struct alignas(64) Line { unsigned char bytes[64]; };
+struct alignas(256) Slot { int v; };
+struct alignas(4096) Page { char bytes[100]; };
+
+static bool aligned(const void* p, std::size_t a) {
+    return (reinterpret_cast<std::uintptr_t>(p) % a) == 0;
+}
+
+int main() {
+    // plain + sized delete
+    for (int round = 0; round < 3; ++round) {
+        std::vector<int*> v;
+        for (int i = 0; i < 5000; ++i) v.push_back(new int(i));
+        for (int i = 0; i < 5000; ++i) { CHECK(*v[i] == i); delete v[i]; }
+    }
+
+    // arrays
+    std::string* s = new std::string[17];
+    for (int i = 0; i < 17; ++i) s[i] = std::string(100, char('a' + i));
+    CHECK(s[16][99] == 'q');
+    delete[] s;
+
+    // aligned new goes to aligned blocks, from every tier
+    std::vector<Line*> lines;
+    for (int i = 0; i < 300; ++i) {
+        Line* l = new Line;
+        CHECK(aligned(l, 64));
+        std::memset(l->bytes, i & 0xFF, sizeof l->bytes);
+        lines.push_back(l);
+    }
+    for (Line* l : lines) delete l;
+
+    Slot* slots = new Slot[40];
+    CHECK(aligned(slots, 256));
+    delete[] slots;
+
+    Page* pg = new Page;
+    CHECK(aligned(pg, 4096));
+    delete pg;
+
+    // containers
+    std::map<int, std::string> m;
+    std::list<long> l;
+    for (int i = 0; i < 20000; ++i) { m[i] = std::to_string(i); l.push_back(i); }
+    for (int i = 0; i < 20000; i += 2) m.erase(i);
+    CHECK(m.size() == 10000 && m[9999] == "9999");
+
+    // failure paths
+    std::size_t huge = std::numeric_limits<std::size_t>::max() - 4096;
+    CHECK(::operator new(huge, std::nothrow) == nullptr);
+    CHECK(::operator new(huge, std::align_val_t(64), std::nothrow) == nullptr);
+    bool threw = false;
+    try { (void)::operator new(huge); } catch (const std::bad_alloc&) { threw = true; }
+    CHECK(threw);
+
+    std::puts("cxx_new: OK");
+    return 0;
+}
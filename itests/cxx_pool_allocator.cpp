@@ -0,0 +1,96 @@
+// itests/cxx_pool_allocator.cpp
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <thread>
+#include <unordered_map>
+
+#include "ft_pool_allocator.hpp"
+
+#define CHECK(cond)                                                  \
+    do {                                                             \
+        if (!(cond)) {                                               \
+            std::fprintf(stderr, "cxx_pool_allocator: FAIL %s (line %d)\n", #cond, __LINE__); \
+            return 1;                                                \
+        }                                                            \
+    } while (0)
+
+template <class T> using pool_list = std::list<T, ft::pool_allocator<T>>;
+template <class K, class V>
+using pool_map = std::map<K, V, std::less<K>, ft::pool_allocator<std::pair<const K, V>>>;
+template <class K, class V>
+using pool_umap = std::unordered_map<K, V, std::hash<K>, std::equal_to<K>,
+                                     ft::pool_allocator<std::pair<const K, V>>>;
+
+// fraction of list nodes that sit right after their predecessor in memory
+template <class List> static double adjacency(const List& l, std::size_t node_size) {
+    std::size_t adj = 0, n = 0;
+    const void* prev = nullptr;
+    for (const auto& v : l) {
+        const char* node = reinterpret_cast<const char*>(&v);
+        if (prev && static_cast<std::size_t>(node - static_cast<const char*>(prev)) == node_size)
+            ++adj;
+        prev = node;
+        ++n;
+    }
+    return n > 1 ? double(adj) / double(n - 1) : 1.0;
+}
+
+static int run_containers() {
+    pool_list<long> l;
+    for (long i = 0; i < 10000; ++i) l.push_back(i);
+    long sum = 0;
+    for (long v : l) sum += v;
+    CHECK(sum == 10000L * 9999 / 2);
+    // exact-fit nodes (prev, next, value) packed back to back
+    CHECK(adjacency(l, 3 * sizeof(void*)) > 0.9);
+
+    pool_map<int, int> m;
+    for (int i = 0; i < 20000; ++i) m[i] = i * 2;
+    for (int i = 0; i < 20000; i += 3) m.erase(i);
+    CHECK(m.size() == 13333 && m[1] == 2);
+
+    pool_umap<int, double> um;
+    for (int i = 0; i < 20000; ++i) um[i] = i / 2.0;
+    CHECK(um.size() == 20000 && um[10] == 5.0);
+    return 0;
+}
+
+int main() {
+    if (run_containers()) return 1;
+
+    // per-thread caches: nodes built on one thread, freed on another, and
+    // caches drained at thread exit (one thread at a time: only the pools
+    // are locked, the default heap behind operator new is not)
+    pool_list<int>* shared = new pool_list<int>;
+    int rc = 0;
+    std::thread([shared, &rc] {
+        for (int i = 0; i < 5000; ++i) shared->push_back(i);
+        rc |= run_containers();
+    }).join();
+    std::thread([shared] { delete shared; }).join();
+    CHECK(rc == 0);
+
+    // a thread_local container built before the thread's cache is destroyed
+    // after it: its nodes then go straight back to the pool
+    std::thread([] {
+        thread_local pool_list<short> late;
+        for (int i = 0; i < 1000; ++i) late.push_back(static_cast<short>(i));
+    }).join();
+
+    // pmr adapter
+    {
+        ft::pool_resource res;
+        std::pmr::list<int> pl(&res);
+        std::pmr::unordered_map<int, int> pu(&res);
+        for (int i = 0; i < 10000; ++i) { pl.push_back(i); pu[i] = -i; }
+        CHECK(pl.back() == 9999 && pu[42] == -42);
+        CHECK(adjacency(pl, 3 * sizeof(void*)) > 0.9);
+    }
+
+    std::puts("cxx_pool_allocator: OK");
+    return 0;
+}
@@ -33,6 +33,15 @@ int main(void) {
 
     show_alloc_mem();
 
+    puts("---- show_alloc_mem_ex (SMALL and LARGE, >= 1024 bytes) ----");
+    fflush(stdout);
+    ft_show_filter_t f = { FT_SHOW_SMALL | FT_SHOW_LARGE, NULL, NULL, 1024 };
+    size_t shown = show_alloc_mem_ex(&f);
+    if (shown < 3 * SMALL_MAX + 64*1024 + 123) {
+        puts("show_test: show_alloc_mem_ex missed blocks");
+        return 1;
+    }
+
     free(t1);
     free(t2);
 
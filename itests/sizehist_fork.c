@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "sizehist/sizehist.h"
+
+// Records a size histogram of a process whose child allocates and exits
+// normally, then checks that the file holds the parent's dump alone.
+
+enum { PARENT_SIZE = 4320, CHILD_SIZE = 1232, N = 50 };
+
+static int record(void) {
+    for (int i = 0; i < N; ++i)
+        free(malloc(PARENT_SIZE));       // counted before the fork
+    pid_t pid = fork();
+    if (pid == 0) {
+        for (int i = 0; i < N; ++i)
+            free(malloc(CHILD_SIZE));
+        exit(0);                         // runs the library's destructors
+    }
+    int status = 0;
+    if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status))
+        return 1;
+    return 0;
+}
+
+static int check(const char* path) {
+    static char text[1 << 16];
+    FILE* f = fopen(path, "r");
+    if (!f) { fprintf(stderr, "no histogram\n"); return 1; }
+    size_t len = fread(text, 1, sizeof text - 1, f);
+    fclose(f);
+    text[len] = '\0';
+
+    if (strncmp(text, FT_SIZEHIST_MAGIC "\n", strlen(FT_SIZEHIST_MAGIC) + 1)
+        || strstr(text + 1, FT_SIZEHIST_MAGIC)) {
+        fprintf(stderr, "not one dump:\n%s", text);
+        return 1;
+    }
+    unsigned long parent = 0, child = 0;
+    for (char* line = strchr(text, '\n'); line && line[1]; line = strchr(line + 1, '\n')) {
+        unsigned long size, count;
+        if (sscanf(line + 1, "%lu %lu", &size, &count) != 2)
+            continue;                    // coarse "2^e" lines
+        parent += size == PARENT_SIZE ? count : 0;
+        child += size == CHILD_SIZE ? count : 0;
+    }
+    if (parent != N || child) {
+        fprintf(stderr, "%lu requests of the parent, %lu of the child\n", parent, child);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    if (getenv(FT_SIZEHIST_ENV))
+        return record();
+
+    char path[] = "/tmp/ft_sizehist_forkXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) { perror("mkstemp"); return 1; }
+    close(fd);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        setenv(FT_SIZEHIST_ENV, path, 1);
+        execv("/proc/self/exe", argv);
+        execv(argv[0], argv);
+        _exit(127);
+    }
+    int status = 0;
+    if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status)) {
+        fprintf(stderr, "recording failed\n");
+        unlink(path);
+        return 1;
+    }
+    int rc = check(path);
+    unlink(path);
+    if (rc)
+        return rc;
+    puts("sizehist_fork: OK");
+    return 0;
+}
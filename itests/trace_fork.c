@@ -0,0 +1,91 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "trace/trace.h"
+
+// Records a trace of a process whose child allocates and exits normally,
+// then checks that the file is the parent's alone: the header counts every
+// record in it, and none of them comes from the child.
+
+enum { PARENT_SIZE = 4321, CHILD_SIZE = 1234, N = 50 };
+
+static int record(void) {
+    void* p[N];
+    for (int i = 0; i < N; ++i)
+        p[i] = malloc(PARENT_SIZE);      // left in the ring when the child forks
+    pid_t pid = fork();
+    if (pid == 0) {
+        for (int i = 0; i < N; ++i)
+            free(malloc(CHILD_SIZE));
+        exit(0);                         // runs the library's destructors
+    }
+    int status = 0;
+    if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status))
+        return 1;
+    for (int i = 0; i < N; ++i)
+        free(p[i]);
+    return 0;
+}
+
+static int check(const char* path) {
+    FILE* f = fopen(path, "rb");
+    struct stat st;
+    t_trace_file_header hdr;
+    if (!f || stat(path, &st) || fread(&hdr, sizeof hdr, 1, f) != 1) { fprintf(stderr, "no trace\n"); return 1; }
+    size_t in_file = ((size_t)st.st_size - sizeof hdr) / sizeof(t_trace_rec);
+    if (hdr.n_records != in_file || hdr.n_dropped) {
+        fprintf(stderr, "header says %llu records, the file holds %zu\n",
+                (unsigned long long)hdr.n_records, in_file);
+        return 1;
+    }
+    size_t mallocs = 0, frees = 0;
+    t_trace_rec r;
+    while (fread(&r, sizeof r, 1, f) == 1) {
+        if (r.op == FT_TRACE_MALLOC && r.size == CHILD_SIZE) {
+            fprintf(stderr, "a record of the child\n");
+            return 1;
+        }
+        mallocs += r.op == FT_TRACE_MALLOC && r.size == PARENT_SIZE;
+        frees += r.op == FT_TRACE_FREE;
+    }
+    fclose(f);
+    if (mallocs != N || frees < N) {
+        fprintf(stderr, "%zu mallocs, %zu frees of the parent\n", mallocs, frees);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    if (getenv(FT_TRACE_ENV))
+        return record();
+
+    char path[] = "/tmp/ft_trace_forkXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) { perror("mkstemp"); return 1; }
+    close(fd);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        setenv(FT_TRACE_ENV, path, 1);
+        execv("/proc/self/exe", argv);
+        execv(argv[0], argv);
+        _exit(127);
+    }
+    int status = 0;
+    if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status)) {
+        fprintf(stderr, "recording failed\n");
+        unlink(path);
+        return 1;
+    }
+    int rc = check(path);
+    unlink(path);
+    if (rc)
+        return rc;
+    puts("trace_fork: OK");
+    return 0;
+}
@@ -0,0 +1,167 @@
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "trace/trace.h"
+
+// Records a trace of threads reallocating blocks that other threads are
+// freeing and allocating, then checks it the way a replay would see it:
+// in tsc order, no allocation may return an address that is still live.
+
+enum { THREADS = 4, SLOTS = 16, ITERS = 1500 };
+
+static void* churn(void* arg) {
+    unsigned r = (unsigned)(uintptr_t)arg * 2654435761u + 1;
+    void* slot[SLOTS] = {0};
+    for (int i = 0; i < ITERS; ++i) {
+        r = r * 1103515245u + 12345u;
+        int j = (int)((r >> 8) % SLOTS);
+        size_t n = 1 + (r >> 12) % 1500;            // tiny and small: realloc moves
+        if (!slot[j])
+            slot[j] = malloc(n);
+        else if ((r >> 4) % 4)
+            slot[j] = realloc(slot[j], n);
+        else {
+            free(slot[j]);
+            slot[j] = NULL;
+        }
+    }
+    for (int j = 0; j < SLOTS; ++j)
+        free(slot[j]);
+    return NULL;
+}
+
+static int record(void) {
+    pthread_t th[THREADS];
+    for (int t = 0; t < THREADS; ++t)
+        if (pthread_create(&th[t], NULL, churn, (void*)(uintptr_t)(t + 1)) != 0)
+            return 1;
+    for (int t = 0; t < THREADS; ++t)
+        pthread_join(th[t], NULL);
+    return 0;                                      // the trace is finalized at exit
+}
+
+// ---- live address set (open addressing, tombstones) ----
+
+#define TOMB UINT64_MAX
+static uint64_t* g_set;
+static size_t g_cap;
+
+static uint64_t* set_slot(uint64_t a, int for_insert) {
+    uint64_t* tomb = NULL;
+    for (size_t i = (size_t)(a >> 4) & (g_cap - 1);; i = (i + 1) & (g_cap - 1)) {
+        if (g_set[i] == a)
+            return &g_set[i];
+        if (g_set[i] == TOMB && !tomb)
+            tomb = &g_set[i];
+        if (g_set[i] == 0)
+            return for_insert ? (tomb ? tomb : &g_set[i]) : NULL;
+    }
+}
+
+static t_trace_rec* g_recs;
+
+static int by_tsc(const void* a, const void* b) {
+    const t_trace_rec* x = &g_recs[*(const size_t*)a];
+    const t_trace_rec* y = &g_recs[*(const size_t*)b];
+    if (x->tsc != y->tsc)
+        return x->tsc < y->tsc ? -1 : 1;
+    // same tsc: keep file order, which is program order within a thread
+    return *(const size_t*)a < *(const size_t*)b ? -1 : 1;
+}
+
+static int check(const char* path) {
+    FILE* f = fopen(path, "rb");
+    t_trace_file_header hdr;
+    if (!f || fread(&hdr, sizeof hdr, 1, f) != 1) { fprintf(stderr, "no trace\n"); return 1; }
+    if (hdr.version != FT_TRACE_VERSION || hdr.n_dropped) {
+        fprintf(stderr, "version %u, %llu dropped\n", hdr.version, (unsigned long long)hdr.n_dropped);
+        return 1;
+    }
+    size_t n = (size_t)hdr.n_records;
+    g_recs = malloc(n * sizeof *g_recs);
+    size_t* order = malloc(n * sizeof *order);
+    if (!g_recs || !order || fread(g_recs, sizeof *g_recs, n, f) != n) { fprintf(stderr, "short trace\n"); return 1; }
+    fclose(f);
+
+    // a realloc's two halves are adjacent in its thread's program order
+    size_t reallocs = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (g_recs[i].op != FT_TRACE_REALLOC)
+            continue;
+        size_t k = i + 1;
+        while (k < n && g_recs[k].tid != g_recs[i].tid)
+            ++k;
+        if (k == n || g_recs[k].op != FT_TRACE_REALLOC_RET || g_recs[k].ptr != g_recs[i].ptr) {
+            fprintf(stderr, "realloc at record %zu has no result record\n", i);
+            return 1;
+        }
+        reallocs++;
+    }
+    if (reallocs < 1000) { fprintf(stderr, "only %zu reallocs traced\n", reallocs); return 1; }
+
+    for (size_t i = 0; i < n; ++i)
+        order[i] = i;
+    qsort(order, n, sizeof *order, by_tsc);
+    for (g_cap = 1024; g_cap < n * 2; g_cap *= 2) {}
+    g_set = calloc(g_cap, sizeof *g_set);
+    if (!g_set) return 1;
+
+    for (size_t k = 0; k < n; ++k) {
+        const t_trace_rec* r = &g_recs[order[k]];
+        if (r->op == FT_TRACE_FREE || r->op == FT_TRACE_REALLOC) {
+            uint64_t* s = r->ptr ? set_slot(r->ptr, 0) : NULL;
+            if (s)                                 // unknown: allocated before the trace
+                *s = TOMB;
+        }
+        int gives = r->op == FT_TRACE_MALLOC || r->op == FT_TRACE_ALIGNED_ALLOC
+                    || r->op == FT_TRACE_REALLOC_RET;
+        if (gives && r->ret) {
+            uint64_t* s = set_slot(r->ret, 1);
+            if (*s == r->ret) {
+                fprintf(stderr, "%#llx handed out again before it was released (record %zu)\n",
+                        (unsigned long long)r->ret, order[k]);
+                return 1;
+            }
+            *s = r->ret;
+        }
+    }
+    free(g_set);
+    free(order);
+    free(g_recs);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    if (getenv(FT_TRACE_ENV))
+        return record();
+
+    char path[] = "/tmp/ft_trace_itestXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) { perror("mkstemp"); return 1; }
+    close(fd);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        setenv(FT_TRACE_ENV, path, 1);
+        execv("/proc/self/exe", argv);
+        execv(argv[0], argv);
+        _exit(127);
+    }
+    int status = 0;
+    if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status)) {
+        fprintf(stderr, "recording failed\n");
+        unlink(path);
+        return 1;
+    }
+    int rc = check(path);
+    unlink(path);
+    if (rc)
+        return rc;
+    puts("trace_realloc_mt: OK");
+    return 0;
+}
@@ -11,189 +11,520 @@
 /* ************************************************************************** */
 
 #include "heap.h"
-
-#include "heap.h"
+#include "probe/probe.h"
 #include "zone/zone_list.h" // for ft_zone_ll_destroy, _first_with_space, _find_container_of
 #include "helpers/helpers.h"
 
-static inline t_ll_node** list_for(t_zone_class k);
-static inline size_t ft_bin_size_for_k(t_zone_class k);
+#include <errno.h>
+
+static inline t_ll_node** list_for(t_heap* h, t_zone_class k);
+static inline size_t ft_bin_size_for_k(const t_heap* h, t_zone_class k);
+
+_Static_assert(FT_STATS_NCLASSES == N_ZONE_CATEGORIES, "stats classes must mirror zone lists");
 
-t_heap g_heap = {0};
+t_heap g_heap = FT_HEAP_DEFAULT_INIT;
 
-#ifndef FT_HEAP_NO_CTOR
-__attribute__((constructor)) static void ft_malloc_ctor(void)
+__thread t_heap_op_note g_heap_op_note __attribute__((tls_model("initial-exec")));
+
+void ft_heap_init(t_heap* h, size_t tiny_bin_size, size_t small_bin_size)
 {
-	ft_heap_init(TINY_BIN_SIZE, SMALL_BIN_SIZE); /* or your chosen min_blocks */
+	*h = (t_heap){0};
+	pthread_mutex_init(&h->lock, NULL);
+	h->tiny_bin_size = tiny_bin_size ? tiny_bin_size : TINY_BIN_SIZE;
+	h->small_bin_size = small_bin_size ? small_bin_size : SMALL_BIN_SIZE;
+
+	h->tiny_min_blocks = TINY_N_BLOCKS;
+	h->small_min_blocks = SMALL_N_BLOCKS;
 }
-#endif
 
-#ifndef FT_HEAP_NO_DTOR
-__attribute__((destructor)) static void ft_malloc_dtor(void)
+/* FT_ALIGN multiples, tiny < small <= FT_SIZEHIST_MAX */
+static int ft_heap_bins_valid(size_t tiny_bin_size, size_t small_bin_size)
 {
-	ft_heap_destroy();
+	return tiny_bin_size && !(tiny_bin_size % FT_ALIGN) && !(small_bin_size % FT_ALIGN) &&
+		   tiny_bin_size < small_bin_size && small_bin_size <= FT_SIZEHIST_MAX;
 }
-#endif
 
-void ft_heap_init(size_t tiny_bin_size, size_t small_bin_size)
+int ft_heap_set_bins(t_heap* h, size_t tiny_bin_size, size_t small_bin_size)
 {
-	g_heap = (t_heap){0};
-	g_heap.tiny_bin_size = tiny_bin_size;	// TINY_BIN_SIZE
-	g_heap.small_bin_size = small_bin_size; // SMALL_BIN_SIZE
+	if (!ft_heap_bins_valid(tiny_bin_size, small_bin_size)) {
+		errno = EINVAL;
+		return -1;
+	}
+	ft_heap_lock(h);
+	if (*list_for(h, FT_Z_TINY) || *list_for(h, FT_Z_SMALL)) {
+		ft_heap_unlock(h);
+		errno = EBUSY;
+		return -1;
+	}
+	h->tiny_bin_size = tiny_bin_size;
+	h->small_bin_size = small_bin_size;
+	ft_heap_unlock(h);
+	return 0;
+}
+
+ft_heap_t* ft_heap_create(const ft_heap_config_t* config)
+{
+	const t_heap_config cfg = config ? *config : (t_heap_config){0};
 
-	g_heap.tiny_min_blocks = TINY_N_BLOCKS;
-	g_heap.small_min_blocks = SMALL_N_BLOCKS;
+	if (!ft_heap_bins_valid(cfg.tiny_bin_size ? cfg.tiny_bin_size : TINY_BIN_SIZE,
+			cfg.small_bin_size ? cfg.small_bin_size : SMALL_BIN_SIZE)) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	t_zone* self = t_zone_new_large(sizeof(t_heap));
+	if (!self)
+		return NULL;
+
+	t_heap* h = (t_heap*)self->mem_begin;
+	ft_heap_init(h, cfg.tiny_bin_size, cfg.small_bin_size);
+	if (cfg.tiny_min_blocks)
+		h->tiny_min_blocks = cfg.tiny_min_blocks;
+	if (cfg.small_min_blocks)
+		h->small_min_blocks = cfg.small_min_blocks;
+	h->self = self;
+	return h;
 }
 
-void ft_heap_destroy(void)
+void ft_heap_destroy(ft_heap_t* h)
 {
+	if (!h)
+		return;
+
 	for (int i = 0; i < N_ZONE_CATEGORIES; ++i) {
-		ft_zone_ll_destroy(&g_heap.zls[i]);
+		ft_zone_ll_destroy(&h->zls[i]);
+	}
+
+	if (h->self) {
+		ft_zone_destroy(h->self);
+		return;
 	}
+	h->tiny_min_blocks = 0;
+	h->small_min_blocks = 0;
+	h->stats = (ft_malloc_stats_t){0};
+}
 
-	g_heap.tiny_min_blocks = 0;
-	g_heap.small_min_blocks = 0;
+/* ---- zone bookkeeping (keeps h->stats in sync) ----
+ * Invariant: every empty slab zone sitting in a list is counted in
+ * retained_bytes; a zone is counted from creation until its first block goes. */
+
+static t_zone* ft_heap_add_zone(t_heap* h, t_zone* z)
+{
+	ft_class_stats_t* cs = &h->stats.classes[z->klass];
+	const int64_t bytes = (int64_t)ft_zone_mapped_bytes(z);
+
+	ft_ll_push_front(list_for(h, z->klass), &z->link);
+	h->stats.n_mmap++;
+	g_heap_op_note.zone_events++;
+	cs->zones++;
+	cs->mapped_bytes += bytes;
+	if (z->klass != FT_Z_LARGE)
+		cs->retained_bytes += bytes;
+	return z;
 }
 
-void* ft_heap_malloc(size_t n)
+static void ft_heap_drop_zone(t_heap* h, t_zone* z)
+{
+	ft_class_stats_t* cs = &h->stats.classes[z->klass];
+	const int64_t bytes = (int64_t)ft_zone_mapped_bytes(z);
+
+	ft_ll_remove(list_for(h, z->klass), &z->link);
+	h->stats.n_munmap++;
+	g_heap_op_note.zone_events++;
+	cs->zones--;
+	cs->mapped_bytes -= bytes;
+	if (z->klass != FT_Z_LARGE && z->free_count == z->capacity)
+		cs->retained_bytes -= bytes;
+	ft_zone_destroy(z);
+}
+
+static void ft_heap_count_alloc(t_heap* h, const t_zone* z)
+{
+	ft_class_stats_t* cs = &h->stats.classes[z->klass];
+
+	g_heap_op_note.klass = z->klass;
+	cs->n_alloc++;
+	cs->live_blocks++;
+	cs->live_bytes += (int64_t)z->bin_size;
+}
+
+static void ft_heap_count_free(t_heap* h, const t_zone* z)
+{
+	ft_class_stats_t* cs = &h->stats.classes[z->klass];
+
+	g_heap_op_note.klass = z->klass;
+	cs->n_free++;
+	cs->live_blocks--;
+	cs->live_bytes -= (int64_t)z->bin_size;
+}
+
+/* slab block out of a zone already in the heap lists */
+static void* ft_heap_take_block(t_heap* h, t_zone* z)
+{
+	if (z->free_count == z->capacity)
+		h->stats.classes[z->klass].retained_bytes -= (int64_t)ft_zone_mapped_bytes(z);
+
+	void* p = ft_zone_alloc_block(z);
+	if (p)
+		ft_heap_count_alloc(h, z);
+	return p;
+}
+
+/* LARGE block: a fresh zone of its own */
+static void* ft_heap_take_large(t_heap* h, t_zone* z)
+{
+	if (!z)
+		return NULL;
+	ft_heap_add_zone(h, z);
+	ft_heap_count_alloc(h, z);
+	return z->mem_begin;
+}
+
+static void* ft_heap_alloc_locked(t_heap* h, size_t n)
 {
 	size_t req = n ? n : 1;
 
-	t_zone_class k = ft_heap_classify(req);
+	t_zone_class k = ft_heap_classify(h, req);
+	g_heap_op_note.klass = k; /* for the probe and lib/latency, even on failure */
 
 	size_t need = ft_align_up(req, FT_ALIGN); // minimal ABI alignment (16)
 
-	t_ll_node** head = list_for(k);
+	t_ll_node** head = list_for(h, k);
 
-	if (k == FT_Z_LARGE) {
-		t_zone* z = t_zone_new_large(need);
-		if (!z)
-			return NULL;
-		ft_ll_push_front(head, &z->link);
-		return z->mem_begin;
-	}
+	h->stats.n_malloc++;
+	if (k == FT_Z_LARGE)
+		return ft_heap_take_large(h, ft_zone_new_aligned(FT_Z_LARGE, need, FT_ALIGN, 1, h->arena));
 
 	/* TINY OR MIN */
 	t_zone* z = ft_zone_ll_first_with_space(*head);
 	if (!z) {
-		size_t bin_size = ft_bin_size_for_k(k);
-		size_t min_blocks = (k == FT_Z_TINY) ? g_heap.tiny_min_blocks : g_heap.small_min_blocks;
+		size_t bin_size = ft_bin_size_for_k(h, k);
+		size_t min_blocks = (k == FT_Z_TINY) ? h->tiny_min_blocks : h->small_min_blocks;
 
 		/* Overkill for subject requirement */
 		if (min_blocks < 100)
 			min_blocks = 100;
 
-		z = ft_zone_new(k, bin_size, min_blocks);
+		z = ft_zone_new_aligned(k, bin_size, FT_ALIGN, min_blocks, h->arena);
 		if (!z)
 			return NULL;
-		ft_ll_push_front(head, &z->link);
+		ft_heap_add_zone(h, z);
 	}
-	return ft_zone_alloc_block(z);
+	return ft_heap_take_block(h, z);
 }
 
-void ft_heap_free(void* p)
+/* give back a block whose owner zone is known */
+static void ft_heap_release(t_heap* h, t_zone* z, void* p)
 {
-	if (!p)
-		return;
-
-	t_zone* z = ft_heap_find_owner(p);
-	if (!z) {
-		return;
-	}
-
+	FT_PROBE2(free, p, z->klass);
 	if (z->klass == FT_Z_LARGE) {
 		// unlink & unmap whole LARGE zone
-		t_ll_node** head = list_for(FT_Z_LARGE);
-		ft_ll_remove(head, &z->link);
-		ft_zone_destroy(z);
+		ft_heap_count_free(h, z);
+		ft_heap_drop_zone(h, z);
 		return;
 	}
 
 	// slab: return block
+	size_t before = z->free_count;
 	ft_zone_free_block(z, p);
+	if (z->free_count == before)
+		return; // not a live block start
+	ft_heap_count_free(h, z);
 
 	if (z->free_count == z->capacity) {
-		t_ll_node** head = list_for(z->klass);
+		t_ll_node** head = list_for(h, z->klass);
+		h->stats.classes[z->klass].retained_bytes += (int64_t)ft_zone_mapped_bytes(z);
 		// Keep at least one empty slab per class to avoid churn
-		if (ft_ll_len(head) > 1) {
-			ft_ll_remove(head, &z->link);
-			ft_zone_destroy(z);
-		}
+		if (ft_ll_len(head) > 1)
+			ft_heap_drop_zone(h, z);
 		// else: leave the single empty slab in the list
 	}
 }
 
-void* ft_heap_realloc(void* p, size_t n)
+static void ft_heap_dealloc_locked(t_heap* h, void* p)
+{
+	h->stats.n_free++;
+	t_zone* z = ft_heap_find_owner(h, p);
+	if (!z) {
+		h->stats.n_invalid_free++;
+		return;
+	}
+	ft_heap_release(h, z, p);
+}
+
+void* ft_heap_alloc(ft_heap_t* h, size_t n)
+{
+	if (!h)
+		return NULL;
+
+	ft_heap_lock(h);
+	void* p = ft_heap_alloc_locked(h, n);
+	ft_heap_unlock(h);
+	FT_PROBE3(malloc, n, g_heap_op_note.klass, p);
+	return p;
+}
+
+void ft_heap_dealloc(ft_heap_t* h, void* p)
+{
+	if (!h || !p)
+		return;
+
+	ft_heap_lock(h);
+	ft_heap_dealloc_locked(h, p);
+	ft_heap_unlock(h);
+}
+
+void ft_heap_dealloc_sized(t_heap* h, void* p, size_t n, size_t align)
 {
+	if (!h || !p)
+		return;
+
+	ft_heap_lock(h);
+	h->stats.n_free++;
+	/* the size names the class: only the zones of h in that class are
+	 * searched, nothing is read at p; a wrong size falls back */
+	t_zone_class k = ft_heap_classify_aligned(h, n, align);
+	t_zone* z = ft_zone_ll_find_container_of(h->zls[k], p);
+	if (!z)
+		z = ft_heap_find_owner(h, p);
+	if (z)
+		ft_heap_release(h, z, p);
+	else
+		h->stats.n_invalid_free++;
+	ft_heap_unlock(h);
+}
+
+static void* ft_heap_alloc_aligned_locked(t_heap* h, size_t align, size_t n)
+{
+	if (align <= FT_ALIGN)
+		return ft_heap_alloc_locked(h, n);
+
+	size_t need = ft_align_up(n ? n : 1, FT_ALIGN);
+	t_zone_class k = ft_heap_classify_aligned(h, n, align);
+	t_ll_node** head = list_for(h, k);
+	g_heap_op_note.klass = k;
+
+	h->stats.n_malloc++;
+	if (k == FT_Z_LARGE)
+		return ft_heap_take_large(h, ft_zone_new_aligned(FT_Z_LARGE, need, align, 1, h->arena));
+
+	t_zone* z = ft_zone_ll_first_with_space_aligned(*head, align);
+	if (!z) {
+		size_t min_blocks = (k == FT_Z_TINY) ? h->tiny_min_blocks : h->small_min_blocks;
+		if (min_blocks < 100)
+			min_blocks = 100;
+
+		z = ft_zone_new_aligned(k, ft_bin_size_for_k(h, k), align, min_blocks, h->arena);
+		if (!z)
+			return NULL;
+		ft_heap_add_zone(h, z);
+	}
+	return ft_heap_take_block(h, z);
+}
+
+void* ft_heap_alloc_aligned(t_heap* h, size_t align, size_t n)
+{
+	if (!h || !align || (align & (align - 1)))
+		return NULL;
+
+	ft_heap_lock(h);
+	void* p = ft_heap_alloc_aligned_locked(h, align, n);
+	ft_heap_unlock(h);
+	FT_PROBE3(malloc, n, g_heap_op_note.klass, p);
+	return p;
+}
+
+/* Move p (owned by z) to a block of 'need' bytes. A LARGE destination gets
+ * spare room once the block has moved to grow before, as much again as it
+ * needs: an append loop then moves O(log n) times instead of once per page. */
+static void* ft_heap_move(t_heap* h, t_zone* z, void* p, size_t need)
+{
+	void* np;
+
+	if (ft_heap_classify(h, need) == FT_Z_LARGE) {
+		size_t moves = (z->klass == FT_Z_LARGE) ? z->grow_moves : 0;
+		size_t room = need;
+		if (moves) {
+			size_t extra = (need < FT_GROW_MAX_HEADROOM) ? need : FT_GROW_MAX_HEADROOM;
+			room = (need <= SIZE_MAX - extra) ? need + extra : need;
+		}
+		h->stats.n_malloc++;
+		t_zone* nz = ft_zone_new_large_room(need, room, h->arena);
+		if (nz)
+			nz->grow_moves = moves + 1;
+		np = ft_heap_take_large(h, nz);
+	} else {
+		np = ft_heap_alloc_locked(h, need);
+	}
+	if (!np)
+		return NULL;
+
+	size_t to_copy = (z->bin_size < need) ? z->bin_size : need;
+	ft_memcpy(np, p, to_copy);
+	ft_heap_dealloc_locked(h, p);
+	return np;
+}
+
+/* LARGE payload cut to 'need' bytes, whole pages past it unmapped when they
+ * add up to min_release at least. Returns the bytes unmapped. */
+static size_t ft_heap_trim_large(t_heap* h, t_zone* z, size_t need, size_t min_release)
+{
+	ft_class_stats_t* cs = &h->stats.classes[FT_Z_LARGE];
+	size_t old = z->bin_size;
+	size_t released = ft_zone_large_trim(z, need, min_release);
+
+	if (z->bin_size != old)
+		cs->live_bytes -= (int64_t)(old - need);
+	/* a same-size trim can still unmap the headroom of a grown block */
+	if (released)
+		cs->mapped_bytes -= (int64_t)released;
+	return released;
+}
+
+/* Shrink policy: the block stays where it is unless that pins real memory.
+ * - slab: moves to a smaller class whose bin is FT_SHRINK_RATIO times smaller;
+ * - LARGE: moves to a slab if that frees FT_SHRINK_MIN_SAVING bytes, else the
+ *   pages past the new end are unmapped if there are that many.
+ * A move that cannot get memory keeps the block: shrinking never fails. */
+static void* ft_heap_shrink(t_heap* h, t_zone* z, void* p, size_t need)
+{
+	t_zone_class k = ft_heap_classify(h, need);
+	void* np = NULL;
+
+	if (z->klass != FT_Z_LARGE) {
+		if (k < z->klass && ft_bin_size_for_k(h, k) * FT_SHRINK_RATIO <= z->bin_size)
+			np = ft_heap_move(h, z, p, need);
+		return np ? np : p;
+	}
+	if (k != FT_Z_LARGE &&
+		ft_zone_mapped_bytes(z) >= ft_bin_size_for_k(h, k) + FT_SHRINK_MIN_SAVING)
+		np = ft_heap_move(h, z, p, need);
+	if (np)
+		return np;
+	ft_heap_trim_large(h, z, need, FT_SHRINK_MIN_SAVING);
+	return p;
+}
+
+static void* ft_heap_reallocate_locked(t_heap* h, void* p, size_t n)
+{
+	h->stats.n_realloc++;
 	if (!p)
-		return ft_heap_malloc(n);
+		return ft_heap_alloc_locked(h, n);
 	if (n == 0) {
-		ft_heap_free(p);
+		ft_heap_dealloc_locked(h, p);
 		return NULL;
 	}
 
-	t_zone* z = ft_heap_find_owner(p);
+	t_zone* z = ft_heap_find_owner(h, p);
 	if (!z) {
 		return NULL;
 	}
+	g_heap_op_note.klass = z->klass;
 
 	size_t req = n ? n : 1;
 	size_t need = ft_align_up(req, FT_ALIGN);
 
-	if (z->klass != FT_Z_LARGE) {
-		// If it still fits in this slab block, keep it
-		if (need <= z->bin_size)
-			return p;
-
-		// Grow: allocate new, copy min(old,new), free old
-		void* np = ft_heap_malloc(need);
-		if (!np)
-			return NULL;
+	if (need <= z->bin_size)
+		return ft_heap_shrink(h, z, p, need);
 
-		size_t to_copy = (z->bin_size < need) ? z->bin_size : need;
-		ft_memcpy(np, p, to_copy);
-		ft_heap_free(p);
-		return np;
+	// LARGE: grow in place into the rest of the mapping
+	size_t old = z->bin_size;
+	if (z->klass == FT_Z_LARGE && ft_zone_large_resize(z, need) == 0) {
+		h->stats.classes[FT_Z_LARGE].live_bytes += (int64_t)(need - old);
+		return p;
 	}
 
-	// LARGE: keep if shrinking, otherwise move
-	if (need <= z->bin_size)
-		return p;
+	// Grow: allocate new, copy min(old,new), free old
+	return ft_heap_move(h, z, p, need);
+}
 
-	void* np = ft_heap_malloc(need);
-	if (!np)
+void* ft_heap_reallocate(ft_heap_t* h, void* p, size_t n)
+{
+	if (!h)
 		return NULL;
 
-	size_t to_copy = (z->bin_size < need) ? z->bin_size : need;
-	ft_memcpy(np, p, to_copy);
-	ft_heap_free(p);
+	ft_heap_lock(h);
+	void* np = ft_heap_reallocate_locked(h, p, n);
+	ft_heap_unlock(h);
+	FT_PROBE4(realloc, p, n, g_heap_op_note.klass, np);
 	return np;
 }
 
+size_t ft_heap_resize_in_place(ft_heap_t* h, void* p, size_t n)
+{
+	if (!h || !p)
+		return 0;
+
+	size_t need = ft_align_up(n ? n : 1, FT_ALIGN);
+	ft_heap_lock(h);
+	t_zone* z = ft_heap_find_owner(h, p);
+	size_t usable = 0;
+	if (z && z->klass == FT_Z_LARGE) {
+		size_t old = z->bin_size;
+		if (need < old)
+			ft_heap_trim_large(h, z, need, 0);
+		else if (need > old && ft_zone_large_resize(z, need) == 0)
+			h->stats.classes[FT_Z_LARGE].live_bytes += (int64_t)(need - old);
+	}
+	if (z)
+		usable = z->bin_size;
+	ft_heap_unlock(h);
+	return usable;
+}
+
+/* ---- default instance ---- */
+
+void* ft_heap_malloc(size_t n)
+{
+	return ft_heap_alloc(&g_heap, n);
+}
+
+void ft_heap_free(void* p)
+{
+	ft_heap_dealloc(&g_heap, p);
+}
+
+void* ft_heap_realloc(void* p, size_t n)
+{
+	return ft_heap_reallocate(&g_heap, p, n);
+}
+
+size_t ft_resize_in_place(void* p, size_t n)
+{
+	return ft_heap_resize_in_place(&g_heap, p, n);
+}
+
 /* ---- helpers (tested) ---- */
 
-t_zone_class ft_heap_classify(size_t n)
+t_zone_class ft_heap_classify(const t_heap* h, size_t n)
+{
+	return ft_zone_class_for(n, h->tiny_bin_size, h->small_bin_size);
+}
+
+t_zone_class ft_heap_classify_aligned(const t_heap* h, size_t n, size_t align)
 {
-	if (n == 0)
-		n = 1;
-	if (n <= g_heap.tiny_bin_size)
+	if (align <= FT_ALIGN)
+		return ft_heap_classify(h, n);
+
+	size_t need = ft_align_up(n ? n : 1, FT_ALIGN);
+	if (need <= h->tiny_bin_size && h->tiny_bin_size % align == 0)
 		return FT_Z_TINY;
-	if (n <= g_heap.small_bin_size)
+	if (need <= h->small_bin_size && h->small_bin_size % align == 0)
 		return FT_Z_SMALL;
 	return FT_Z_LARGE;
 }
 
-static inline size_t ft_bin_size_for_k(t_zone_class k)
+static inline size_t ft_bin_size_for_k(const t_heap* h, t_zone_class k)
 {
-	return (k == FT_Z_TINY) ? g_heap.tiny_bin_size : g_heap.small_bin_size;
+	return (k == FT_Z_TINY) ? h->tiny_bin_size : h->small_bin_size;
 }
 
-t_zone* ft_heap_find_owner(const void* p)
+t_zone* ft_heap_find_owner(const t_heap* h, const void* p)
 {
-	if (!p)
+	if (!h || !p)
 		return NULL;
 	for (size_t i = 0; i < N_ZONE_CATEGORIES; ++i) {
-		t_ll_node* head = g_heap.zls[i];
+		t_ll_node* head = h->zls[i];
 		t_zone* z = ft_zone_ll_find_container_of(head, p);
 		if (z)
 			return z;
@@ -201,18 +532,19 @@ t_zone* ft_heap_find_owner(const void* p)
 	return NULL;
 }
 
-size_t ft_heap_zone_count(t_zone_class klass)
+size_t ft_heap_zone_count(const t_heap* h, t_zone_class klass)
 {
-	return ft_ll_len(&g_heap.zls[klass]);
+	t_ll_node* head = h->zls[klass];
+	return ft_ll_len(&head);
 }
 
-size_t ft_heap_total_free_in_class(t_zone_class klass)
+size_t ft_heap_total_free_in_class(const t_heap* h, t_zone_class klass)
 {
 	if (klass == FT_Z_LARGE)
 		return 0;
 
 	size_t total = 0;
-	t_ll_node* head = g_heap.zls[klass];
+	t_ll_node* head = h->zls[klass];
 
 	FT_LL_FOR_EACH(it, head)
 	{
@@ -223,22 +555,163 @@ size_t ft_heap_total_free_in_class(t_zone_class klass)
 	return total;
 }
 
+void ft_heap_stats(const ft_heap_t* h, ft_malloc_stats_t* out)
+{
+	if (!out)
+		return;
+	*out = (ft_malloc_stats_t){0};
+	if (h) {
+		int locked = !ft_heap_frozen_by_self(h);
+		if (locked)
+			ft_heap_lock(h);
+		*out = h->stats;
+		if (locked)
+			ft_heap_unlock(h);
+	}
+	for (int k = 0; k < FT_STATS_NCLASSES; ++k) {
+		ft_class_stats_t* cs = &out->classes[k];
+		cs->wasted_bytes = cs->mapped_bytes - cs->live_bytes;
+	}
+}
+
+void ft_malloc_stats(ft_malloc_stats_t* out)
+{
+	ft_heap_stats(&g_heap, out);
+}
+
+void ft_malloc_stats_diff(const ft_malloc_stats_t* before,
+						  const ft_malloc_stats_t* after,
+						  ft_malloc_stats_t* out)
+{
+	if (!before || !after || !out)
+		return;
+
+	for (int k = 0; k < FT_STATS_NCLASSES; ++k) {
+		const ft_class_stats_t* a = &before->classes[k];
+		const ft_class_stats_t* b = &after->classes[k];
+		ft_class_stats_t* d = &out->classes[k];
+
+		d->n_alloc = b->n_alloc - a->n_alloc;
+		d->n_free = b->n_free - a->n_free;
+		d->live_blocks = b->live_blocks - a->live_blocks;
+		d->live_bytes = b->live_bytes - a->live_bytes;
+		d->mapped_bytes = b->mapped_bytes - a->mapped_bytes;
+		d->retained_bytes = b->retained_bytes - a->retained_bytes;
+		d->wasted_bytes = b->wasted_bytes - a->wasted_bytes;
+		d->zones = b->zones - a->zones;
+	}
+	out->n_malloc = after->n_malloc - before->n_malloc;
+	out->n_free = after->n_free - before->n_free;
+	out->n_realloc = after->n_realloc - before->n_realloc;
+	out->n_invalid_free = after->n_invalid_free - before->n_invalid_free;
+	out->n_mmap = after->n_mmap - before->n_mmap;
+	out->n_munmap = after->n_munmap - before->n_munmap;
+	out->trimmed_bytes = after->trimmed_bytes - before->trimmed_bytes;
+}
+
 // pick the right list by class using enum as an index
-static inline t_ll_node** list_for(t_zone_class k)
+static inline t_ll_node** list_for(t_heap* h, t_zone_class k)
+{
+	return &h->zls[(int)k];
+}
+
+static size_t ft_heap_trim_locked(t_heap* h, size_t pad)
+{
+	size_t released = 0;
+	size_t kept = 0;
+
+	for (int k = FT_Z_TINY; k <= FT_Z_SMALL; ++k) {
+		t_ll_node** head = list_for(h, (t_zone_class)k);
+
+		FT_LL_FOR_EACH_SAFE(it, tmp, *head)
+		{
+			t_zone* z = FT_CONTAINER_OF(it, t_zone, link);
+
+			if (z->free_count != z->capacity) {
+				released += ft_zone_release_free_pages(z);
+				continue;
+			}
+
+			size_t bytes = ft_zone_mapped_bytes(z);
+			if (kept + bytes <= pad) {
+				kept += bytes;
+				continue;
+			}
+			ft_heap_drop_zone(h, z);
+			released += bytes;
+		}
+	}
+	h->stats.trimmed_bytes += released;
+	return released;
+}
+
+size_t ft_heap_trim(t_heap* h, size_t pad)
+{
+	ft_heap_lock(h);
+	size_t released = ft_heap_trim_locked(h, pad);
+	ft_heap_unlock(h);
+	return released;
+}
+
+const char* ft_heap_class_label(t_zone_class klass)
+{
+	static const char* const labels[N_ZONE_CATEGORIES] = {"TINY", "SMALL", "LARGE"};
+	return (klass < N_ZONE_CATEGORIES) ? labels[klass] : "POOL";
+}
+
+static void ft_heap_put_total(t_ft_buf* b, size_t total)
 {
-	return &g_heap.zls[(int)k];
+	ft_buf_putstr(b, "Total : ");
+	ft_buf_putusize(b, total);
+	ft_buf_putstr(b, " bytes\n");
 }
 
-size_t ft_heap_show_alloc_mem(void)
+size_t ft_heap_show_alloc_mem(const t_heap* h)
 {
+	t_ft_buf b;
 	size_t total = 0;
 
-	total += ft_zone_ll_show_class("TINY", g_heap.zls[FT_Z_TINY]);
-	total += ft_zone_ll_show_class("SMALL", g_heap.zls[FT_Z_SMALL]);
-	total += ft_zone_ll_show_class("LARGE", g_heap.zls[FT_Z_LARGE]);
+	/* nothing is written until the lock is dropped */
+	ft_buf_init_capture(&b, 1);
+	int locked = !ft_heap_frozen_by_self(h);
+	if (locked)
+		ft_heap_lock(h);
+	for (int k = 0; k < N_ZONE_CATEGORIES; ++k)
+		total += ft_zone_ll_show_class_buf(&b, ft_heap_class_label((t_zone_class)k), h->zls[k]);
+	if (locked)
+		ft_heap_unlock(h);
+	ft_heap_put_total(&b, total);
+	ft_buf_flush(&b);
+	return total;
+}
+
+size_t ft_heap_show_alloc_mem_ex(const t_heap* h, const ft_show_filter_t* filter)
+{
+	t_zone_filter f = {0, UINTPTR_MAX, 0, 1};
+	unsigned classes = FT_SHOW_TINY | FT_SHOW_SMALL | FT_SHOW_LARGE;
+	if (filter) {
+		f.lo = (uintptr_t)filter->lo;
+		if (filter->hi)
+			f.hi = (uintptr_t)filter->hi;
+		f.min_size = filter->min_size;
+		if (filter->classes)
+			classes = filter->classes;
+	}
+
+	t_ft_buf b;
+	size_t total = 0;
 
-	ft_putstr("Total : ");
-	ft_putusize(total);
-	ft_putstr(" bytes\n");
+	/* nothing is written until the lock is dropped */
+	ft_buf_init_capture(&b, 1);
+	int locked = !ft_heap_frozen_by_self(h);
+	if (locked)
+		ft_heap_lock(h);
+	for (int k = 0; k < N_ZONE_CATEGORIES; ++k)
+		if (classes & (1u << k))
+			total += ft_zone_ll_show_filtered(&b, ft_heap_class_label((t_zone_class)k), h->zls[k], &f);
+	if (locked)
+		ft_heap_unlock(h);
+	ft_heap_put_total(&b, total);
+	ft_buf_flush(&b);
 	return total;
 }
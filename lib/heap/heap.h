@@ -13,7 +13,10 @@
 #ifndef FT_HEAP_H
 #define FT_HEAP_H
 
+#include <pthread.h>
 #include <stddef.h>
+#include <stdint.h>
+#include "malloc.h" /* public ft_heap_* API */
 #include "zone/zone.h"
 #include "zone/zone_list.h"
 #include "data_structures/linked_list.h"
@@ -31,12 +34,27 @@ extern "C" {
 
 #define N_ZONE_CATEGORIES 3
 
+/* Cap on the spare room a growing realloc reserves past the request. */
+#define FT_GROW_MAX_HEADROOM ((size_t)256 << 20)
+
+/* A shrinking realloc moves a slab block to a class with bins this many times
+ * smaller, and a LARGE block when the move (or unmapping its tail) frees at
+ * least FT_SHRINK_MIN_SAVING bytes. */
+#define FT_SHRINK_RATIO 4
+#define FT_SHRINK_MIN_SAVING ((size_t)16 << 10)
+
 /* Minimal front-end manager:
  * - tiny  : slab zones (various bin sizes)
  * - small : slab zones (various bin sizes)
  * - large : capacity-1 zones
+ *
+ * Several heaps can live side by side; each owns its zones and nothing is
+ * shared between them. g_heap is the instance behind malloc/free/realloc.
+ * Every public entry point runs under 'lock'; the tested helpers do not lock.
  */
 typedef struct s_heap {
+	pthread_mutex_t lock;
+
 	t_ll_node* zls[N_ZONE_CATEGORIES];
 
 	// NEW: bin sizes (one bin per class)
@@ -46,42 +64,174 @@ typedef struct s_heap {
 	// Number of blocks to pre-allocate in a slab (counts, not bytes)
 	size_t tiny_min_blocks;	 // e.g. 100
 	size_t small_min_blocks; // e.g. 100
+
+	// LARGE zone holding this descriptor (ft_heap_create), NULL for g_heap
+	t_zone* self;
+
+	// zones are carved from here (persistent heap), NULL: each zone is an mmap
+	t_zone_arena* arena;
+
+	// while a thread holds 'lock' through ft_heap_disable(): how many
+	// ft_heap_enable() calls release it (the freezing thread may nest)
+	int frozen;
+	pthread_t frozen_by;
+
+	// always-on counters, read through ft_heap_stats()
+	ft_malloc_stats_t stats;
 } t_heap;
-/* Global heap state (define in heap.c) */
-extern t_heap g_heap;
 
-/* Init all lists empty + set min_blocks knobs. */
-void ft_heap_init(size_t tiny_min_blocks, size_t small_min_blocks);
+typedef ft_heap_config_t t_heap_config;
 
-/* Unmap every zone in tiny/small/large and reset to init state. */
-void ft_heap_destroy(void);
+#define FT_HEAP_DEFAULT_INIT                                                                       \
+	{                                                                                              \
+		.lock = PTHREAD_MUTEX_INITIALIZER, .tiny_bin_size = TINY_BIN_SIZE,                         \
+		.small_bin_size = SMALL_BIN_SIZE, .tiny_min_blocks = TINY_N_BLOCKS,                        \
+		.small_min_blocks = SMALL_N_BLOCKS,                                                        \
+	}
 
-/* Allocator entry points (used by tests and wired by your malloc.c) */
+/* Global heap state (define in heap.c), statically initialized so malloc works
+ * before any constructor has run. */
+extern t_heap g_heap;
+
+/* What the calling thread's last heap operation did, for lib/latency:
+ * zone_events counts the zones it mapped or unmapped so far, klass is the
+ * class of the block last handed out, given back or resized (for a failed
+ * allocation, the class it asked for). Written under the heap lock, read
+ * after it by the same thread: the probes and lib/latency. */
+typedef struct s_heap_op_note {
+	uint32_t zone_events;
+	uint32_t klass;
+} t_heap_op_note;
+
+extern __thread t_heap_op_note g_heap_op_note __attribute__((tls_model("initial-exec")));
+
+/* Readers take the lock too, through a const heap. */
+static inline void ft_heap_lock(const t_heap* h)
+{
+	pthread_mutex_lock((pthread_mutex_t*)&h->lock);
+}
+
+static inline void ft_heap_unlock(const t_heap* h)
+{
+	pthread_mutex_unlock((pthread_mutex_t*)&h->lock);
+}
+
+/* True if the calling thread froze h with ft_heap_disable(): it already holds
+ * the lock and may walk the heap without taking it again. */
+static inline int ft_heap_frozen_by_self(const t_heap* h)
+{
+	return __atomic_load_n(&h->frozen, __ATOMIC_ACQUIRE) &&
+		   pthread_equal(h->frozen_by, pthread_self());
+}
+
+/* Init all lists empty + set bin sizes (0 = default); min_blocks get defaults. */
+void ft_heap_init(t_heap* h, size_t tiny_bin_size, size_t small_bin_size);
+
+/* Replace the bin sizes (multiples of FT_ALIGN, tiny < small <=
+ * FT_SIZEHIST_MAX) of a heap without slab zones: a zone keeps the bin size it
+ * was mapped with, and would hand its blocks to requests of the new class.
+ * Returns 0, or -1 with errno EINVAL (bad sizes) or EBUSY (slab zones). */
+int ft_heap_set_bins(t_heap* h, size_t tiny_bin_size, size_t small_bin_size);
+
+/* Instance lifecycle (public, see malloc.h):
+ * ft_heap_create() maps a new heap from config (NULL or 0 fields = defaults),
+ * ft_heap_destroy() unmaps every zone in tiny/small/large; a created heap is
+ * released entirely, g_heap is reset to its init state. */
+
+/* Allocator entry points on an instance (public): ft_heap_alloc, ft_heap_dealloc,
+ * ft_heap_reallocate. The g_heap shorthands below are wired by malloc.c. */
 void* ft_heap_malloc(size_t n);
 void ft_heap_free(void* p);
 void* ft_heap_realloc(void* p, size_t n);
 
+/* Aligned allocation ('align' is a power of two). A slab class serves it when
+ * its bin size is a multiple of align; the block then comes from a slab whose
+ * blocks are all aligned. Otherwise a LARGE zone with an aligned payload. */
+void* ft_heap_alloc_aligned(t_heap* h, size_t align, size_t n);
+
+/* Free knowing the size (and alignment, 0 if none) the block was requested
+ * with: only the zones of h in the class that request maps to are searched.
+ * A wrong hint costs a full lookup; a block of another heap, or not from this
+ * allocator, is counted in n_invalid_free as ft_heap_dealloc() does. */
+void ft_heap_dealloc_sized(t_heap* h, void* p, size_t n, size_t align);
+
 /* ---- helpers (tested) ---- */
 
-/* Classify request into TINY/SMALL/LARGE.
- * Pick sane defaults in heap.c (e.g., TINY_MAX=128, SMALL_MAX=4096). */
-t_zone_class ft_heap_classify(size_t n);
+/* Classify request into TINY/SMALL/LARGE using the heap's bin sizes. */
+t_zone_class ft_heap_classify(const t_heap* h, size_t n);
+
+/* Class an aligned request lands in (align <= FT_ALIGN: ft_heap_classify). */
+t_zone_class ft_heap_classify_aligned(const t_heap* h, size_t n, size_t align);
 
 /* Find which zone owns 'p' by scanning tiny/small/large lists.
  * Return NULL if not found. */
-t_zone* ft_heap_find_owner(const void* p);
+t_zone* ft_heap_find_owner(const t_heap* h, const void* p);
 
 /* Count zones in a class list. */
-size_t ft_heap_zone_count(t_zone_class klass);
+size_t ft_heap_zone_count(const t_heap* h, t_zone_class klass);
 
 /* Sum of free blocks across all slab zones in a class (LARGE excluded). */
-size_t ft_heap_total_free_in_class(t_zone_class klass);
-
-static inline t_ll_node** list_for(t_zone_class k);
-
-static inline void ll_unlink(t_ll_node** head, t_ll_node* node);
-
-size_t ft_heap_show_alloc_mem(void);
+size_t ft_heap_total_free_in_class(const t_heap* h, t_zone_class klass);
+
+/* "TINY", "SMALL" or "LARGE". */
+const char* ft_heap_class_label(t_zone_class klass);
+
+/* Dump every used block, class by class, zones in address order. Output is
+ * rendered into a stack buffer and reaches stdout in a few large writes.
+ * Returns the bytes listed. */
+size_t ft_heap_show_alloc_mem(const t_heap* h);
+
+/* Filtered, coalescing variant (see show_alloc_mem_ex in malloc.h). */
+size_t ft_heap_show_alloc_mem_ex(const t_heap* h, const ft_show_filter_t* filter);
+
+/* Give memory back to the OS:
+ * - empty slab zones are unmapped, except up to 'pad' bytes of them which are
+ *   kept around to absorb the next burst;
+ * - in partially used slabs, page-aligned runs of free blocks are released with
+ *   madvise(MADV_DONTNEED) (the mapping stays valid, pages refault as zeroes).
+ * Returns the number of bytes returned to the OS. */
+size_t ft_heap_trim(t_heap* h, size_t pad);
+
+/* ---- snapshots (heap_snapshot.c) ----
+ * One scratch mapping per snapshot: the header, then one record per TINY and
+ * SMALL zone, class by class, each class in address order. LARGE zones only
+ * feed classes[FT_Z_LARGE] and the size buckets. */
+#define FT_SNAP_LARGE_BUCKETS 64
+
+typedef struct s_snap_zone {
+	uintptr_t addr;
+	size_t bin_size;
+	size_t capacity;
+	size_t used; /* blocks in use */
+	size_t mapped;
+} t_snap_zone;
+
+typedef struct s_snap_class {
+	size_t zones;
+	size_t capacity;
+	size_t used;
+	size_t live_bytes;
+	size_t mapped_bytes;
+	size_t first; /* index of the class's first record in zones[] */
+} t_snap_class;
+
+typedef struct s_snap_bucket {
+	size_t count;
+	size_t bytes; /* payload bytes */
+} t_snap_bucket;
+
+struct s_heap_snapshot {
+	size_t map_bytes; /* length of this mapping */
+	t_snap_class classes[N_ZONE_CATEGORIES];
+	t_snap_bucket large[FT_SNAP_LARGE_BUCKETS]; /* by floor(log2(payload)) */
+	size_t n_zones;
+	t_snap_zone zones[];
+};
+
+static inline size_t ft_snap_large_bucket(size_t payload)
+{
+	return payload ? 63u - (size_t)__builtin_clzll((unsigned long long)payload) : 0;
+}
 
 #ifdef __cplusplus
 } /* extern "C" */
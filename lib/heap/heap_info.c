@@ -0,0 +1,330 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   heap_info.c                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/10 10:12:41 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/10 10:12:41 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "heap.h"
+#include "zone/zone_list.h"
+#include "helpers/helpers.h"
+
+/* Summary of a zone or a set of zones. Everything is derived from the zones
+ * themselves so the report is consistent with what show_alloc_mem prints. */
+typedef struct s_info_sum {
+	size_t zones;
+	size_t empty_zones; /* slabs with every block free (retained) */
+	size_t capacity;
+	size_t free;
+	size_t free_bytes;
+	size_t mapped;
+	size_t live;
+	size_t retained;
+} t_info_sum;
+
+/* One zone as it was when the report was gathered. */
+typedef struct s_info_zone {
+	const void* addr;
+	size_t bin_size;
+	t_info_sum s;
+} t_info_zone;
+
+/* Everything the report prints, copied out under the heap lock so that the
+ * formatting and the write(2) calls happen after it is released. Zones of
+ * class k are zones[first[k]] .. zones[first[k + 1] - 1], in address order. */
+typedef struct s_info_snap {
+	size_t bin[N_ZONE_CATEGORIES];
+	t_info_sum cls[N_ZONE_CATEGORIES];
+	t_info_zone* zones; /* scratch mapping of map_bytes */
+	size_t map_bytes;
+	size_t first[N_ZONE_CATEGORIES + 1];
+} t_info_snap;
+
+typedef struct s_info_out {
+	t_ft_buf b;
+	int format;
+	int first; /* no separator before the first JSON array element */
+} t_info_out;
+
+static void ft_info_add_zone(t_info_sum* s, const t_zone* z)
+{
+	size_t mapped = ft_zone_mapped_bytes(z);
+	size_t used = z->capacity - z->free_count;
+
+	s->zones++;
+	s->capacity += z->capacity;
+	s->free += z->free_count;
+	s->free_bytes += z->free_count * z->bin_size;
+	s->mapped += mapped;
+	s->live += used * z->bin_size;
+	if (z->klass != FT_Z_LARGE && used == 0) {
+		s->empty_zones++;
+		s->retained += mapped;
+	}
+}
+
+static void ft_info_add(t_info_sum* dst, const t_info_sum* s)
+{
+	dst->zones += s->zones;
+	dst->empty_zones += s->empty_zones;
+	dst->capacity += s->capacity;
+	dst->free += s->free;
+	dst->free_bytes += s->free_bytes;
+	dst->mapped += s->mapped;
+	dst->live += s->live;
+	dst->retained += s->retained;
+}
+
+static void ft_info_take_zone(t_info_snap* snap, size_t* i, t_zone_class k, const t_zone* z)
+{
+	t_info_zone* r = &snap->zones[(*i)++];
+
+	r->addr = z;
+	r->bin_size = z->bin_size;
+	r->s = (t_info_sum){0};
+	ft_info_add_zone(&r->s, z);
+	ft_info_add(&snap->cls[k], &r->s);
+}
+
+/* Copy what the report needs out of the heap (call with it locked).
+ * Returns 0, or -1 if no scratch memory could be had for the zone records. */
+static int ft_info_gather(t_info_snap* snap, const t_heap* h)
+{
+	size_t n = 0, i = 0;
+
+	*snap = (t_info_snap){0};
+	snap->bin[FT_Z_TINY] = h->tiny_bin_size;
+	snap->bin[FT_Z_SMALL] = h->small_bin_size;
+	for (int k = 0; k < N_ZONE_CATEGORIES; ++k) {
+		t_ll_node* head = h->zls[k];
+		n += ft_ll_len(&head);
+	}
+	if (n) {
+		snap->map_bytes = ft_align_up(n * sizeof(t_info_zone), ft_page_size());
+		snap->zones = ft_scratch_map(snap->map_bytes);
+		if (!snap->zones)
+			return -1;
+	}
+	for (int k = 0; k < N_ZONE_CATEGORIES; ++k) {
+		t_zone** v;
+		size_t nv = ft_zone_ll_sorted(h->zls[k], &v);
+
+		snap->first[k] = i;
+		if (v) {
+			for (size_t j = 0; j < nv; ++j)
+				ft_info_take_zone(snap, &i, (t_zone_class)k, v[j]);
+			ft_zone_ll_sorted_release(v, nv);
+		} else {
+			FT_LL_FOR_EACH(it, h->zls[k])
+			{
+				ft_info_take_zone(snap, &i, (t_zone_class)k, FT_CONTAINER_OF(it, t_zone, link));
+			}
+		}
+	}
+	snap->first[N_ZONE_CATEGORIES] = i;
+	return 0;
+}
+
+/* (mapped - live) / mapped with 4 decimals, without floating point */
+static void ft_info_put_ratio(t_ft_buf* b, size_t live, size_t mapped)
+{
+	size_t e4 = (mapped && live < mapped) ? (mapped - live) * 10000 / mapped : 0;
+	ft_buf_putusize(b, e4 / 10000);
+	ft_buf_putc(b, '.');
+	for (size_t d = 1000; d; d /= 10)
+		ft_buf_putc(b, (char)('0' + (e4 / d) % 10));
+}
+
+static void ft_info_key(t_ft_buf* b, const char* key, size_t v)
+{
+	ft_buf_putstr(b, ",\"");
+	ft_buf_putstr(b, key);
+	ft_buf_putstr(b, "\":");
+	ft_buf_putusize(b, v);
+}
+
+static void ft_info_attr(t_ft_buf* b, const char* key, size_t v)
+{
+	ft_buf_putc(b, ' ');
+	ft_buf_putstr(b, key);
+	ft_buf_putstr(b, "=\"");
+	ft_buf_putusize(b, v);
+	ft_buf_putc(b, '"');
+}
+
+static void ft_info_xml_total(t_ft_buf* b, const char* elem, const char* type, size_t count,
+							  size_t size, int with_count)
+{
+	ft_buf_putc(b, '<');
+	ft_buf_putstr(b, elem);
+	ft_buf_putstr(b, " type=\"");
+	ft_buf_putstr(b, type);
+	ft_buf_putc(b, '"');
+	if (with_count)
+		ft_info_attr(b, "count", count);
+	ft_info_attr(b, "size", size);
+	ft_buf_putstr(b, "/>\n");
+}
+
+static void ft_info_zone(t_info_out* o, const t_info_zone* z)
+{
+	const t_info_sum s = z->s;
+	t_ft_buf* b = &o->b;
+
+	if (o->format == FT_MALLOC_INFO_JSON) {
+		ft_buf_putstr(b, o->first ? "\n    {\"addr\":\"" : ",\n    {\"addr\":\"");
+		ft_buf_puthex_ptr(b, z->addr);
+		ft_buf_putc(b, '"');
+		ft_info_key(b, "capacity", s.capacity);
+		ft_info_key(b, "free", s.free);
+		ft_info_key(b, "bin_size", z->bin_size);
+		ft_info_key(b, "mapped_bytes", s.mapped);
+		ft_info_key(b, "live_bytes", s.live);
+		ft_buf_putstr(b, ",\"fragmentation\":");
+		ft_info_put_ratio(b, s.live, s.mapped);
+		ft_buf_putc(b, '}');
+	} else {
+		ft_buf_putstr(b, "<zone addr=\"");
+		ft_buf_puthex_ptr(b, z->addr);
+		ft_buf_putc(b, '"');
+		ft_info_attr(b, "capacity", s.capacity);
+		ft_info_attr(b, "free", s.free);
+		ft_info_attr(b, "bin_size", z->bin_size);
+		ft_info_attr(b, "mapped", s.mapped);
+		ft_info_attr(b, "live", s.live);
+		ft_info_attr(b, "empty", s.empty_zones);
+		ft_buf_putstr(b, " fragmentation=\"");
+		ft_info_put_ratio(b, s.live, s.mapped);
+		ft_buf_putstr(b, "\"/>\n");
+	}
+	o->first = 0;
+}
+
+static void ft_info_class_head(t_info_out* o, const t_info_snap* snap, t_zone_class k)
+{
+	t_ft_buf* b = &o->b;
+	const t_info_sum* s = &snap->cls[k];
+	size_t bin = snap->bin[k];
+
+	if (o->format == FT_MALLOC_INFO_JSON) {
+		ft_buf_putstr(b, (k == FT_Z_TINY) ? "\n  {\"class\":\"" : ",\n  {\"class\":\"");
+		ft_buf_putstr(b, ft_heap_class_label(k));
+		ft_buf_putc(b, '"');
+		ft_info_key(b, "bin_size", bin);
+		ft_info_key(b, "zones", s->zones);
+		ft_info_key(b, "empty_zones", s->empty_zones);
+		ft_info_key(b, "capacity", s->capacity);
+		ft_info_key(b, "free", s->free);
+		ft_info_key(b, "mapped_bytes", s->mapped);
+		ft_info_key(b, "live_bytes", s->live);
+		ft_info_key(b, "retained_bytes", s->retained);
+		ft_buf_putstr(b, ",\"fragmentation\":");
+		ft_info_put_ratio(b, s->live, s->mapped);
+		ft_buf_putstr(b, ",\"zone_list\":[");
+		return;
+	}
+	ft_buf_putstr(b, "<heap");
+	ft_info_attr(b, "nr", (size_t)k);
+	ft_buf_putstr(b, " class=\"");
+	ft_buf_putstr(b, ft_heap_class_label(k));
+	ft_buf_putstr(b, "\">\n<sizes>\n");
+	if (k != FT_Z_LARGE && s->free) {
+		ft_buf_putstr(b, "  <size");
+		ft_info_attr(b, "from", bin);
+		ft_info_attr(b, "to", bin);
+		ft_info_attr(b, "total", s->free_bytes);
+		ft_info_attr(b, "count", s->free);
+		ft_buf_putstr(b, "/>\n");
+	}
+	ft_buf_putstr(b, "</sizes>\n");
+	ft_info_xml_total(b, "total", "fast", 0, 0, 1);
+	ft_info_xml_total(b, "total", "rest", s->free, s->free_bytes, 1);
+	ft_info_xml_total(b, "total", "retained", s->empty_zones, s->retained, 1);
+	ft_info_xml_total(b, "system", "current", 0, s->mapped, 0);
+	ft_info_xml_total(b, "system", "max", 0, s->mapped, 0);
+	ft_info_xml_total(b, "aspace", "total", 0, s->mapped, 0);
+	ft_info_xml_total(b, "aspace", "mprotect", 0, s->mapped, 0);
+}
+
+/* class summary, then its zones in address order */
+static void ft_info_class(t_info_out* o, const t_info_snap* snap, t_zone_class k)
+{
+	ft_info_class_head(o, snap, k);
+	o->first = 1;
+	for (size_t i = snap->first[k]; i < snap->first[k + 1]; ++i)
+		ft_info_zone(o, &snap->zones[i]);
+	ft_buf_putstr(&o->b, (o->format == FT_MALLOC_INFO_JSON) ? "]}" : "</heap>\n");
+}
+
+static void ft_info_footer(t_info_out* o, const t_info_sum* t, const t_info_sum* large)
+{
+	t_ft_buf* b = &o->b;
+
+	if (o->format == FT_MALLOC_INFO_JSON) {
+		ft_buf_putstr(b, "\n],\"total\":{\"zones\":");
+		ft_buf_putusize(b, t->zones);
+		ft_info_key(b, "empty_zones", t->empty_zones);
+		ft_info_key(b, "mapped_bytes", t->mapped);
+		ft_info_key(b, "live_bytes", t->live);
+		ft_info_key(b, "retained_bytes", t->retained);
+		ft_buf_putstr(b, ",\"fragmentation\":");
+		ft_info_put_ratio(b, t->live, t->mapped);
+		ft_buf_putstr(b, "}}\n");
+		return;
+	}
+	/* glibc counts mmap'd chunks apart from the arenas: LARGE zones here */
+	ft_info_xml_total(b, "total", "fast", 0, 0, 1);
+	ft_info_xml_total(b, "total", "rest", t->free - large->free, t->free_bytes - large->free_bytes, 1);
+	ft_info_xml_total(b, "total", "mmap", large->zones, large->mapped, 1);
+	ft_info_xml_total(b, "system", "current", 0, t->mapped, 0);
+	ft_info_xml_total(b, "system", "max", 0, t->mapped, 0);
+	ft_info_xml_total(b, "aspace", "total", 0, t->mapped, 0);
+	ft_info_xml_total(b, "aspace", "mprotect", 0, t->mapped, 0);
+	ft_buf_putstr(b, "</malloc>\n");
+}
+
+int ft_heap_malloc_info(const ft_heap_t* h, int fd, int format)
+{
+	if (!h || (format != FT_MALLOC_INFO_JSON && format != FT_MALLOC_INFO_XML)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	t_info_out o;
+	t_info_snap snap;
+	t_info_sum total = {0};
+
+	int locked = !ft_heap_frozen_by_self(h);
+	if (locked)
+		ft_heap_lock(h);
+	int rc = ft_info_gather(&snap, h);
+	if (locked)
+		ft_heap_unlock(h);
+	if (rc != 0) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	ft_buf_init(&o.b, fd);
+	o.format = format;
+	ft_buf_putstr(&o.b, (format == FT_MALLOC_INFO_JSON) ? "{\"version\":1,\"classes\":["
+														 : "<malloc version=\"1\">\n");
+	for (int k = 0; k < N_ZONE_CATEGORIES; ++k) {
+		ft_info_class(&o, &snap, (t_zone_class)k);
+		ft_info_add(&total, &snap.cls[k]);
+	}
+	ft_info_footer(&o, &total, &snap.cls[FT_Z_LARGE]);
+	ft_buf_flush(&o.b);
+	ft_scratch_unmap(snap.zones, snap.map_bytes);
+	return 0;
+}
+
+int ft_malloc_info(int fd, int format)
+{
+	return ft_heap_malloc_info(&g_heap, fd, format);
+}
@@ -0,0 +1,105 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   heap_iterate.c                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/18 17:48:10 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/18 17:48:10 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "heap.h"
+
+/* ---------------- walk ---------------- */
+
+/* used blocks of z starting in [lo, hi) */
+static void ft_iterate_zone(const t_zone* z, uintptr_t lo, uintptr_t hi, ft_iterate_cb_t cb,
+							void* arg)
+{
+	uintptr_t mb = (uintptr_t)z->mem_begin;
+	uintptr_t me = (uintptr_t)z->mem_end;
+
+	if (me <= lo || mb >= hi)
+		return;
+	if (z->klass == FT_Z_LARGE) {
+		if (mb >= lo)
+			cb(mb, z->bin_size, arg);
+		return;
+	}
+	size_t i = (lo > mb) ? (lo - mb + z->bin_size - 1) / z->bin_size : 0;
+	size_t end = (hi < me) ? (hi - mb + z->bin_size - 1) / z->bin_size : z->capacity;
+	for (; i < end && i < z->capacity; ++i)
+		if (z->occ[i] == FT_OCC_USED)
+			cb(mb + i * z->bin_size, z->bin_size, arg);
+}
+
+int ft_heap_iterate(const ft_heap_t* h, uintptr_t base, size_t size, ft_iterate_cb_t cb, void* arg)
+{
+	if (!h || !cb) {
+		errno = EINVAL;
+		return -1;
+	}
+	uintptr_t hi = (size > UINTPTR_MAX - base) ? UINTPTR_MAX : base + size;
+	int locked = !ft_heap_frozen_by_self(h);
+
+	if (locked)
+		ft_heap_lock(h);
+	for (int k = 0; k < N_ZONE_CATEGORIES; ++k) {
+		FT_LL_FOR_EACH(it, h->zls[k])
+		{
+			ft_iterate_zone(FT_CONTAINER_OF(it, t_zone, link), base, hi, cb, arg);
+		}
+	}
+	if (locked)
+		ft_heap_unlock(h);
+	return 0;
+}
+
+int ft_malloc_iterate(uintptr_t base, size_t size, ft_iterate_cb_t cb, void* arg)
+{
+	return ft_heap_iterate(&g_heap, base, size, cb, arg);
+}
+
+/* ---------------- freeze ---------------- */
+
+/* Nested calls from the freezing thread (e.g. it forks, and the atfork
+ * handler freezes g_heap again) only count: the lock is not recursive. */
+void ft_heap_disable(ft_heap_t* h)
+{
+	if (ft_heap_frozen_by_self(h)) {
+		h->frozen++;
+		return;
+	}
+	ft_heap_lock(h);
+	h->frozen_by = pthread_self();
+	__atomic_store_n(&h->frozen, 1, __ATOMIC_RELEASE);
+}
+
+void ft_heap_enable(ft_heap_t* h)
+{
+	if (h->frozen > 1) {
+		h->frozen--;
+		return;
+	}
+	__atomic_store_n(&h->frozen, 0, __ATOMIC_RELEASE);
+	ft_heap_unlock(h);
+}
+
+void ft_malloc_disable(void)
+{
+	ft_heap_disable(&g_heap);
+}
+
+void ft_malloc_enable(void)
+{
+	ft_heap_enable(&g_heap);
+}
+
+/* A thread inside malloc when another one forks would leave the child with
+ * g_heap locked forever: hold the lock across fork() instead. */
+__attribute__((constructor)) static void ft_heap_register_atfork(void)
+{
+	pthread_atfork(ft_malloc_disable, ft_malloc_enable, ft_malloc_enable);
+}
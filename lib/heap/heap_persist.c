@@ -0,0 +1,213 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   heap_persist.c                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/19 18:52:10 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/19 18:52:10 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "heap.h"
+#include "zone/zone_arena.h"
+#include "helpers/helpers.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef EUCLEAN
+#define EUCLEAN EIO
+#endif
+
+#define FT_PHEAP_MAGIC "ftpheap1"
+#define FT_PHEAP_VERSION 2u /* 2: arena positions are offsets */
+
+/* First page(s) of a heap file. The heap and its arena are stored as is, and
+ * the zones they point to are in the same mapping at the same address, so the
+ * whole structure is valid again as soon as the file is mapped. */
+typedef struct s_pheap_file {
+	char magic[8];
+	uint64_t layout; /* FT_PHEAP_LAYOUT of the build that created the file */
+	uintptr_t base;
+	size_t size;
+	uint32_t attached; /* set while a process has the file open */
+	int fd;			   /* that process's descriptor */
+	void* root;
+	t_zone_arena arena;
+	t_heap heap;
+} t_pheap_file;
+
+/* struct sizes stand for their layout: a build that changed them refuses
+ * files of another */
+#define FT_PHEAP_LAYOUT                                                                            \
+	(((uint64_t)sizeof(t_pheap_file) << 32) | ((uint64_t)sizeof(t_zone) << 16) | FT_PHEAP_VERSION)
+
+static t_pheap_file* ft_pheap_of(const t_heap* h)
+{
+	if (!h || !h->arena)
+		return NULL;
+	t_pheap_file* pf = FT_CONTAINER_OF(h->arena, t_pheap_file, arena);
+	return (&pf->heap == h) ? pf : NULL;
+}
+
+/* the whole file at exactly 'base', never over an existing mapping */
+static t_pheap_file* ft_pheap_map(int fd, void* base, size_t size)
+{
+	int flags = MAP_SHARED;
+#ifdef MAP_FIXED_NOREPLACE
+	flags |= MAP_FIXED_NOREPLACE;
+#endif
+	void* p = mmap(base, size, PROT_READ | PROT_WRITE, flags, fd, 0);
+	if (p == MAP_FAILED)
+		return NULL;
+	if (p != base) { /* a kernel without MAP_FIXED_NOREPLACE took it as a hint */
+		munmap(p, size);
+		errno = EEXIST;
+		return NULL;
+	}
+	return (t_pheap_file*)p;
+}
+
+/* Validate the header of an existing file; fills base and size from it. */
+static int ft_pheap_check(int fd, off_t file_size, void** base, size_t* size)
+{
+	t_pheap_file disk;
+
+	if (pread(fd, &disk, sizeof disk, 0) != (ssize_t)sizeof disk ||
+		memcmp(disk.magic, FT_PHEAP_MAGIC, sizeof disk.magic) || disk.layout != FT_PHEAP_LAYOUT ||
+		(off_t)disk.size != file_size) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (disk.attached) {
+		errno = EUCLEAN;
+		return -1;
+	}
+	if (*base && (uintptr_t)*base != disk.base) {
+		errno = EINVAL;
+		return -1;
+	}
+	*base = (void*)disk.base;
+	*size = disk.size;
+	return 0;
+}
+
+static void ft_pheap_format(t_pheap_file* pf, size_t size, size_t hdr)
+{
+	memcpy(pf->magic, FT_PHEAP_MAGIC, sizeof pf->magic);
+	pf->layout = FT_PHEAP_LAYOUT;
+	pf->base = (uintptr_t)pf;
+	pf->size = size;
+	pf->root = NULL;
+	ft_heap_init(&pf->heap, 0, 0);
+	ft_zone_arena_init(&pf->arena, (char*)pf + hdr, size - hdr);
+	pf->heap.arena = &pf->arena;
+}
+
+ft_heap_t* ft_heap_open_file(const char* path, void* base, size_t size)
+{
+	const size_t ps = ft_page_size();
+	const size_t hdr = ft_align_up(sizeof(t_pheap_file), ps);
+	struct stat st;
+
+	if (!path || (uintptr_t)base % ps) {
+		errno = EINVAL;
+		return NULL;
+	}
+	int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+	if (fd < 0)
+		return NULL;
+	if (flock(fd, LOCK_EX | LOCK_NB)) {
+		if (errno == EWOULDBLOCK)
+			errno = EBUSY;
+		goto fail;
+	}
+	if (fstat(fd, &st))
+		goto fail;
+
+	const int fresh = (st.st_size == 0);
+	if (fresh) {
+		if (!base)
+			base = FT_PHEAP_BASE;
+		if (size > SIZE_MAX - ps || ft_align_up(size, ps) <= hdr) {
+			errno = EINVAL;
+			goto fail;
+		}
+		size = ft_align_up(size, ps);
+		if (ftruncate(fd, (off_t)size))
+			goto fail;
+	} else if (ft_pheap_check(fd, st.st_size, &base, &size)) {
+		goto fail;
+	}
+
+	t_pheap_file* pf = ft_pheap_map(fd, base, size);
+	if (!pf) {
+		if (fresh) {
+			int err = errno;
+			(void)ftruncate(fd, 0); /* leave it empty, not half made */
+			errno = err;
+		}
+		goto fail;
+	}
+	if (fresh) {
+		ft_pheap_format(pf, size, hdr);
+	} else {
+		/* process-local state: whatever the last process left is stale */
+		pthread_mutex_init(&pf->heap.lock, NULL);
+		pf->heap.frozen = 0;
+	}
+	pf->fd = fd;
+	pf->attached = 1;
+	return &pf->heap;
+
+fail:;
+	int err = errno;
+	close(fd);
+	errno = err;
+	return NULL;
+}
+
+int ft_heap_close_file(ft_heap_t* h)
+{
+	t_pheap_file* pf = ft_pheap_of(h);
+	if (!pf) {
+		errno = EINVAL;
+		return -1;
+	}
+	const int fd = pf->fd;
+	const size_t size = pf->size;
+
+	ft_heap_lock(h); /* let calls in flight finish */
+	pf->attached = 0;
+	pf->fd = -1;
+	ft_heap_unlock(h);
+
+	int rc = msync(pf, size, MS_SYNC);
+	munmap(pf, size);
+	close(fd);
+	return rc ? -1 : 0;
+}
+
+void* ft_heap_root(const ft_heap_t* h)
+{
+	t_pheap_file* pf = ft_pheap_of(h);
+	return pf ? __atomic_load_n(&pf->root, __ATOMIC_ACQUIRE) : NULL;
+}
+
+int ft_heap_set_root(ft_heap_t* h, void* root)
+{
+	t_pheap_file* pf = ft_pheap_of(h);
+	if (!pf) {
+		errno = EINVAL;
+		return -1;
+	}
+	__atomic_store_n(&pf->root, root, __ATOMIC_RELEASE);
+	return 0;
+}
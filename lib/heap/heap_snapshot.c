@@ -0,0 +1,259 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   heap_snapshot.c                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/18 15:20:33 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/18 15:20:33 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "heap.h"
+#include "zone/zone_list.h"
+#include "helpers/helpers.h"
+
+/* ---------------- taking a snapshot ---------------- */
+
+static void ft_snap_count(t_snap_class* c, const t_zone* z, size_t used, size_t mapped)
+{
+	c->zones++;
+	c->capacity += z->capacity;
+	c->used += used;
+	c->live_bytes += used * z->bin_size;
+	c->mapped_bytes += mapped;
+}
+
+/* slab class: one record per zone, in address order (the show_alloc_mem walk) */
+static int ft_snap_slab_class(ft_heap_snapshot_t* s, const t_heap* h, t_zone_class k)
+{
+	t_snap_class* c = &s->classes[k];
+	t_zone** v;
+	size_t n = ft_zone_ll_sorted(h->zls[k], &v);
+
+	if (h->zls[k] && !v)
+		return -1; /* records must be sorted for the diff to pair them */
+	c->first = s->n_zones;
+	for (size_t i = 0; i < n; ++i) {
+		t_snap_zone* r = &s->zones[s->n_zones++];
+		r->addr = (uintptr_t)v[i];
+		r->bin_size = v[i]->bin_size;
+		r->capacity = v[i]->capacity;
+		r->used = v[i]->capacity - v[i]->free_count;
+		r->mapped = ft_zone_mapped_bytes(v[i]);
+		ft_snap_count(c, v[i], r->used, r->mapped);
+	}
+	if (v)
+		ft_zone_ll_sorted_release(v, n);
+	return 0;
+}
+
+/* LARGE: folded into power-of-two buckets of payload size, no records */
+static void ft_snap_large(ft_heap_snapshot_t* s, const t_heap* h)
+{
+	s->classes[FT_Z_LARGE].first = s->n_zones;
+	FT_LL_FOR_EACH(it, h->zls[FT_Z_LARGE])
+	{
+		const t_zone* z = FT_CONTAINER_OF(it, t_zone, link);
+		t_snap_bucket* bk = &s->large[ft_snap_large_bucket(z->bin_size)];
+		size_t mapped = ft_zone_mapped_bytes(z);
+
+		bk->count++;
+		bk->bytes += z->bin_size;
+		ft_snap_count(&s->classes[FT_Z_LARGE], z, 1, mapped);
+	}
+}
+
+ft_heap_snapshot_t* ft_heap_snapshot(const ft_heap_t* h)
+{
+	if (!h) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	int locked = !ft_heap_frozen_by_self(h);
+	if (locked)
+		ft_heap_lock(h);
+	t_ll_node* tiny = h->zls[FT_Z_TINY];
+	t_ll_node* small = h->zls[FT_Z_SMALL];
+	size_t n = ft_ll_len(&tiny) + ft_ll_len(&small);
+	size_t bytes = sizeof(ft_heap_snapshot_t) + n * sizeof(t_snap_zone);
+	ft_heap_snapshot_t* s = (ft_heap_snapshot_t*)ft_scratch_map(bytes);
+
+	if (s) {
+		s->map_bytes = bytes;
+		if (ft_snap_slab_class(s, h, FT_Z_TINY) < 0 || ft_snap_slab_class(s, h, FT_Z_SMALL) < 0) {
+			ft_scratch_unmap(s, bytes);
+			s = NULL;
+		} else {
+			ft_snap_large(s, h);
+		}
+	}
+	if (locked)
+		ft_heap_unlock(h);
+	if (!s)
+		errno = ENOMEM;
+	return s;
+}
+
+ft_heap_snapshot_t* ft_malloc_snapshot(void)
+{
+	return ft_heap_snapshot(&g_heap);
+}
+
+void ft_heap_snapshot_free(ft_heap_snapshot_t* s)
+{
+	if (s)
+		ft_scratch_unmap(s, s->map_bytes);
+}
+
+/* ---------------- diff ---------------- */
+
+/* " (+12)", " (-12)" or " (=)" */
+static void ft_snap_put_delta(t_ft_buf* b, size_t before, size_t after)
+{
+	if (before == after) {
+		ft_buf_putstr(b, " (=)");
+		return;
+	}
+	ft_buf_putstr(b, after > before ? " (+" : " (-");
+	ft_buf_putusize(b, after > before ? after - before : before - after);
+	ft_buf_putc(b, ')');
+}
+
+/* " key a -> b (+d)" */
+static void ft_snap_put_change(t_ft_buf* b, const char* key, size_t before, size_t after)
+{
+	ft_buf_putc(b, ' ');
+	ft_buf_putstr(b, key);
+	ft_buf_putc(b, ' ');
+	ft_buf_putusize(b, before);
+	ft_buf_putstr(b, " -> ");
+	ft_buf_putusize(b, after);
+	ft_snap_put_delta(b, before, after);
+}
+
+static void ft_snap_diff_class(t_ft_buf* b, t_zone_class k, const t_snap_class* x,
+							   const t_snap_class* y)
+{
+	ft_buf_putstr(b, "class ");
+	ft_buf_putstr(b, ft_heap_class_label(k));
+	ft_snap_put_change(b, "zones", x->zones, y->zones);
+	ft_snap_put_change(b, "used", x->used, y->used);
+	ft_snap_put_change(b, "live", x->live_bytes, y->live_bytes);
+	ft_snap_put_change(b, "mapped", x->mapped_bytes, y->mapped_bytes);
+	ft_buf_putc(b, '\n');
+}
+
+/* "zone TINY + 0x... bin 128 used 12/128 mapped 20480" for a zone on one side */
+static void ft_snap_put_zone(t_ft_buf* b, t_zone_class k, char mark, const t_snap_zone* z)
+{
+	ft_buf_putstr(b, "zone ");
+	ft_buf_putstr(b, ft_heap_class_label(k));
+	ft_buf_putc(b, ' ');
+	ft_buf_putc(b, mark);
+	ft_buf_putc(b, ' ');
+	ft_buf_puthex_ptr(b, (const void*)z->addr);
+	ft_buf_putstr(b, " bin ");
+	ft_buf_putusize(b, z->bin_size);
+	ft_buf_putstr(b, " used ");
+	ft_buf_putusize(b, z->used);
+	ft_buf_putc(b, '/');
+	ft_buf_putusize(b, z->capacity);
+	ft_buf_putstr(b, " mapped ");
+	ft_buf_putusize(b, z->mapped);
+	ft_buf_putc(b, '\n');
+}
+
+static void ft_snap_put_zone_change(t_ft_buf* b, t_zone_class k, const t_snap_zone* x,
+									const t_snap_zone* y)
+{
+	ft_buf_putstr(b, "zone ");
+	ft_buf_putstr(b, ft_heap_class_label(k));
+	ft_buf_putstr(b, " ~ ");
+	ft_buf_puthex_ptr(b, (const void*)y->addr);
+	ft_buf_putstr(b, " bin ");
+	ft_buf_putusize(b, y->bin_size);
+	ft_snap_put_change(b, "used", x->used, y->used);
+	ft_buf_putc(b, '/');
+	ft_buf_putusize(b, y->capacity);
+	ft_buf_putc(b, '\n');
+}
+
+/* Merge the two address-ordered record runs of a class. A zone at the same
+ * address with another geometry is a new mapping: reported as gone + new. */
+static void ft_snap_diff_zones(t_ft_buf* b, t_zone_class k, const ft_heap_snapshot_t* a,
+							   const ft_heap_snapshot_t* c)
+{
+	const t_snap_zone* x = a->zones + a->classes[k].first;
+	const t_snap_zone* xe = x + a->classes[k].zones;
+	const t_snap_zone* y = c->zones + c->classes[k].first;
+	const t_snap_zone* ye = y + c->classes[k].zones;
+
+	while (x < xe || y < ye) {
+		if (y == ye || (x < xe && x->addr < y->addr)) {
+			ft_snap_put_zone(b, k, '-', x++);
+		} else if (x == xe || y->addr < x->addr) {
+			ft_snap_put_zone(b, k, '+', y++);
+		} else if (x->bin_size != y->bin_size || x->capacity != y->capacity) {
+			ft_snap_put_zone(b, k, '-', x++);
+			ft_snap_put_zone(b, k, '+', y++);
+		} else {
+			if (x->used != y->used)
+				ft_snap_put_zone_change(b, k, x, y);
+			++x;
+			++y;
+		}
+	}
+}
+
+static void ft_snap_diff_large(t_ft_buf* b, const ft_heap_snapshot_t* a,
+							   const ft_heap_snapshot_t* c)
+{
+	for (size_t i = 0; i < FT_SNAP_LARGE_BUCKETS; ++i) {
+		const t_snap_bucket* x = &a->large[i];
+		const t_snap_bucket* y = &c->large[i];
+		if (x->count == y->count && x->bytes == y->bytes)
+			continue;
+		ft_buf_putstr(b, "large 2^");
+		ft_buf_putusize(b, i);
+		ft_snap_put_change(b, "count", x->count, y->count);
+		ft_snap_put_change(b, "bytes", x->bytes, y->bytes);
+		ft_buf_putc(b, '\n');
+	}
+}
+
+int ft_heap_snapshot_diff(const ft_heap_snapshot_t* a, const ft_heap_snapshot_t* b, int fd)
+{
+	if (!a || !b) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	t_ft_buf out;
+	t_snap_class ta = {0};
+	t_snap_class tb = {0};
+
+	ft_buf_init(&out, fd);
+	for (int k = 0; k < N_ZONE_CATEGORIES; ++k) {
+		ft_snap_diff_class(&out, (t_zone_class)k, &a->classes[k], &b->classes[k]);
+		ta.zones += a->classes[k].zones;
+		ta.live_bytes += a->classes[k].live_bytes;
+		ta.mapped_bytes += a->classes[k].mapped_bytes;
+		tb.zones += b->classes[k].zones;
+		tb.live_bytes += b->classes[k].live_bytes;
+		tb.mapped_bytes += b->classes[k].mapped_bytes;
+	}
+	ft_buf_putstr(&out, "total");
+	ft_snap_put_change(&out, "zones", ta.zones, tb.zones);
+	ft_snap_put_change(&out, "live", ta.live_bytes, tb.live_bytes);
+	ft_snap_put_change(&out, "mapped", ta.mapped_bytes, tb.mapped_bytes);
+	ft_buf_putc(&out, '\n');
+
+	ft_snap_diff_zones(&out, FT_Z_TINY, a, b);
+	ft_snap_diff_zones(&out, FT_Z_SMALL, a, b);
+	ft_snap_diff_large(&out, a, b);
+	ft_buf_flush(&out);
+	return 0;
+}
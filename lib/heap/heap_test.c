@@ -1,6 +1,13 @@
 /* lib/heap/heap_test.c */
+#include <pthread.h>
 #include <stdint.h>
 #include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
 
 #include "munit.h"
 
@@ -14,14 +21,14 @@ static void* setup(const MunitParameter params[], void* user_data)
 {
 	(void)params; (void)user_data;
 	/* Your API: args are BIN sizes. */
-	ft_heap_init(TINY_BIN_SIZE, SMALL_BIN_SIZE);
+	ft_heap_init(&g_heap, TINY_BIN_SIZE, SMALL_BIN_SIZE);
 	return NULL;
 }
 
 static void teardown(void* fixture)
 {
 	(void)fixture;
-	ft_heap_destroy();
+	ft_heap_destroy(&g_heap);
 }
 
 /* ---------- helpers ---------- */
@@ -38,7 +45,7 @@ static t_zone* first_zone_of(t_zone_class k) {
 /* Accept either: (a) no zone (trimmed), or (b) one fully free slab. */
 static void assert_class_empty_or_fully_free(t_zone_class k)
 {
-	size_t n = ft_heap_zone_count(k);
+	size_t n = ft_heap_zone_count(&g_heap, k);
 	if (n == 0) return;
 	munit_assert_size(n, ==, 1);
 	t_zone* z = first_zone_of(k);
@@ -63,7 +70,7 @@ static MunitResult tiny_alloc_reuse_and_trim(const MunitParameter params[], void
 	munit_assert_true(is_aligned(b));
 	munit_assert_true(is_aligned(c));
 
-	munit_assert_size(ft_heap_zone_count(FT_Z_TINY), ==, 1);
+	munit_assert_size(ft_heap_zone_count(&g_heap, FT_Z_TINY), ==, 1);
 	t_zone* z = first_zone_of(FT_Z_TINY);
 	munit_assert_not_null(z);
 
@@ -94,7 +101,7 @@ static MunitResult small_alloc_zone_lifetime(const MunitParameter params[], void
 	void* p = ft_heap_malloc(small_req);
 	munit_assert_not_null(p);
 	munit_assert_true(is_aligned(p));
-	munit_assert_size(ft_heap_zone_count(FT_Z_SMALL), ==, 1);
+	munit_assert_size(ft_heap_zone_count(&g_heap, FT_Z_SMALL), ==, 1);
 
 	t_zone* z = first_zone_of(FT_Z_SMALL);
 	munit_assert_not_null(z);
@@ -114,7 +121,7 @@ static MunitResult large_alloc_shrink_grow(const MunitParameter params[], void*
 	uint8_t* p = (uint8_t*)ft_heap_malloc(big);
 	munit_assert_not_null(p);
 	munit_assert_true(is_aligned(p));
-	munit_assert_size(ft_heap_zone_count(FT_Z_LARGE), ==, 1);
+	munit_assert_size(ft_heap_zone_count(&g_heap, FT_Z_LARGE), ==, 1);
 
 	for (size_t i = 0; i < 256; ++i)
 		p[i] = (uint8_t)(0xA0 | (i & 0x0F));
@@ -123,15 +130,150 @@ static MunitResult large_alloc_shrink_grow(const MunitParameter params[], void*
 	uint8_t* q = (uint8_t*)ft_heap_realloc(p, big / 2);
 	munit_assert_ptr_equal(q, p);
 
-	/* Grow → new mapping */
-	uint8_t* r = (uint8_t*)ft_heap_realloc(q, big * 2);
+	/* Grow within the mapping's last page → same pointer */
+	t_zone* z = first_zone_of(FT_Z_LARGE);
+	size_t room = ft_zone_large_room(z);
+	munit_assert_size(room, >=, big * 2);
+	munit_assert_ptr_equal(ft_heap_realloc(q, big * 2), q);
+	munit_assert_size(z->bin_size, ==, big * 2);
+
+	/* Grow past it → new mapping */
+	uint8_t* r = (uint8_t*)ft_heap_realloc(q, room + 1);
 	munit_assert_ptr_not_equal(r, q);
 
 	for (size_t i = 0; i < 256; ++i)
 		munit_assert_uint8(r[i], ==, (uint8_t)(0xA0 | (i & 0x0F)));
 
 	ft_heap_free(r);
-	munit_assert_size(ft_heap_zone_count(FT_Z_LARGE), ==, 0);
+	munit_assert_size(ft_heap_zone_count(&g_heap, FT_Z_LARGE), ==, 0);
+	return MUNIT_OK;
+}
+
+static MunitResult realloc_growth_moves_log_times(const MunitParameter params[], void* user_data)
+{
+	(void)params; (void)user_data;
+
+	/* append loop: 64 bytes at a time up to 4 MiB */
+	const size_t step = 64;
+	const size_t final = (size_t)4 << 20;
+	unsigned char* p = NULL;
+	size_t moves = 0;
+
+	for (size_t len = step; len <= final; len += step) {
+		unsigned char* np = (unsigned char*)ft_heap_realloc(p, len);
+		munit_assert_not_null(np);
+		moves += (np != p);
+		p = np;
+		p[len - step] = (unsigned char)(len / step);
+		p[len - 1] = (unsigned char)(len / step);
+	}
+	/* a move per page would be ~1000 here; doubling keeps it near log2 */
+	munit_assert_size(moves, <=, 20);
+	for (size_t len = step; len <= final; len += step)
+		munit_assert_uint8(p[len - 1], ==, (unsigned char)(len / step));
+
+	/* the room is spare address space: live bytes follow the requests */
+	ft_malloc_stats_t st;
+	ft_malloc_stats(&st);
+	munit_assert_int64(st.classes[FT_STATS_LARGE].live_bytes, ==, (int64_t)final);
+	munit_assert_int64(st.classes[FT_STATS_LARGE].live_blocks, ==, 1);
+
+	ft_heap_free(p);
+	munit_assert_size(ft_heap_zone_count(&g_heap, FT_Z_LARGE), ==, 0);
+	return MUNIT_OK;
+}
+
+static MunitResult realloc_shrink_reclaims_memory(const MunitParameter params[], void* user_data)
+{
+	(void)params; (void)user_data;
+
+	/* SMALL -> TINY: bins 8x apart */
+	char* s = (char*)ft_heap_malloc(1000);
+	memset(s, 's', 1000);
+	char* t = (char*)ft_heap_realloc(s, 20);
+	munit_assert_ptr_not_equal(t, s);
+	munit_assert_int(ft_heap_find_owner(&g_heap, t)->klass, ==, FT_Z_TINY);
+	munit_assert_memory_equal(20, t, "ssssssssssssssssssss");
+	/* same class: stays */
+	char* u = (char*)ft_heap_malloc(1000);
+	munit_assert_ptr_equal(ft_heap_realloc(u, 300), u);
+
+	/* LARGE -> TINY: frees the whole mapping */
+	char* l = (char*)ft_heap_malloc((size_t)1 << 20);
+	memset(l, 'l', 64);
+	char* lt = (char*)ft_heap_realloc(l, 64);
+	munit_assert_int(ft_heap_find_owner(&g_heap, lt)->klass, ==, FT_Z_TINY);
+	munit_assert_memory_equal(8, lt, "llllllll");
+	munit_assert_size(ft_heap_zone_count(&g_heap, FT_Z_LARGE), ==, 0);
+
+	/* LARGE -> smaller LARGE: same address, tail unmapped */
+	ft_malloc_stats_t before, after;
+	char* m = (char*)ft_heap_malloc((size_t)1 << 20);
+	ft_malloc_stats(&before);
+	munit_assert_ptr_equal(ft_heap_realloc(m, (size_t)256 << 10), m);
+	ft_malloc_stats(&after);
+	t_zone* z = ft_heap_find_owner(&g_heap, m);
+	munit_assert_size(ft_zone_mapped_bytes(z), <, ((size_t)256 << 10) + 2 * (size_t)getpagesize());
+	munit_assert_int64(before.classes[FT_STATS_LARGE].mapped_bytes -
+						   after.classes[FT_STATS_LARGE].mapped_bytes, >=, (int64_t)(768 << 10));
+	munit_assert_int64(after.classes[FT_STATS_LARGE].live_bytes, ==, (int64_t)256 << 10);
+	/* a small cut is not worth a syscall */
+	munit_assert_ptr_equal(ft_heap_realloc(m, ((size_t)256 << 10) - 4096), m);
+	munit_assert_size(z->bin_size, ==, (size_t)256 << 10);
+
+	/* same size after growing: only the headroom goes, and is counted */
+	ft_heap_free(m);
+	ft_malloc_stats(&before);
+	char* g = NULL;
+	for (size_t n = 4096; n <= ((size_t)1 << 20); n += 4096) {
+		g = (char*)ft_heap_realloc(g, n);
+		munit_assert_not_null(g);
+	}
+	z = ft_heap_find_owner(&g_heap, g);
+	munit_assert_size(ft_zone_large_room(z), >, ((size_t)1 << 20) + FT_SHRINK_MIN_SAVING);
+	munit_assert_ptr_equal(ft_heap_realloc(g, (size_t)1 << 20), g);
+	munit_assert_size(ft_zone_large_room(z), <, ((size_t)1 << 20) + (size_t)getpagesize());
+	ft_malloc_stats(&after);
+	munit_assert_int64(after.classes[FT_STATS_LARGE].mapped_bytes, ==,
+					   before.classes[FT_STATS_LARGE].mapped_bytes + (int64_t)ft_zone_mapped_bytes(z));
+	ft_heap_free(g);
+	ft_malloc_stats(&after);
+	munit_assert_int64(after.classes[FT_STATS_LARGE].mapped_bytes, ==,
+					   before.classes[FT_STATS_LARGE].mapped_bytes);
+
+	ft_heap_free(t);
+	ft_heap_free(u);
+	ft_heap_free(lt);
+	return MUNIT_OK;
+}
+
+static MunitResult resize_in_place_never_moves(const MunitParameter params[], void* user_data)
+{
+	(void)params; (void)user_data;
+
+	const size_t k64 = (size_t)64 << 10;
+	char* p = (char*)ft_heap_malloc(k64);
+	t_zone* z = ft_heap_find_owner(&g_heap, p);
+
+	munit_assert_size(ft_resize_in_place(p, k64 / 2), ==, k64 / 2);
+	munit_assert_size(ft_zone_large_room(z), <, k64 / 2 + (size_t)getpagesize());
+	/* grows back into the last page only */
+	munit_assert_size(ft_resize_in_place(p, k64 / 2 + 16), ==, k64 / 2 + 16);
+	munit_assert_size(ft_resize_in_place(p, k64), ==, k64 / 2 + 16);
+	munit_assert_ptr_equal(ft_heap_find_owner(&g_heap, p), z);
+
+	ft_malloc_stats_t st;
+	ft_malloc_stats(&st);
+	munit_assert_int64(st.classes[FT_STATS_LARGE].live_bytes, ==, (int64_t)(k64 / 2 + 16));
+
+	char* t = (char*)ft_heap_malloc(10);
+	munit_assert_size(ft_resize_in_place(t, 100), ==, TINY_BIN_SIZE);
+	munit_assert_size(ft_resize_in_place(t, 1000), ==, TINY_BIN_SIZE);
+	munit_assert_size(ft_resize_in_place((void*)0x1000, 10), ==, 0);
+	munit_assert_size(ft_resize_in_place(NULL, 10), ==, 0);
+
+	ft_heap_free(p);
+	ft_heap_free(t);
 	return MUNIT_OK;
 }
 
@@ -168,7 +310,7 @@ static MunitResult realloc_tiny_to_small_moves_and_copies(const MunitParameter p
 	/* Force SMALL */
 	uint8_t* q = (uint8_t*)ft_heap_realloc(p, (size_t)TINY_BIN_SIZE + 1);
 	munit_assert_ptr_not_equal(q, p);
-	munit_assert_size(ft_heap_zone_count(FT_Z_SMALL), ==, 1);
+	munit_assert_size(ft_heap_zone_count(&g_heap, FT_Z_SMALL), ==, 1);
 
 	for (size_t i = 0; i < 128 && i < (size_t)(TINY_BIN_SIZE - 32); ++i)
 		munit_assert_uint8(q[i], ==, (uint8_t)i);
@@ -189,8 +331,8 @@ static MunitResult find_owner_same_zone_for_tiny(const MunitParameter params[],
 	munit_assert_not_null(a);
 	munit_assert_not_null(b);
 
-	t_zone* za = ft_heap_find_owner(a);
-	t_zone* zb = ft_heap_find_owner(b);
+	t_zone* za = ft_heap_find_owner(&g_heap, a);
+	t_zone* zb = ft_heap_find_owner(&g_heap, b);
 	munit_assert_not_null(za);
 	munit_assert_not_null(zb);
 	munit_assert_ptr_equal(za, zb);
@@ -207,7 +349,7 @@ static MunitResult realloc_zero_frees(const MunitParameter params[], void* user_
 
 	void* p = ft_heap_malloc(32);
 	munit_assert_not_null(p);
-	munit_assert_size(ft_heap_zone_count(FT_Z_TINY), ==, 1);
+	munit_assert_size(ft_heap_zone_count(&g_heap, FT_Z_TINY), ==, 1);
 
 	void* np = ft_heap_realloc(p, 0);
 	munit_assert_null(np);
@@ -221,17 +363,318 @@ static MunitResult free_invalid_is_ignored(const MunitParameter params[], void*
 
 	void* p = ft_heap_malloc(64);
 	munit_assert_not_null(p);
-	size_t nz_before = ft_heap_zone_count(FT_Z_TINY);
+	size_t nz_before = ft_heap_zone_count(&g_heap, FT_Z_TINY);
 
 	/* invalid free must not crash nor change valid state */
 	ft_heap_free((void*)0x12345678);
-	munit_assert_size(ft_heap_zone_count(FT_Z_TINY), ==, nz_before);
+	munit_assert_size(ft_heap_zone_count(&g_heap, FT_Z_TINY), ==, nz_before);
 
 	ft_heap_free(p);
 	assert_class_empty_or_fully_free(FT_Z_TINY);
 	return MUNIT_OK;
 }
 
+/* run ft_malloc_info into a pipe and return what it wrote (NUL-terminated) */
+static size_t read_info(int format, char* out, size_t cap)
+{
+	int fds[2];
+	munit_assert_int(pipe(fds), ==, 0);
+	munit_assert_int(ft_malloc_info(fds[1], format), ==, 0);
+	close(fds[1]);
+	size_t len = 0;
+	ssize_t n;
+	while (len + 1 < cap && (n = read(fds[0], out + len, cap - 1 - len)) > 0)
+		len += (size_t)n;
+	close(fds[0]);
+	out[len] = '\0';
+	return len;
+}
+
+static MunitResult malloc_info_reports_without_allocating(const MunitParameter params[],
+														  void* user_data)
+{
+	(void)params; (void)user_data;
+
+	void* t = ft_heap_malloc(10);
+	void* l = ft_heap_malloc(SMALL_BIN_SIZE * 8);
+	munit_assert_not_null(t);
+	munit_assert_not_null(l);
+
+	static char out[16384];
+	ft_malloc_stats_t before, after;
+	ft_malloc_stats(&before);
+
+	munit_assert_size(read_info(FT_MALLOC_INFO_JSON, out, sizeof out), >, 0);
+	munit_assert_not_null(strstr(out, "{\"version\":1,\"classes\":["));
+	munit_assert_not_null(strstr(out, "{\"class\":\"TINY\",\"bin_size\":128,\"zones\":1,"));
+	munit_assert_not_null(strstr(out, "\"class\":\"LARGE\""));
+	char needle[64];
+	snprintf(needle, sizeof needle, "\"live_bytes\":%zu", (size_t)SMALL_BIN_SIZE * 8);
+	munit_assert_not_null(strstr(out, needle));
+	munit_assert_not_null(strstr(out, "\"fragmentation\":0."));
+	munit_assert_not_null(strstr(out, "\"total\":{"));
+
+	munit_assert_size(read_info(FT_MALLOC_INFO_XML, out, sizeof out), >, 0);
+	munit_assert_ptr_equal(strstr(out, "<malloc version=\"1\">\n"), out);
+	munit_assert_not_null(strstr(out, "<heap nr=\"0\" class=\"TINY\">"));
+	munit_assert_not_null(strstr(out, "<size from=\"128\" to=\"128\""));
+	munit_assert_not_null(strstr(out, "<total type=\"mmap\" count=\"1\""));
+	munit_assert_not_null(strstr(out, "</malloc>\n"));
+
+	ft_malloc_stats(&after);
+	munit_assert_uint64(after.n_malloc, ==, before.n_malloc);
+	munit_assert_uint64(after.n_mmap, ==, before.n_mmap);
+
+	munit_assert_int(ft_malloc_info(1, 42), ==, -1);
+	munit_assert_int(errno, ==, EINVAL);
+
+	ft_heap_free(t);
+	ft_heap_free(l);
+	return MUNIT_OK;
+}
+
+/* run ft_heap_snapshot_diff into a pipe, like read_info */
+static size_t read_diff(const ft_heap_snapshot_t* a, const ft_heap_snapshot_t* b, char* out,
+						size_t cap)
+{
+	int fds[2];
+	munit_assert_int(pipe(fds), ==, 0);
+	munit_assert_int(ft_heap_snapshot_diff(a, b, fds[1]), ==, 0);
+	close(fds[1]);
+	size_t len = 0;
+	ssize_t n;
+	while (len + 1 < cap && (n = read(fds[0], out + len, cap - 1 - len)) > 0)
+		len += (size_t)n;
+	close(fds[0]);
+	out[len] = '\0';
+	return len;
+}
+
+static MunitResult snapshot_diff_reports_growth(const MunitParameter params[], void* user_data)
+{
+	(void)params; (void)user_data;
+
+	static void* tiny[1024];
+	void* large[3];
+	static char out[16384];
+
+	tiny[0] = ft_heap_malloc(10);
+	size_t cap = first_zone_of(FT_Z_TINY)->capacity;
+	munit_assert_size(cap + 1, <=, 1024);
+
+	ft_malloc_stats_t before, after;
+	ft_malloc_stats(&before);
+	ft_heap_snapshot_t* a = ft_malloc_snapshot();
+	ft_malloc_stats(&after);
+	munit_assert_not_null(a);
+	munit_assert_uint64(after.n_mmap, ==, before.n_mmap);
+
+	/* fill the first slab and spill one block into a second */
+	for (size_t i = 1; i <= cap; ++i)
+		tiny[i] = ft_heap_malloc(10);
+	for (int i = 0; i < 3; ++i)
+		large[i] = ft_heap_malloc(100000);
+	ft_heap_snapshot_t* b = ft_malloc_snapshot();
+	munit_assert_not_null(b);
+
+	munit_assert_size(read_diff(a, b, out, sizeof out), >, 0);
+	munit_assert_not_null(strstr(out, "class TINY zones 1 -> 2 (+1) used 1 -> "));
+	munit_assert_not_null(strstr(out, "class SMALL zones 0 -> 0 (=)"));
+	munit_assert_not_null(strstr(out, "class LARGE zones 0 -> 3 (+3)"));
+	munit_assert_not_null(strstr(out, "\nzone TINY ~ "));
+	munit_assert_not_null(strstr(out, "\nzone TINY + "));
+	munit_assert_null(strstr(out, "zone SMALL"));
+	munit_assert_not_null(strstr(out, "large 2^16 count 0 -> 3 (+3) bytes 0 -> 300000 (+300000)\n"));
+
+	for (size_t i = 0; i <= cap; ++i)
+		ft_heap_free(tiny[i]);
+	for (int i = 0; i < 3; ++i)
+		ft_heap_free(large[i]);
+	ft_heap_snapshot_t* c = ft_malloc_snapshot();
+	munit_assert_size(read_diff(b, c, out, sizeof out), >, 0);
+	munit_assert_not_null(strstr(out, "class LARGE zones 3 -> 0 (-3)"));
+	munit_assert_not_null(strstr(out, "large 2^16 count 3 -> 0 (-3)"));
+
+	/* identical snapshots: class lines only */
+	munit_assert_size(read_diff(c, c, out, sizeof out), >, 0);
+	munit_assert_null(strstr(out, "zone "));
+	munit_assert_null(strstr(out, "large "));
+
+	munit_assert_int(ft_heap_snapshot_diff(a, NULL, 1), ==, -1);
+	munit_assert_int(errno, ==, EINVAL);
+	ft_heap_snapshot_free(a);
+	ft_heap_snapshot_free(b);
+	ft_heap_snapshot_free(c);
+	return MUNIT_OK;
+}
+
+typedef struct s_seen {
+	size_t n;
+	uintptr_t ptr[64];
+	size_t size[64];
+} t_seen;
+
+static void collect(uintptr_t ptr, size_t size, void* arg)
+{
+	t_seen* s = arg;
+	munit_assert_size(s->n, <, 64);
+	s->ptr[s->n] = ptr;
+	s->size[s->n++] = size;
+}
+
+static size_t seen_size(const t_seen* s, const void* p)
+{
+	for (size_t i = 0; i < s->n; ++i)
+		if (s->ptr[i] == (uintptr_t)p)
+			return s->size[i];
+	return 0;
+}
+
+static void* malloc_when_enabled(void* arg)
+{
+	void* p = ft_heap_malloc(16);
+	__atomic_store_n((int*)arg, 1, __ATOMIC_RELEASE);
+	ft_heap_free(p);
+	return NULL;
+}
+
+static MunitResult iterate_reports_live_blocks(const MunitParameter params[], void* user_data)
+{
+	(void)params; (void)user_data;
+
+	void* t[4];
+	for (int i = 0; i < 4; ++i)
+		t[i] = ft_heap_malloc(10);
+	void* sm = ft_heap_malloc(TINY_BIN_SIZE + 1);
+	void* l = ft_heap_malloc(SMALL_BIN_SIZE * 8);
+	ft_heap_free(t[2]);
+
+	t_seen all = {0};
+	munit_assert_int(ft_malloc_iterate(0, SIZE_MAX, collect, &all), ==, 0);
+	munit_assert_size(all.n, ==, 5);
+	munit_assert_size(seen_size(&all, t[0]), ==, TINY_BIN_SIZE);
+	munit_assert_size(seen_size(&all, t[3]), ==, TINY_BIN_SIZE);
+	munit_assert_size(seen_size(&all, t[2]), ==, 0);
+	munit_assert_size(seen_size(&all, sm), ==, SMALL_BIN_SIZE);
+	munit_assert_size(seen_size(&all, l), >=, SMALL_BIN_SIZE * 8);
+
+	/* a block is reported when it starts in the range */
+	t_seen one = {0};
+	munit_assert_int(ft_malloc_iterate((uintptr_t)t[1] - 1, 2, collect, &one), ==, 0);
+	munit_assert_size(one.n, ==, 1);
+	munit_assert_ptr_equal((void*)one.ptr[0], t[1]);
+	one.n = 0;
+	munit_assert_int(ft_malloc_iterate((uintptr_t)l + 1, 64, collect, &one), ==, 0);
+	munit_assert_size(one.n, ==, 0);
+
+	/* frozen: other threads wait, the freezing thread can still walk */
+	int done = 0;
+	pthread_t th;
+	ft_malloc_disable();
+	munit_assert_int(pthread_create(&th, NULL, malloc_when_enabled, &done), ==, 0);
+	usleep(20000);
+	munit_assert_int(__atomic_load_n(&done, __ATOMIC_ACQUIRE), ==, 0);
+	all.n = 0;
+	munit_assert_int(ft_malloc_iterate(0, SIZE_MAX, collect, &all), ==, 0);
+	munit_assert_size(all.n, ==, 5);
+	ft_malloc_enable();
+	pthread_join(th, NULL);
+	munit_assert_int(done, ==, 1);
+
+	munit_assert_int(ft_malloc_iterate(0, SIZE_MAX, NULL, NULL), ==, -1);
+	munit_assert_int(errno, ==, EINVAL);
+
+	for (int i = 0; i < 4; ++i)
+		if (i != 2)
+			ft_heap_free(t[i]);
+	ft_heap_free(sm);
+	ft_heap_free(l);
+	return MUNIT_OK;
+}
+
+/* every reader skips the lock the freezing thread already holds */
+static MunitResult frozen_thread_can_report_and_fork(const MunitParameter params[], void* user_data)
+{
+	(void)params; (void)user_data;
+
+	void* t = ft_heap_malloc(10);
+	void* l = ft_heap_malloc(SMALL_BIN_SIZE * 8);
+	munit_assert_not_null(t);
+	munit_assert_not_null(l);
+	alarm(10); /* a self-deadlock fails instead of hanging */
+
+	ft_malloc_disable();
+	ft_malloc_disable(); /* nests */
+
+	const int saved = dup(1);
+	const int null = open("/dev/null", O_WRONLY);
+	munit_assert_int(null, >=, 0);
+	dup2(null, 1);
+	size_t total = ft_heap_show_alloc_mem(&g_heap);
+	size_t total_ex = ft_heap_show_alloc_mem_ex(&g_heap, NULL);
+	int info = ft_heap_malloc_info(&g_heap, null, FT_MALLOC_INFO_JSON);
+	dup2(saved, 1);
+	close(saved);
+	close(null);
+	munit_assert_size(total, ==, TINY_BIN_SIZE + (size_t)SMALL_BIN_SIZE * 8);
+	munit_assert_size(total_ex, ==, total);
+	munit_assert_int(info, ==, 0);
+
+	ft_malloc_stats_t st;
+	ft_heap_stats(&g_heap, &st);
+	munit_assert_int64(st.classes[FT_Z_TINY].live_blocks, ==, 1);
+	ft_heap_snapshot_t* snap = ft_heap_snapshot(&g_heap);
+	munit_assert_not_null(snap);
+	ft_heap_snapshot_free(snap);
+
+	/* the atfork prepare handler freezes g_heap once more */
+	pid_t pid = fork();
+	munit_assert_int(pid, >=, 0);
+	if (pid == 0)
+		_exit(0);
+	int status;
+	munit_assert_int(waitpid(pid, &status, 0), ==, pid);
+	munit_assert_true(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+	ft_malloc_enable();
+	munit_assert_int(g_heap.frozen, ==, 1);
+	ft_malloc_enable();
+	munit_assert_int(g_heap.frozen, ==, 0);
+	/* unlocked again */
+	munit_assert_int(pthread_mutex_trylock(&g_heap.lock), ==, 0);
+	pthread_mutex_unlock(&g_heap.lock);
+	alarm(0);
+
+	ft_heap_free(t);
+	ft_heap_free(l);
+	return MUNIT_OK;
+}
+
+/* the class the malloc probe and lib/latency report, set under the lock */
+static MunitResult op_note_names_the_class(const MunitParameter params[], void* user_data)
+{
+	(void)params; (void)user_data;
+
+	void* t = ft_heap_malloc(1);
+	munit_assert_uint32(g_heap_op_note.klass, ==, FT_Z_TINY);
+	void* s = ft_heap_malloc((size_t)TINY_BIN_SIZE + 1);
+	munit_assert_uint32(g_heap_op_note.klass, ==, FT_Z_SMALL);
+	void* a = ft_heap_alloc_aligned(&g_heap, 256, 8);
+	munit_assert_uint32(g_heap_op_note.klass, ==, ft_heap_classify_aligned(&g_heap, 8, 256));
+	/* a failure still names the class it asked for */
+	munit_assert_null(ft_heap_malloc(SIZE_MAX - 4096));
+	munit_assert_uint32(g_heap_op_note.klass, ==, FT_Z_LARGE);
+	void* z = ft_heap_malloc(0);
+	munit_assert_not_null(z);
+	munit_assert_uint32(g_heap_op_note.klass, ==, FT_Z_TINY);
+
+	ft_heap_free(z);
+	ft_heap_free(t);
+	ft_heap_free(s);
+	ft_heap_free(a);
+	return MUNIT_OK;
+}
+
 static MunitResult show_alloc_mem_total_is_correct(const MunitParameter params[], void* user_data)
 {
 	(void)params; (void)user_data;
@@ -247,7 +690,7 @@ static MunitResult show_alloc_mem_total_is_correct(const MunitParameter params[]
 	munit_assert_not_null(s1);
 	munit_assert_not_null(lg);
 
-	size_t total = ft_heap_show_alloc_mem();
+	size_t total = ft_heap_show_alloc_mem(&g_heap);
 	size_t expected = (2 * (size_t)TINY_BIN_SIZE) + (1 * (size_t)SMALL_BIN_SIZE) + L;
 	munit_assert_size(total, ==, expected);
 
@@ -258,18 +701,475 @@ static MunitResult show_alloc_mem_total_is_correct(const MunitParameter params[]
 	return MUNIT_OK;
 }
 
+typedef struct s_show_reader {
+	int fd;
+	int lock_was_free; /* heap lock free while the report was being written */
+	size_t bytes;
+} t_show_reader;
+
+static void* show_reader(void* arg)
+{
+	t_show_reader* r = arg;
+	char buf[4096];
+	ssize_t n;
+	/* let the writer fill the pipe and block in write(2) */
+	usleep(50000);
+	if (pthread_mutex_trylock(&g_heap.lock) == 0) {
+		r->lock_was_free = 1;
+		pthread_mutex_unlock(&g_heap.lock);
+	}
+	while ((n = read(r->fd, buf, sizeof buf)) > 0)
+		r->bytes += (size_t)n;
+	return NULL;
+}
+
+static MunitResult show_alloc_mem_writes_after_unlock(const MunitParameter params[], void* user_data)
+{
+	(void)params; (void)user_data;
+
+	/* more lines than a pipe holds */
+	enum { N = 2000 };
+	void* ps[N];
+	for (size_t i = 0; i < N; ++i) {
+		ps[i] = ft_heap_malloc(1);
+		munit_assert_not_null(ps[i]);
+	}
+
+	int fds[2];
+	munit_assert_int(pipe(fds), ==, 0);
+	const int saved = dup(1);
+	munit_assert_int(saved, >=, 0);
+	munit_assert_int(dup2(fds[1], 1), ==, 1);
+
+	t_show_reader r = {fds[0], 0, 0};
+	pthread_t th;
+	munit_assert_int(pthread_create(&th, NULL, show_reader, &r), ==, 0);
+	size_t total = ft_heap_show_alloc_mem(&g_heap);
+	dup2(saved, 1);
+	close(saved);
+	close(fds[1]);
+	pthread_join(th, NULL);
+	close(fds[0]);
+
+	munit_assert_size(total, ==, N * (size_t)TINY_BIN_SIZE);
+	munit_assert_size(r.bytes, >, (size_t)1 << 16);
+	munit_assert_int(r.lock_was_free, ==, 1);
+
+	for (size_t i = 0; i < N; ++i)
+		ft_heap_free(ps[i]);
+	return MUNIT_OK;
+}
+
+static MunitResult malloc_info_writes_after_unlock(const MunitParameter params[], void* user_data)
+{
+	(void)params; (void)user_data;
+
+	/* a zone entry each: more than a pipe holds */
+	enum { N = 1000 };
+	void* ps[N];
+	for (size_t i = 0; i < N; ++i) {
+		ps[i] = ft_heap_malloc((size_t)SMALL_BIN_SIZE * 2);
+		munit_assert_not_null(ps[i]);
+	}
+
+	int fds[2];
+	munit_assert_int(pipe(fds), ==, 0);
+	t_show_reader r = {fds[0], 0, 0};
+	pthread_t th;
+	munit_assert_int(pthread_create(&th, NULL, show_reader, &r), ==, 0);
+	munit_assert_int(ft_malloc_info(fds[1], FT_MALLOC_INFO_JSON), ==, 0);
+	close(fds[1]);
+	pthread_join(th, NULL);
+	close(fds[0]);
+
+	munit_assert_size(r.bytes, >, (size_t)1 << 16);
+	munit_assert_int(r.lock_was_free, ==, 1);
+
+	for (size_t i = 0; i < N; ++i)
+		ft_heap_free(ps[i]);
+	return MUNIT_OK;
+}
+
+static MunitResult trim_releases_empty_and_free_pages(const MunitParameter params[], void* user_data)
+{
+	(void)params; (void)user_data;
+
+	/* one partially used SMALL slab with a long free run in the middle */
+	enum { N = SMALL_N_BLOCKS };
+	void* ps[N];
+	for (size_t i = 0; i < N; ++i) {
+		ps[i] = ft_heap_malloc(SMALL_BIN_SIZE);
+		munit_assert_not_null(ps[i]);
+	}
+	munit_assert_size(ft_heap_zone_count(&g_heap, FT_Z_SMALL), ==, 1);
+	for (size_t i = 1; i < N - 1; ++i)
+		ft_heap_free(ps[i]);
+
+	/* one retained empty TINY slab */
+	ft_heap_free(ft_heap_malloc(1));
+	munit_assert_size(ft_heap_zone_count(&g_heap, FT_Z_TINY), ==, 1);
+	size_t tiny_bytes = ft_zone_mapped_bytes(first_zone_of(FT_Z_TINY));
+
+	/* pad large enough keeps the empty slab, interior pages still go */
+	size_t released = ft_heap_trim(&g_heap, tiny_bytes);
+	munit_assert_size(released, >, 0);
+	munit_assert_size(ft_heap_zone_count(&g_heap, FT_Z_TINY), ==, 1);
+
+	/* pad 0: the empty slab is unmapped too, interior pages are not counted twice */
+	released = ft_heap_trim(&g_heap, 0);
+	munit_assert_size(released, ==, tiny_bytes);
+	munit_assert_size(ft_heap_zone_count(&g_heap, FT_Z_TINY), ==, 0);
+	munit_assert_size(ft_heap_zone_count(&g_heap, FT_Z_SMALL), ==, 1);
+
+	/* nothing new to release: a repeated trim reports nothing */
+	ft_malloc_stats_t before, after;
+	ft_heap_stats(&g_heap, &before);
+	munit_assert_size(ft_heap_trim(&g_heap, 0), ==, 0);
+	ft_heap_stats(&g_heap, &after);
+	munit_assert_uint64(after.trimmed_bytes, ==, before.trimmed_bytes);
+
+	/* the slab is still usable after trimming */
+	char* p = (char*)ft_heap_malloc(SMALL_BIN_SIZE);
+	munit_assert_not_null(p);
+	memset(p, 0x5A, SMALL_BIN_SIZE);
+	ft_heap_free(p);
+	ft_heap_free(ps[0]);
+	ft_heap_free(ps[N - 1]);
+	assert_class_empty_or_fully_free(FT_Z_SMALL);
+	return MUNIT_OK;
+}
+
+static MunitResult aligned_alloc_and_sized_free(const MunitParameter params[], void* user_data)
+{
+	(void)params; (void)user_data;
+
+	/* bin multiple of align: served by an aligned slab of that class */
+	void* t = ft_heap_alloc_aligned(&g_heap, 64, 40);
+	void* s = ft_heap_alloc_aligned(&g_heap, 512, 300);
+	munit_assert_not_null(t);
+	munit_assert_not_null(s);
+	munit_assert_size((uintptr_t)t % 64, ==, 0);
+	munit_assert_size((uintptr_t)s % 512, ==, 0);
+	munit_assert_int(ft_heap_find_owner(&g_heap, t)->klass, ==, FT_Z_TINY);
+	munit_assert_int(ft_heap_find_owner(&g_heap, s)->klass, ==, FT_Z_SMALL);
+
+	/* alignment no slab bin is a multiple of: LARGE, aligned payload */
+	void* l = ft_heap_alloc_aligned(&g_heap, 8192, 10);
+	munit_assert_not_null(l);
+	munit_assert_size((uintptr_t)l % 8192, ==, 0);
+	munit_assert_int(ft_heap_find_owner(&g_heap, l)->klass, ==, FT_Z_LARGE);
+	munit_assert_null(ft_heap_alloc_aligned(&g_heap, 48, 10));
+
+	/* sized frees, including a wrong hint that must fall back */
+	void* p = ft_heap_malloc(100);
+	ft_heap_dealloc_sized(&g_heap, p, 100, 0);
+	ft_heap_dealloc_sized(&g_heap, t, 40, 64);
+	ft_heap_dealloc_sized(&g_heap, s, 5000, 0);
+	ft_heap_dealloc_sized(&g_heap, l, 10, 8192);
+	munit_assert_size(ft_heap_zone_count(&g_heap, FT_Z_LARGE), ==, 0);
+	munit_assert_size(ft_heap_total_free_in_class(&g_heap, FT_Z_SMALL), ==,
+					  first_zone_of(FT_Z_SMALL)->capacity);
+	return MUNIT_OK;
+}
+
+static MunitResult sized_free_keeps_to_its_heap(const MunitParameter params[], void* user_data)
+{
+	(void)params; (void)user_data;
+
+	ft_heap_t* a = ft_heap_create(NULL);
+	ft_heap_t* b = ft_heap_create(NULL);
+	munit_assert_not_null(a);
+	munit_assert_not_null(b);
+	void* l = ft_heap_alloc(a, SMALL_BIN_SIZE * 8);
+	munit_assert_not_null(l);
+
+	/* a block of another heap is not released into this one */
+	ft_heap_dealloc_sized(b, l, SMALL_BIN_SIZE * 8, 0);
+	munit_assert_uint64(b->stats.n_invalid_free, ==, 1);
+	munit_assert_size(ft_heap_zone_count(b, FT_Z_LARGE), ==, 0);
+	munit_assert_ptr_equal(ft_heap_find_owner(a, l)->mem_begin, l);
+
+	/* nor is anything read before a pointer that is not from the allocator:
+	 * here the page a LARGE header would sit on is unmapped */
+	const size_t ps = ft_page_size();
+	char* m = mmap(NULL, 2 * ps, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	munit_assert_ptr_not_equal(m, MAP_FAILED);
+	munit_assert_int(munmap(m, ps), ==, 0);
+	ft_heap_dealloc_sized(b, m + ft_align_up(sizeof(t_zone), FT_ALIGN), ps * 8, 0);
+	munit_assert_uint64(b->stats.n_invalid_free, ==, 2);
+	munmap(m + ps, ps);
+
+	ft_heap_dealloc_sized(a, l, SMALL_BIN_SIZE * 8, 0);
+	munit_assert_size(ft_heap_zone_count(a, FT_Z_LARGE), ==, 0);
+	munit_assert_uint64(a->stats.n_invalid_free, ==, 0);
+	ft_heap_destroy(a);
+	ft_heap_destroy(b);
+	return MUNIT_OK;
+}
+
+static MunitResult stats_track_work_and_diff(const MunitParameter params[], void* user_data)
+{
+	(void)params; (void)user_data;
+
+	ft_malloc_stats_t before, after, d;
+	ft_malloc_stats(&before);
+
+	void* t[3];
+	for (int i = 0; i < 3; ++i)
+		t[i] = ft_heap_malloc(10);
+	void* s = ft_heap_malloc(TINY_BIN_SIZE + 1);
+	void* l = ft_heap_malloc(SMALL_BIN_SIZE * 8);
+	ft_heap_free(t[1]);
+	ft_heap_free((void*)0x1234);
+	s = ft_heap_realloc(s, SMALL_BIN_SIZE);
+
+	ft_malloc_stats(&after);
+	ft_malloc_stats_diff(&before, &after, &d);
+
+	const ft_class_stats_t* tiny = &d.classes[FT_STATS_TINY];
+	munit_assert_uint64(tiny->n_alloc, ==, 3);
+	munit_assert_uint64(tiny->n_free, ==, 1);
+	munit_assert_int64(tiny->live_blocks, ==, 2);
+	munit_assert_int64(tiny->live_bytes, ==, 2 * TINY_BIN_SIZE);
+	munit_assert_int64(tiny->zones, ==, 1);
+	munit_assert_int64(tiny->mapped_bytes, ==,
+					   (int64_t)ft_zone_mapped_bytes(first_zone_of(FT_Z_TINY)));
+	munit_assert_int64(tiny->wasted_bytes, ==, tiny->mapped_bytes - tiny->live_bytes);
+	munit_assert_int64(tiny->retained_bytes, ==, 0);
+
+	munit_assert_int64(d.classes[FT_STATS_SMALL].live_blocks, ==, 1);
+	munit_assert_int64(d.classes[FT_STATS_LARGE].live_bytes, ==, SMALL_BIN_SIZE * 8);
+	munit_assert_uint64(d.n_malloc, ==, 5);
+	munit_assert_uint64(d.n_free, ==, 2);
+	munit_assert_uint64(d.n_invalid_free, ==, 1);
+	munit_assert_uint64(d.n_realloc, ==, 1);
+	munit_assert_uint64(d.n_mmap, ==, 3);
+
+	/* emptied slabs are retained, not unmapped; LARGE goes right away */
+	ft_heap_free(t[0]);
+	ft_heap_free(t[2]);
+	ft_heap_free(s);
+	ft_heap_free(l);
+	ft_malloc_stats(&after);
+	ft_malloc_stats_diff(&before, &after, &d);
+	munit_assert_int64(d.classes[FT_STATS_TINY].live_bytes, ==, 0);
+	munit_assert_int64(d.classes[FT_STATS_TINY].retained_bytes, ==,
+					   d.classes[FT_STATS_TINY].mapped_bytes);
+	munit_assert_int64(d.classes[FT_STATS_LARGE].zones, ==, 0);
+	munit_assert_uint64(d.n_munmap, ==, 1);
+
+	ft_heap_trim(&g_heap, 0);
+	ft_malloc_stats(&after);
+	munit_assert_int64(after.classes[FT_STATS_TINY].mapped_bytes, ==, 0);
+	munit_assert_int64(after.classes[FT_STATS_SMALL].retained_bytes, ==, 0);
+	munit_assert_uint64(after.trimmed_bytes - before.trimmed_bytes, >, 0);
+	return MUNIT_OK;
+}
+
+static MunitResult instances_are_isolated(const MunitParameter params[], void* user_data)
+{
+	(void)params; (void)user_data;
+
+	ft_heap_t* a = ft_heap_create(NULL);
+	ft_heap_config_t cfg = {.tiny_bin_size = 64, .small_bin_size = 512};
+	ft_heap_t* b = ft_heap_create(&cfg);
+	munit_assert_not_null(a);
+	munit_assert_not_null(b);
+	munit_assert_size(a->tiny_bin_size, ==, TINY_BIN_SIZE);
+	munit_assert_int(ft_heap_classify(b, 100), ==, FT_Z_SMALL);
+	munit_assert_int(ft_heap_classify(b, 600), ==, FT_Z_LARGE);
+
+	void* pa = ft_heap_alloc(a, 100);
+	void* pb = ft_heap_alloc(b, 100);
+	void* lb = ft_heap_alloc(b, 4096);
+	munit_assert_not_null(pa);
+	munit_assert_not_null(pb);
+	munit_assert_not_null(lb);
+
+	/* each heap only knows its own memory, the default heap is untouched */
+	munit_assert_ptr_null(ft_heap_find_owner(a, pb));
+	munit_assert_ptr_null(ft_heap_find_owner(b, pa));
+	munit_assert_ptr_null(ft_heap_find_owner(&g_heap, pa));
+	munit_assert_size(ft_heap_zone_count(&g_heap, FT_Z_TINY), ==, 0);
+	munit_assert_size(ft_heap_zone_count(a, FT_Z_TINY), ==, 1);
+	munit_assert_size(ft_heap_zone_count(b, FT_Z_SMALL), ==, 1);
+
+	/* freeing into the wrong heap is ignored */
+	ft_heap_dealloc(a, pb);
+	munit_assert_size(ft_heap_total_free_in_class(b, FT_Z_SMALL) + 1, ==,
+					  ft_heap_find_owner(b, pb)->capacity);
+
+	char* grown = (char*)ft_heap_reallocate(a, pa, 2000);
+	munit_assert_not_null(grown);
+	munit_assert_not_null(ft_heap_find_owner(a, grown));
+
+	/* destroy drops everything of a heap at once */
+	ft_heap_destroy(a);
+	ft_heap_destroy(b);
+	munit_assert_ptr_null(ft_heap_create(&(ft_heap_config_t){.tiny_bin_size = 512,
+															  .small_bin_size = 256}));
+	/* bins are checked against the defaults they are paired with */
+	munit_assert_ptr_null(ft_heap_create(&(ft_heap_config_t){.tiny_bin_size = 2000}));
+	munit_assert_ptr_null(ft_heap_create(&(ft_heap_config_t){.tiny_bin_size = 100}));
+	munit_assert_ptr_null(ft_heap_create(&(ft_heap_config_t){.small_bin_size = 1 << 20}));
+	munit_assert_int(errno, ==, EINVAL);
+	return MUNIT_OK;
+}
+
+#define MT_THREADS 4
+#define MT_ROUNDS 200
+#define MT_BATCH 64
+
+/* each thread frees the batch its left neighbour allocated last round */
+typedef struct s_mt_arg {
+	pthread_barrier_t* bar;
+	void* (*slots)[MT_BATCH];
+	int id;
+} t_mt_arg;
+
+static void* mt_worker(void* arg)
+{
+	t_mt_arg* a = (t_mt_arg*)arg;
+	static const size_t sizes[] = {24, 200, 900, 3000};
+
+	for (int r = 0; r < MT_ROUNDS; ++r) {
+		void** mine = a->slots[(a->id + r) % MT_THREADS];
+		for (int i = 0; i < MT_BATCH; ++i) {
+			size_t n = sizes[(size_t)(i + a->id) % 4];
+			mine[i] = ft_heap_malloc(n);
+			memset(mine[i], a->id, n);
+		}
+		pthread_barrier_wait(a->bar);
+		void** theirs = a->slots[(a->id + r + 1) % MT_THREADS];
+		for (int i = 0; i < MT_BATCH; ++i)
+			ft_heap_free(ft_heap_realloc(theirs[i], 64));
+		pthread_barrier_wait(a->bar);
+	}
+	return NULL;
+}
+
+static MunitResult threads_share_one_heap(const MunitParameter params[], void* user_data)
+{
+	(void)params; (void)user_data;
+
+	static void* slots[MT_THREADS][MT_BATCH];
+	pthread_barrier_t bar;
+	pthread_t th[MT_THREADS];
+	t_mt_arg args[MT_THREADS];
+
+	pthread_barrier_init(&bar, NULL, MT_THREADS);
+	for (int i = 0; i < MT_THREADS; ++i) {
+		args[i] = (t_mt_arg){&bar, slots, i};
+		munit_assert_int(pthread_create(&th[i], NULL, mt_worker, &args[i]), ==, 0);
+	}
+	for (int i = 0; i < MT_THREADS; ++i)
+		pthread_join(th[i], NULL);
+	pthread_barrier_destroy(&bar);
+
+	ft_malloc_stats_t st;
+	ft_malloc_stats(&st);
+	for (int k = 0; k < FT_STATS_NCLASSES; ++k)
+		munit_assert_int64(st.classes[k].live_blocks, ==, 0);
+	munit_assert_uint64(st.n_invalid_free, ==, 0);
+	munit_assert_int64(st.classes[FT_STATS_LARGE].zones, ==, 0);
+	return MUNIT_OK;
+}
+
 /* ---------- suite ---------- */
 
+/* a list of mixed-size nodes in a file heap, found again through the root
+ * after closing and re-opening the file */
+typedef struct s_pnode {
+	struct s_pnode* next;
+	size_t n;
+	char* blob;
+} t_pnode;
+
+static MunitResult file_heap_survives_reopen(const MunitParameter params[], void* user_data)
+{
+	(void)params; (void)user_data;
+
+	char path[] = "/tmp/ft_pheap_XXXXXX";
+	int fd = mkstemp(path);
+	munit_assert_int(fd, >=, 0);
+	close(fd);
+
+	ft_heap_t* h = ft_heap_open_file(path, NULL, 64u << 20);
+	munit_assert_not_null(h);
+	munit_assert_ptr_equal((void*)((uintptr_t)h & ~(uintptr_t)(ft_page_size() - 1)), FT_PHEAP_BASE);
+	t_pnode* head = NULL;
+	for (size_t i = 0; i < 500; ++i) {
+		t_pnode* nd = ft_heap_alloc(h, sizeof *nd);
+		nd->n = (i % 50 == 0) ? 100000 : 16 + i * 3;
+		nd->blob = ft_heap_alloc(h, nd->n);
+		memset(nd->blob, (int)(i & 0xff), nd->n);
+		nd->next = head;
+		head = nd;
+	}
+	munit_assert_int(ft_heap_set_root(h, head), ==, 0);
+	munit_assert_null(ft_heap_open_file(path, NULL, 0)); /* one process, one open */
+	munit_assert_int(errno, ==, EBUSY);
+	ft_malloc_stats_t before, after;
+	ft_heap_stats(h, &before);
+	munit_assert_int(ft_heap_close_file(h), ==, 0);
+
+	/* the same heap at the same address, nothing rebuilt */
+	munit_assert_ptr_equal(ft_heap_open_file(path, NULL, 0), h);
+	ft_heap_stats(h, &after);
+	munit_assert_memory_equal(sizeof before, &before, &after);
+	size_t i = 500;
+	for (t_pnode* nd = ft_heap_root(h); nd; nd = nd->next) {
+		--i;
+		munit_assert_size(nd->n, ==, (i % 50 == 0) ? 100000 : 16 + i * 3);
+		munit_assert_uint8((uint8_t)nd->blob[nd->n - 1], ==, i & 0xff);
+		munit_assert_ptr_equal(ft_heap_find_owner(h, nd->blob)->arena, h->arena);
+	}
+	munit_assert_size(i, ==, 0);
+	ft_heap_dealloc(h, ((t_pnode*)ft_heap_root(h))->blob);
+	munit_assert_not_null(ft_heap_alloc(h, 5000));
+	munit_assert_int(ft_heap_close_file(h), ==, 0);
+	munit_assert_null(ft_heap_root(&g_heap));
+
+	/* a process that dies with the file open leaves it refused */
+	pid_t pid = fork();
+	if (pid == 0)
+		_exit(ft_heap_open_file(path, NULL, 0) ? 0 : 1);
+	int status;
+	munit_assert_int(waitpid(pid, &status, 0), ==, pid);
+	munit_assert_int(WEXITSTATUS(status), ==, 0);
+	munit_assert_null(ft_heap_open_file(path, NULL, 0));
+	munit_assert_int(errno, ==, EUCLEAN);
+	unlink(path);
+	return MUNIT_OK;
+}
+
 static MunitTest tests[] = {
 	{"/tiny_alloc_reuse_and_trim",            tiny_alloc_reuse_and_trim,            setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
 	{"/small_alloc_zone_lifetime",            small_alloc_zone_lifetime,            setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
 	{"/large_alloc_shrink_grow",              large_alloc_shrink_grow,              setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/realloc_growth_moves_log_times",       realloc_growth_moves_log_times,       setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/realloc_shrink_reclaims_memory",       realloc_shrink_reclaims_memory,       setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/resize_in_place_never_moves",          resize_in_place_never_moves,          setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
 	{"/realloc_within_slab_keeps_ptr",        realloc_within_slab_keeps_ptr,        setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
 	{"/realloc_tiny_to_small_moves_and_copies", realloc_tiny_to_small_moves_and_copies, setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
 	{"/find_owner_same_zone_for_tiny",        find_owner_same_zone_for_tiny,        setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
 	{"/realloc_zero_frees",                   realloc_zero_frees,                   setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
 	{"/free_invalid_is_ignored",              free_invalid_is_ignored,              setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/trim_releases_empty_and_free_pages",   trim_releases_empty_and_free_pages,   setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/aligned_alloc_and_sized_free",         aligned_alloc_and_sized_free,         setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/sized_free_keeps_to_its_heap",         sized_free_keeps_to_its_heap,         setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/stats_track_work_and_diff",            stats_track_work_and_diff,            setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/instances_are_isolated",               instances_are_isolated,               setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/malloc_info_reports_without_allocating", malloc_info_reports_without_allocating, setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/snapshot_diff_reports_growth",         snapshot_diff_reports_growth,         setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/iterate_reports_live_blocks",          iterate_reports_live_blocks,          setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/file_heap_survives_reopen",            file_heap_survives_reopen,            setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/threads_share_one_heap",               threads_share_one_heap,               setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/frozen_thread_can_report_and_fork",    frozen_thread_can_report_and_fork,    setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/op_note_names_the_class",              op_note_names_the_class,              setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
 	{"/show_alloc_mem_total_is_correct",      show_alloc_mem_total_is_correct,      setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/show_alloc_mem_writes_after_unlock",   show_alloc_mem_writes_after_unlock,   setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/malloc_info_writes_after_unlock",      malloc_info_writes_after_unlock,      setup, teardown, MUNIT_TEST_OPTION_NONE, NULL},
 	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
 };
 
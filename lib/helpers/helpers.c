@@ -11,22 +11,7 @@
 /* ************************************************************************** */
 
 #include "helpers.h"
-
-void* ft_memcpy(void* dst, const void* src, size_t n)
-{
-	/* memcpy semantics: if n==0, OK even if pointers are NULL.
-	   If regions overlap and n>0, behavior is undefined (we just copy forward). */
-	if (dst == src || n == 0)
-		return dst;
-
-	unsigned char* d = (unsigned char*)dst;
-	const unsigned char* s = (const unsigned char*)src;
-
-	for (size_t i = 0; i < n; ++i)
-		d[i] = s[i];
-
-	return dst;
-}
+#include <sys/mman.h>
 
 /* ---------------- alignment & pagesize ---------------- */
 
@@ -56,6 +41,172 @@ size_t ft_page_size(void)
 #endif
 }
 
+/* ---------------- scratch mappings ---------------- */
+
+void* ft_scratch_map(size_t bytes)
+{
+	if (bytes == 0)
+		return NULL;
+	void* p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+	return (p == MAP_FAILED) ? NULL : p;
+}
+
+void ft_scratch_unmap(void* p, size_t bytes)
+{
+	if (p && bytes)
+		(void)munmap(p, bytes);
+}
+
+/* ---------------- number formatting ---------------- */
+
+#define FT_FMT_USIZE_MAX 32
+#define FT_FMT_PTR_MAX (2 + sizeof(uintptr_t) * 2)
+
+/* Both format right-aligned into tmp and return the index of the first char. */
+static size_t ft_fmt_usize(char tmp[FT_FMT_USIZE_MAX], size_t v)
+{
+	size_t i = FT_FMT_USIZE_MAX;
+	do {
+		tmp[--i] = (char)('0' + (v % 10));
+		v /= 10;
+	} while (v);
+	return i;
+}
+
+static size_t ft_fmt_hex_ptr(char tmp[FT_FMT_PTR_MAX], const void* p)
+{
+	static const char hex[] = "0123456789abcdef";
+	uintptr_t x = (uintptr_t)p;
+	size_t i = FT_FMT_PTR_MAX;
+	do {
+		tmp[--i] = hex[x & 0xF];
+		x >>= 4;
+	} while (x);
+	tmp[--i] = 'x';
+	tmp[--i] = '0';
+	return i;
+}
+
+/* ---------------- buffered output ---------------- */
+
+void ft_buf_init(t_ft_buf* b, int fd)
+{
+	b->fd = fd;
+	b->len = 0;
+	b->capture = 0;
+	b->spill = NULL;
+	b->spill_len = 0;
+	b->spill_cap = 0;
+}
+
+void ft_buf_init_capture(t_ft_buf* b, int fd)
+{
+	ft_buf_init(b, fd);
+	b->capture = 1;
+}
+
+static void ft_buf_write_all(int fd, const char* s, size_t len)
+{
+	size_t off = 0;
+	while (off < len) {
+		ssize_t n = write(fd, s + off, len - off);
+		if (n <= 0)
+			break;
+		off += (size_t)n;
+	}
+}
+
+/* Move 'data' to the end of the spill area, doubling it as needed; 0 if no
+ * scratch memory could be had. */
+static int ft_buf_spill(t_ft_buf* b)
+{
+	if (b->spill_cap - b->spill_len < b->len) {
+		size_t cap = b->spill_cap ? b->spill_cap * 2 : ft_align_up(FT_BUF_SIZE * 4, ft_page_size());
+		while (cap - b->spill_len < b->len)
+			cap *= 2;
+		char* p = (char*)ft_scratch_map(cap);
+		if (!p)
+			return 0;
+		ft_memcpy(p, b->spill, b->spill_len);
+		ft_scratch_unmap(b->spill, b->spill_cap);
+		b->spill = p;
+		b->spill_cap = cap;
+	}
+	ft_memcpy(b->spill + b->spill_len, b->data, b->len);
+	b->spill_len += b->len;
+	b->len = 0;
+	return 1;
+}
+
+void ft_buf_flush(t_ft_buf* b)
+{
+	if (b->spill) {
+		ft_buf_write_all(b->fd, b->spill, b->spill_len);
+		ft_scratch_unmap(b->spill, b->spill_cap);
+		b->spill = NULL;
+		b->spill_len = 0;
+		b->spill_cap = 0;
+	}
+	ft_buf_write_all(b->fd, b->data, b->len);
+	b->len = 0;
+	b->capture = 0;
+}
+
+/* Empty a full 'data': into the spill area when capturing, else to fd. */
+static void ft_buf_drain(t_ft_buf* b)
+{
+	if (!(b->capture && ft_buf_spill(b)))
+		ft_buf_flush(b);
+}
+
+void ft_buf_write(t_ft_buf* b, const char* s, size_t n)
+{
+	while (n) {
+		if (b->len == FT_BUF_SIZE)
+			ft_buf_drain(b);
+		size_t room = FT_BUF_SIZE - b->len;
+		size_t k = (n < room) ? n : room;
+		for (size_t i = 0; i < k; ++i)
+			b->data[b->len + i] = s[i];
+		b->len += k;
+		s += k;
+		n -= k;
+	}
+}
+
+void ft_buf_putc(t_ft_buf* b, char c)
+{
+	if (b->len == FT_BUF_SIZE)
+		ft_buf_drain(b);
+	b->data[b->len++] = c;
+}
+
+void ft_buf_putstr(t_ft_buf* b, const char* s)
+{
+	if (!s)
+		return;
+	const char* p = s;
+	while (*p)
+		p++;
+	ft_buf_write(b, s, (size_t)(p - s));
+}
+
+void ft_buf_putusize(t_ft_buf* b, size_t v)
+{
+	char tmp[FT_FMT_USIZE_MAX];
+	size_t i = ft_fmt_usize(tmp, v);
+	ft_buf_write(b, tmp + i, sizeof tmp - i);
+}
+
+void ft_buf_puthex_ptr(t_ft_buf* b, const void* p)
+{
+	char tmp[FT_FMT_PTR_MAX];
+	size_t i = ft_fmt_hex_ptr(tmp, p);
+	ft_buf_write(b, tmp + i, sizeof tmp - i);
+}
+
+/* ---------------- unbuffered stdout ---------------- */
+
 void ft_putc(char c)
 {
 	(void)!write(1, &c, 1);
@@ -73,36 +224,14 @@ void ft_putstr(const char* s)
 
 void ft_putusize(size_t v)
 {
-	char buf[32];
-	size_t i = 0;
-	if (v == 0) {
-		ft_putc('0');
-		return;
-	}
-	while (v) {
-		buf[i++] = (char)('0' + (v % 10));
-		v /= 10;
-	}
-	while (i--)
-		ft_putc(buf[i]);
+	char tmp[FT_FMT_USIZE_MAX];
+	size_t i = ft_fmt_usize(tmp, v);
+	(void)!write(1, tmp + i, sizeof tmp - i);
 }
 
 void ft_puthex_ptr(const void* p)
 {
-	static const char hex[] = "0123456789abcdef";
-	uintptr_t x = (uintptr_t)p;
-	ft_putstr("0x");
-
-	int started = 0;
-	for (int sh = (int)(sizeof(uintptr_t) * 8 - 4); sh >= 0; sh -= 4) {
-		unsigned nib = (unsigned)((x >> sh) & 0xF);
-		if (!started) {
-			if (nib == 0 && sh > 0)
-				continue;
-			started = 1;
-		}
-		ft_putc(hex[nib]);
-	}
-	if (!started)
-		ft_putc('0');
+	char tmp[FT_FMT_PTR_MAX];
+	size_t i = ft_fmt_hex_ptr(tmp, p);
+	(void)!write(1, tmp + i, sizeof tmp - i);
 }
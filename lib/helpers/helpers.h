@@ -19,17 +19,52 @@
 /* Alignment for returned payloads and internal pointers (heap & zone agree) */
 #define FT_ALIGN 16
 
-/* Byte-wise memcpy replacement.
-   Copies n bytes from src to dst; returns dst. */
+/* memcpy replacement: copies n bytes from src to dst; returns dst.
+   Dispatches to the widest vector variant the CPU runs (memops.c). */
 void* ft_memcpy(void* dst, const void* src, size_t n);
 
+/* memset replacement: fills n bytes of dst with (unsigned char)c. */
+void* ft_memset(void* dst, int c, size_t n);
+
 size_t ft_page_size(void);
 size_t ft_align_up(size_t n, size_t a);
 
+/* Anonymous private mapping for short-lived scratch space (sort arrays, report
+   buffers) that must not come from the heap being inspected. NULL on failure. */
+void* ft_scratch_map(size_t bytes);
+void ft_scratch_unmap(void* p, size_t bytes);
+
 /* printing helpers (stdout, no stdio) */
 void ft_putc(char c);
 void ft_putstr(const char* s);
 void ft_putusize(size_t v);		   /* decimal */
 void ft_puthex_ptr(const void* p); /* prints like 0x1a2b3c */
 
+/* Buffered output: text accumulates in 'data' and reaches 'fd' in large
+   write(2) calls, when the buffer fills or on ft_buf_flush. Meant to live on
+   the stack of a single report; always flush before it goes out of scope.
+   A capturing buffer (ft_buf_init_capture) writes nothing until ft_buf_flush:
+   full buffers spill into scratch memory instead, so a report can be built
+   under a lock and written once it is released. */
+#define FT_BUF_SIZE 4096
+
+typedef struct s_ft_buf {
+	int fd;
+	size_t len;
+	int capture;	  /* spill instead of writing until ft_buf_flush */
+	char* spill;	  /* captured output before 'data' (scratch mapped) */
+	size_t spill_len; /* bytes in spill */
+	size_t spill_cap; /* bytes mapped for spill */
+	char data[FT_BUF_SIZE];
+} t_ft_buf;
+
+void ft_buf_init(t_ft_buf* b, int fd);
+void ft_buf_init_capture(t_ft_buf* b, int fd);
+void ft_buf_flush(t_ft_buf* b);
+void ft_buf_write(t_ft_buf* b, const char* s, size_t n);
+void ft_buf_putc(t_ft_buf* b, char c);
+void ft_buf_putstr(t_ft_buf* b, const char* s);
+void ft_buf_putusize(t_ft_buf* b, size_t v);
+void ft_buf_puthex_ptr(t_ft_buf* b, const void* p);
+
 #endif /* HELPERS_H */
@@ -0,0 +1,367 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   memops.c                                           :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/19 09:31:52 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/19 09:31:52 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "memops.h"
+#include "helpers.h"
+
+#include <stdint.h>
+#include <stdlib.h> /* getenv */
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define FT_MEMOPS_X86 1
+#else
+#define FT_MEMOPS_X86 0
+#endif
+
+/* no LLC size from sysconf: assume a mid-size shared cache */
+#define FT_MEMOPS_NT_DEFAULT (4u << 20)
+
+typedef uint64_t __attribute__((may_alias, aligned(1))) t_u64u;
+typedef uint32_t __attribute__((may_alias, aligned(1))) t_u32u;
+typedef uint16_t __attribute__((may_alias, aligned(1))) t_u16u;
+
+size_t g_memops_nt_threshold = 0;
+
+/* ---------------- below one vector ---------------- */
+
+/* n < 16: two overlapping moves of the widest word that fits, loads first */
+static inline void ft_copy_small(unsigned char* d, const unsigned char* s, size_t n)
+{
+	if (n >= 8) {
+		uint64_t a = *(const t_u64u*)s;
+		uint64_t b = *(const t_u64u*)(s + n - 8);
+		*(t_u64u*)d = a;
+		*(t_u64u*)(d + n - 8) = b;
+	} else if (n >= 4) {
+		uint32_t a = *(const t_u32u*)s;
+		uint32_t b = *(const t_u32u*)(s + n - 4);
+		*(t_u32u*)d = a;
+		*(t_u32u*)(d + n - 4) = b;
+	} else if (n >= 2) {
+		uint16_t a = *(const t_u16u*)s;
+		uint16_t b = *(const t_u16u*)(s + n - 2);
+		*(t_u16u*)d = a;
+		*(t_u16u*)(d + n - 2) = b;
+	} else if (n) {
+		*d = *s;
+	}
+}
+
+static inline void ft_set_small(unsigned char* d, uint64_t v, size_t n)
+{
+	if (n >= 8) {
+		*(t_u64u*)d = v;
+		*(t_u64u*)(d + n - 8) = v;
+	} else if (n >= 4) {
+		*(t_u32u*)d = (uint32_t)v;
+		*(t_u32u*)(d + n - 4) = (uint32_t)v;
+	} else if (n >= 2) {
+		*(t_u16u*)d = (uint16_t)v;
+		*(t_u16u*)(d + n - 2) = (uint16_t)v;
+	} else if (n) {
+		*d = (unsigned char)v;
+	}
+}
+
+/* ---------------- scalar ---------------- */
+
+static void* ft_memcpy_scalar(void* dst, const void* src, size_t n)
+{
+	unsigned char* d = (unsigned char*)dst;
+	const unsigned char* s = (const unsigned char*)src;
+
+	if (n < 16) {
+		ft_copy_small(d, s, n);
+		return dst;
+	}
+	uint64_t tail = *(const t_u64u*)(s + n - 8);
+	unsigned char* end = d + n - 8;
+	for (; d < end; d += 8, s += 8)
+		*(t_u64u*)d = *(const t_u64u*)s;
+	*(t_u64u*)end = tail;
+	return dst;
+}
+
+static void* ft_memset_scalar(void* dst, int c, size_t n)
+{
+	unsigned char* d = (unsigned char*)dst;
+	uint64_t v = 0x0101010101010101ull * (unsigned char)c;
+
+	if (n < 16) {
+		ft_set_small(d, v, n);
+		return dst;
+	}
+	unsigned char* end = d + n - 8;
+	for (; d < end; d += 8)
+		*(t_u64u*)d = v;
+	*(t_u64u*)end = v;
+	return dst;
+}
+
+/* ---------------- vector kernels ---------------- */
+
+#if FT_MEMOPS_X86
+
+/* Copy of n >= W bytes: the first and last vectors are stored unaligned (they
+ * may overlap the body), the body in between 4 vectors per turn. Streaming
+ * stores need an aligned destination: the body then starts at the first
+ * W-aligned address past dst. */
+#define FT_MEMOPS_COPY_BODY(VT, W, LOADU, STOREU, STREAM)                                          \
+	unsigned char* d = (unsigned char*)dst;                                                        \
+	const unsigned char* s = (const unsigned char*)src;                                            \
+	VT head = LOADU((const VT*)s);                                                                 \
+	VT tail = LOADU((const VT*)(s + n - W));                                                       \
+	unsigned char* end = d + n - W;                                                                \
+	unsigned char* p = d + W;                                                                      \
+	if (n >= g_memops_nt_threshold) {                                                              \
+		p = (unsigned char*)(((uintptr_t)d + W) & ~(uintptr_t)(W - 1));                            \
+		s += p - d;                                                                                \
+		for (; p + 4 * W <= end; p += 4 * W, s += 4 * W) {                                         \
+			STREAM((VT*)p, LOADU((const VT*)s));                                                   \
+			STREAM((VT*)(p + W), LOADU((const VT*)(s + W)));                                       \
+			STREAM((VT*)(p + 2 * W), LOADU((const VT*)(s + 2 * W)));                               \
+			STREAM((VT*)(p + 3 * W), LOADU((const VT*)(s + 3 * W)));                               \
+		}                                                                                          \
+		for (; p < end; p += W, s += W)                                                            \
+			STREAM((VT*)p, LOADU((const VT*)s));                                                   \
+		_mm_sfence();                                                                              \
+	} else {                                                                                       \
+		s += W;                                                                                    \
+		for (; p + 4 * W <= end; p += 4 * W, s += 4 * W) {                                         \
+			VT a = LOADU((const VT*)s);                                                            \
+			VT b = LOADU((const VT*)(s + W));                                                      \
+			VT c = LOADU((const VT*)(s + 2 * W));                                                  \
+			VT e = LOADU((const VT*)(s + 3 * W));                                                  \
+			STOREU((VT*)p, a);                                                                     \
+			STOREU((VT*)(p + W), b);                                                               \
+			STOREU((VT*)(p + 2 * W), c);                                                           \
+			STOREU((VT*)(p + 3 * W), e);                                                           \
+		}                                                                                          \
+		for (; p < end; p += W, s += W)                                                            \
+			STOREU((VT*)p, LOADU((const VT*)s));                                                   \
+	}                                                                                              \
+	STOREU((VT*)d, head);                                                                          \
+	STOREU((VT*)end, tail);                                                                        \
+	return dst;
+
+#define FT_MEMOPS_SET_BODY(VT, W, V, STOREU, STREAM)                                               \
+	unsigned char* d = (unsigned char*)dst;                                                        \
+	unsigned char* end = d + n - W;                                                                \
+	unsigned char* p = d + W;                                                                      \
+	if (n >= g_memops_nt_threshold) {                                                              \
+		p = (unsigned char*)(((uintptr_t)d + W) & ~(uintptr_t)(W - 1));                            \
+		for (; p + 4 * W <= end; p += 4 * W) {                                                     \
+			STREAM((VT*)p, V);                                                                     \
+			STREAM((VT*)(p + W), V);                                                               \
+			STREAM((VT*)(p + 2 * W), V);                                                           \
+			STREAM((VT*)(p + 3 * W), V);                                                           \
+		}                                                                                          \
+		for (; p < end; p += W)                                                                    \
+			STREAM((VT*)p, V);                                                                     \
+		_mm_sfence();                                                                              \
+	} else {                                                                                       \
+		for (; p + 4 * W <= end; p += 4 * W) {                                                     \
+			STOREU((VT*)p, V);                                                                     \
+			STOREU((VT*)(p + W), V);                                                               \
+			STOREU((VT*)(p + 2 * W), V);                                                           \
+			STOREU((VT*)(p + 3 * W), V);                                                           \
+		}                                                                                          \
+		for (; p < end; p += W)                                                                    \
+			STOREU((VT*)p, V);                                                                     \
+	}                                                                                              \
+	STOREU((VT*)d, V);                                                                             \
+	STOREU((VT*)end, V);                                                                           \
+	return dst;
+
+/* SSE2 is part of x86-64: no target attribute needed */
+static void* ft_memcpy_sse2(void* dst, const void* src, size_t n)
+{
+	if (n < 16) {
+		ft_copy_small((unsigned char*)dst, (const unsigned char*)src, n);
+		return dst;
+	}
+	FT_MEMOPS_COPY_BODY(__m128i, 16, _mm_loadu_si128, _mm_storeu_si128, _mm_stream_si128)
+}
+
+static void* ft_memset_sse2(void* dst, int c, size_t n)
+{
+	if (n < 16) {
+		ft_set_small((unsigned char*)dst, 0x0101010101010101ull * (unsigned char)c, n);
+		return dst;
+	}
+	__m128i v = _mm_set1_epi8((char)c);
+	FT_MEMOPS_SET_BODY(__m128i, 16, v, _mm_storeu_si128, _mm_stream_si128)
+}
+
+/* below one vector, the next narrower variant takes over */
+__attribute__((target("avx2"))) static void* ft_memcpy_avx2(void* dst, const void* src, size_t n)
+{
+	if (n < 32)
+		return ft_memcpy_sse2(dst, src, n);
+	FT_MEMOPS_COPY_BODY(
+		__m256i, 32, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_stream_si256)
+}
+
+__attribute__((target("avx2"))) static void* ft_memset_avx2(void* dst, int c, size_t n)
+{
+	if (n < 32)
+		return ft_memset_sse2(dst, c, n);
+	__m256i v = _mm256_set1_epi8((char)c);
+	FT_MEMOPS_SET_BODY(__m256i, 32, v, _mm256_storeu_si256, _mm256_stream_si256)
+}
+
+__attribute__((target("avx512f"))) static void* ft_memcpy_avx512(
+	void* dst, const void* src, size_t n)
+{
+	if (n < 64)
+		return ft_memcpy_avx2(dst, src, n);
+	FT_MEMOPS_COPY_BODY(
+		__m512i, 64, _mm512_loadu_si512, _mm512_storeu_si512, _mm512_stream_si512)
+}
+
+__attribute__((target("avx512f"))) static void* ft_memset_avx512(void* dst, int c, size_t n)
+{
+	if (n < 64)
+		return ft_memset_avx2(dst, c, n);
+	__m512i v = _mm512_set1_epi8((char)c);
+	FT_MEMOPS_SET_BODY(__m512i, 64, v, _mm512_storeu_si512, _mm512_stream_si512)
+}
+
+#endif /* FT_MEMOPS_X86 */
+
+/* ---------------- dispatch ---------------- */
+
+/* narrowest first; on x86 each one implies the ones before it */
+static const t_memops g_variants[] = {
+	{"scalar", ft_memcpy_scalar, ft_memset_scalar},
+#if FT_MEMOPS_X86
+	{"sse2", ft_memcpy_sse2, ft_memset_sse2},
+	{"avx2", ft_memcpy_avx2, ft_memset_avx2},
+	{"avx512", ft_memcpy_avx512, ft_memset_avx512},
+#endif
+};
+#define FT_MEMOPS_NVARIANTS (sizeof g_variants / sizeof g_variants[0])
+
+static void* ft_memcpy_resolve(void* dst, const void* src, size_t n);
+static void* ft_memset_resolve(void* dst, int c, size_t n);
+
+static const t_memops g_unresolved = {"unresolved", ft_memcpy_resolve, ft_memset_resolve};
+static const t_memops* g_current = &g_unresolved;
+
+static size_t ft_memops_supported(void)
+{
+#if FT_MEMOPS_X86
+	/* may run before the constructors: initialize the CPU model ourselves */
+	__builtin_cpu_init();
+	if (!__builtin_cpu_supports("avx2"))
+		return 2;
+	if (!__builtin_cpu_supports("avx512f"))
+		return 3;
+	return 4;
+#else
+	return 1;
+#endif
+}
+
+static int ft_memops_name_is(const char* a, const char* b)
+{
+	while (*a && *a == *b) {
+		++a;
+		++b;
+	}
+	return *a == *b;
+}
+
+static size_t ft_memops_nt_default(void)
+{
+#ifdef _SC_LEVEL3_CACHE_SIZE
+	long llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+	if (llc <= 0)
+		llc = sysconf(_SC_LEVEL2_CACHE_SIZE);
+	/* the LLC is shared by every core: past a quarter of it, a copy mostly
+	 * evicts lines other threads still need (glibc uses the same cut) */
+	if (llc > 0)
+		return (size_t)llc / 4;
+#endif
+	return FT_MEMOPS_NT_DEFAULT;
+}
+
+static const t_memops* ft_memops_resolve(void)
+{
+	const t_memops* v = __atomic_load_n(&g_current, __ATOMIC_ACQUIRE);
+	if (v != &g_unresolved)
+		return v;
+
+	size_t n = ft_memops_supported();
+	const char* want = getenv(FT_MEMOPS_ENV);
+	v = &g_variants[n - 1];
+	for (size_t i = 0; want && i < n; ++i)
+		if (ft_memops_name_is(want, g_variants[i].name))
+			v = &g_variants[i];
+	if (!__atomic_load_n(&g_memops_nt_threshold, __ATOMIC_RELAXED))
+		__atomic_store_n(&g_memops_nt_threshold, ft_memops_nt_default(), __ATOMIC_RELAXED);
+	/* racing resolvers pick the same variant */
+	__atomic_store_n(&g_current, v, __ATOMIC_RELEASE);
+	return v;
+}
+
+static void* ft_memcpy_resolve(void* dst, const void* src, size_t n)
+{
+	return ft_memops_resolve()->copy(dst, src, n);
+}
+
+static void* ft_memset_resolve(void* dst, int c, size_t n)
+{
+	return ft_memops_resolve()->set(dst, c, n);
+}
+
+const t_memops* ft_memops_available(size_t* n)
+{
+	*n = ft_memops_supported();
+	return g_variants;
+}
+
+const t_memops* ft_memops_current(void)
+{
+	return ft_memops_resolve();
+}
+
+int ft_memops_select(const char* name)
+{
+	size_t n = ft_memops_supported();
+
+	ft_memops_resolve();
+	for (size_t i = 0; i < n; ++i) {
+		if (ft_memops_name_is(name, g_variants[i].name)) {
+			__atomic_store_n(&g_current, &g_variants[i], __ATOMIC_RELEASE);
+			return 0;
+		}
+	}
+	return -1;
+}
+
+/* ---------------- entry points ---------------- */
+
+void* ft_memcpy(void* dst, const void* src, size_t n)
+{
+	/* memcpy semantics: if n==0, OK even if pointers are NULL.
+	   If regions overlap and n>0, behavior is undefined. */
+	if (dst == src || n == 0)
+		return dst;
+	return __atomic_load_n(&g_current, __ATOMIC_ACQUIRE)->copy(dst, src, n);
+}
+
+void* ft_memset(void* dst, int c, size_t n)
+{
+	return __atomic_load_n(&g_current, __ATOMIC_ACQUIRE)->set(dst, c, n);
+}
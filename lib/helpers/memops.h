@@ -0,0 +1,50 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   memops.h                                           :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/19 09:31:52 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/19 09:31:52 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef FT_MEMOPS_H
+#define FT_MEMOPS_H
+
+#include <stddef.h>
+
+/* Back ends of ft_memcpy/ft_memset.
+ * - scalar: 8-byte words, any CPU; sse2, avx2, avx512: 16/32/64-byte vectors
+ *   (x86-64 only), unaligned loads, overlapping head and tail stores;
+ * - the variant is picked on the first call: the widest one the CPU and OS
+ *   support, or the one named in FT_MALLOC_MEMOPS; from then on a call costs
+ *   one indirect jump;
+ * - above g_memops_nt_threshold bytes the vector variants use non-temporal
+ *   stores, so a huge copy does not evict the whole cache.
+ * This file is built with -O2 whatever the library flags (see Makefile). */
+
+#define FT_MEMOPS_ENV "FT_MALLOC_MEMOPS"
+
+typedef struct s_memops {
+	const char* name;
+	void* (*copy)(void* dst, const void* src, size_t n);
+	void* (*set)(void* dst, int c, size_t n);
+} t_memops;
+
+/* Variants this CPU runs, narrowest first; their count goes to *n. */
+const t_memops* ft_memops_available(size_t* n);
+
+/* Variant behind ft_memcpy/ft_memset (resolved if not yet). */
+const t_memops* ft_memops_current(void);
+
+/* Dispatch to the variant called 'name'. Returns 0, or -1 if this CPU cannot
+ * run it (the current one stays). */
+int ft_memops_select(const char* name);
+
+/* Copies and fills of at least this many bytes bypass the cache. Set from the
+ * last-level cache size when the variant is resolved, unless already set. */
+extern size_t g_memops_nt_threshold;
+
+#endif /* FT_MEMOPS_H */
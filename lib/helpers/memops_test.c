@@ -0,0 +1,126 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   memops_test.c                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/19 10:52:20 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/19 10:52:20 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "helpers/memops.h"
+#include "helpers/helpers.h"
+#include "munit.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define GUARD 64
+#define BIG ((1u << 16) + 77)
+
+static unsigned char g_src[BIG + 2 * GUARD];
+static unsigned char g_dst[BIG + 2 * GUARD];
+
+static void fill_pattern(unsigned char* p, size_t n, unsigned seed)
+{
+	for (size_t i = 0; i < n; ++i)
+		p[i] = (unsigned char)(i * 131u + seed);
+}
+
+/* copy n bytes between the given misalignments; nothing outside may change */
+static void check_copy(const t_memops* v, size_t n, size_t soff, size_t doff)
+{
+	size_t span = n + 2 * GUARD; /* only the bytes around the copy are checked */
+	fill_pattern(g_src, span, 7);
+	memset(g_dst, 0xee, span);
+	munit_assert_ptr_equal(v->copy(g_dst + GUARD + doff, g_src + GUARD + soff, n),
+						   g_dst + GUARD + doff);
+	munit_assert_memory_equal(n, g_dst + GUARD + doff, g_src + GUARD + soff);
+	for (size_t i = 0; i < GUARD + doff; ++i)
+		munit_assert_uint8(g_dst[i], ==, 0xee);
+	for (size_t i = GUARD + doff + n; i < span; ++i)
+		munit_assert_uint8(g_dst[i], ==, 0xee);
+}
+
+static void check_set(const t_memops* v, size_t n, size_t doff)
+{
+	size_t span = n + 2 * GUARD;
+	memset(g_dst, 0xee, span);
+	munit_assert_ptr_equal(v->set(g_dst + GUARD + doff, 0x1a5, n), g_dst + GUARD + doff);
+	for (size_t i = 0; i < span; ++i) {
+		int inside = i >= GUARD + doff && i < GUARD + doff + n;
+		munit_assert_uint8(g_dst[i], ==, inside ? 0xa5 : 0xee);
+	}
+}
+
+static void check_variant(const t_memops* v)
+{
+	for (size_t n = 0; n <= 300; ++n)
+		for (size_t off = 0; off < 4; ++off) {
+			check_copy(v, n, off, (off * 5) % 4);
+			check_set(v, n, off);
+		}
+	for (size_t off = 0; off < 64; off += 13) {
+		check_copy(v, BIG, off, 63 - off);
+		check_set(v, BIG, off);
+	}
+}
+
+static MunitResult test_every_variant_copies_and_fills(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+	size_t n;
+	const t_memops* all = ft_memops_available(&n);
+
+	munit_assert_size(n, >=, 1);
+	munit_assert_string_equal(all[0].name, "scalar");
+	munit_assert_ptr_equal(ft_memops_current(), &all[n - 1]);
+
+	/* cached stores, then streaming stores from a couple of vectors up */
+	size_t saved = g_memops_nt_threshold;
+	for (size_t i = 0; i < n; ++i) {
+		g_memops_nt_threshold = SIZE_MAX;
+		check_variant(&all[i]);
+		g_memops_nt_threshold = 200;
+		check_variant(&all[i]);
+	}
+	g_memops_nt_threshold = saved;
+	return MUNIT_OK;
+}
+
+static MunitResult test_select_switches_the_entry_points(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+	size_t n;
+	const t_memops* all = ft_memops_available(&n);
+
+	munit_assert_int(ft_memops_select("scalar"), ==, 0);
+	munit_assert_ptr_equal(ft_memops_current(), &all[0]);
+	munit_assert_int(ft_memops_select("mmx"), ==, -1);
+	munit_assert_ptr_equal(ft_memops_current(), &all[0]);
+	munit_assert_int(ft_memops_select(all[n - 1].name), ==, 0);
+
+	char a[100];
+	char b[100];
+	ft_memset(a, 'x', sizeof a);
+	munit_assert_ptr_equal(ft_memcpy(b, a, sizeof a), b);
+	munit_assert_memory_equal(sizeof a, a, b);
+	munit_assert_ptr_equal(ft_memcpy(NULL, NULL, 0), NULL);
+	return MUNIT_OK;
+}
+
+static MunitTest tests[] = {
+	{"/memops/every_variant_copies_and_fills", test_every_variant_copies_and_fills, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/memops/select_switches_the_entry_points", test_select_switches_the_entry_points, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+static const MunitSuite suite = {"/memops", tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
+
+int main(int argc, char* argv[MUNIT_ARRAY_PARAM(argc + 1)])
+{
+	return munit_suite_main(&suite, NULL, argc, argv);
+}
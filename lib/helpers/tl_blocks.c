@@ -0,0 +1,73 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   tl_blocks.c                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/20 10:05:41 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/20 10:05:41 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "helpers/tl_blocks.h"
+#include "helpers/helpers.h"
+
+#include <errno.h>
+
+/* runs in the exiting thread: b->slot is still its own pointer */
+static void ft_tl_thread_exit(void* block)
+{
+	t_tl_block* b = (t_tl_block*)block;
+	__atomic_store_n(&b->state, b->reg->exit_state, __ATOMIC_RELEASE);
+	*b->slot = FT_TL_BLOCK_GONE;
+}
+
+void ft_tl_registry_start(t_tl_registry* reg)
+{
+	if (!reg->key_ok)
+		reg->key_ok = pthread_key_create(&reg->key, ft_tl_thread_exit) == 0;
+}
+
+void ft_tl_registry_after_fork(t_tl_registry* reg, t_tl_block** slot)
+{
+	for (t_tl_block* b = ft_tl_blocks(reg); b; b = b->next)
+		b->state = FT_TL_BLOCK_FREE;
+	if (*slot == FT_TL_BLOCK_GONE)
+		return;
+	*slot = NULL;
+	if (reg->key_ok)
+		pthread_setspecific(reg->key, NULL);
+}
+
+t_tl_block* ft_tl_block_acquire(t_tl_registry* reg, t_tl_block** slot)
+{
+	int saved_errno = errno; /* malloc may already have set ENOMEM */
+	t_tl_block* b;
+	for (b = ft_tl_blocks(reg); b; b = b->next) {
+		int expected = FT_TL_BLOCK_FREE;
+		if (__atomic_compare_exchange_n(
+				&b->state, &expected, FT_TL_BLOCK_LIVE, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+			break;
+	}
+	if (!b) {
+		b = (t_tl_block*)ft_scratch_map(reg->block_size);
+		if (!b) {
+			errno = saved_errno;
+			return NULL;
+		}
+		b->state = FT_TL_BLOCK_LIVE;
+		b->reg = reg;
+		b->next = __atomic_load_n(&reg->blocks, __ATOMIC_RELAXED);
+		while (!__atomic_compare_exchange_n(
+			&reg->blocks, &b->next, b, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+			;
+	}
+	b->slot = slot;
+	*slot = b;
+	/* may allocate (keys past the first 32): *slot is already set */
+	if (reg->key_ok)
+		pthread_setspecific(reg->key, b);
+	errno = saved_errno;
+	return b;
+}
@@ -0,0 +1,75 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   tl_blocks.h                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/20 10:05:41 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/20 10:05:41 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef FT_TL_BLOCKS_H
+#define FT_TL_BLOCKS_H
+
+#include <pthread.h>
+#include <stddef.h>
+
+/* Per-thread blocks (lib/latency, lib/trace, lib/sizehist).
+ * - a thread's first record maps a block of block_size bytes and pushes it
+ *   on a registry list that readers walk without a lock (push-only, so a
+ *   block, once seen, stays valid);
+ * - at thread exit a key destructor sets the block to the registry's
+ *   exit_state and the thread's pointer to FT_TL_BLOCK_GONE;
+ * - a FREE block is taken over by the next new thread, contents and all.
+ * A block starts with a t_tl_block header; only its owner writes the rest. */
+
+typedef enum e_tl_block_state {
+	FT_TL_BLOCK_LIVE,	  /* owned by a running thread */
+	FT_TL_BLOCK_FREE,	  /* can be claimed by a new thread */
+	FT_TL_BLOCK_DETACHED, /* owner exited; the module frees it when done */
+} t_tl_block_state;
+
+typedef struct s_tl_block {
+	struct s_tl_block* next;	/* registry, push-only */
+	int state;					/* t_tl_block_state */
+	struct s_tl_registry* reg;
+	struct s_tl_block** slot; /* the owner's thread-local pointer */
+} t_tl_block;
+
+typedef struct s_tl_registry {
+	size_t block_size; /* header included */
+	int exit_state;	   /* FT_TL_BLOCK_FREE or FT_TL_BLOCK_DETACHED */
+	int key_ok;
+	pthread_key_t key;
+	t_tl_block* blocks;
+} t_tl_registry;
+
+#define FT_TL_REGISTRY_INIT(size, exit_state) {(size), (exit_state), 0, 0, NULL}
+
+/* a thread's pointer after its key destructor ran: record nothing more */
+#define FT_TL_BLOCK_GONE ((t_tl_block*)1)
+
+/* Create the key that gives blocks back at thread exit, once. Callers
+ * serialize (the module's enable lock). */
+void ft_tl_registry_start(t_tl_registry* reg);
+
+/* Take over a FREE block, or map and register a new one, and store it in
+ * *slot (the calling thread's pointer, NULL so far). Returns it, or NULL if
+ * no memory is left. errno is preserved. */
+t_tl_block* ft_tl_block_acquire(t_tl_registry* reg, t_tl_block** slot);
+
+/* In a fork child, where only the calling thread survives: every block
+ * becomes FREE, contents kept, and the thread's pointer NULL (unless GONE),
+ * so its next record acquires a block again. For pthread_atfork handlers;
+ * the module clears whatever the child must not inherit. */
+void ft_tl_registry_after_fork(t_tl_registry* reg, t_tl_block** slot);
+
+/* First block of the registry, for readers (then ->next). */
+static inline t_tl_block* ft_tl_blocks(t_tl_registry* reg)
+{
+	return __atomic_load_n(&reg->blocks, __ATOMIC_ACQUIRE);
+}
+
+#endif /* FT_TL_BLOCKS_H */
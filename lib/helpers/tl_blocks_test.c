@@ -0,0 +1,108 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   tl_blocks_test.c                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/20 10:05:41 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/20 10:05:41 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "helpers/tl_blocks.h"
+#include "munit.h"
+
+#include <pthread.h>
+#include <stdint.h>
+
+typedef struct s_test_block {
+	t_tl_block hdr;
+	uint64_t count;
+} t_test_block;
+
+static __thread t_tl_block* tl_test;
+
+typedef struct s_worker {
+	t_tl_registry* reg;
+	t_tl_block* got;
+} t_worker;
+
+/* count once into this thread's block */
+static void* worker(void* arg)
+{
+	t_worker* w = arg;
+	w->got = ft_tl_block_acquire(w->reg, &tl_test);
+	((t_test_block*)w->got)->count++;
+	return NULL;
+}
+
+static t_tl_block* run_worker(t_tl_registry* reg)
+{
+	t_worker w = {reg, NULL};
+	pthread_t th;
+	munit_assert_int(pthread_create(&th, NULL, worker, &w), ==, 0);
+	pthread_join(th, NULL);
+	munit_assert_not_null(w.got);
+	return w.got;
+}
+
+static MunitResult test_free_blocks_go_to_new_threads(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+
+	static t_tl_registry reg = FT_TL_REGISTRY_INIT(sizeof(t_test_block), FT_TL_BLOCK_FREE);
+	ft_tl_registry_start(&reg);
+
+	t_tl_block* a = run_worker(&reg);
+	munit_assert_int(a->state, ==, FT_TL_BLOCK_FREE);
+	t_tl_block* b = run_worker(&reg);
+	munit_assert_ptr_equal(b, a);
+	munit_assert_uint64(((t_test_block*)b)->count, ==, 2);
+	munit_assert_ptr_equal(ft_tl_blocks(&reg), a);
+	munit_assert_null(a->next);
+	return MUNIT_OK;
+}
+
+static MunitResult test_detached_blocks_wait_for_their_module(
+	const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+
+	static t_tl_registry reg = FT_TL_REGISTRY_INIT(sizeof(t_test_block), FT_TL_BLOCK_DETACHED);
+	ft_tl_registry_start(&reg);
+
+	t_tl_block* a = run_worker(&reg);
+	munit_assert_int(a->state, ==, FT_TL_BLOCK_DETACHED);
+	t_tl_block* b = run_worker(&reg);
+	munit_assert_ptr_not_equal(b, a);
+
+	/* freed by its module: the next thread takes it */
+	__atomic_store_n(&a->state, FT_TL_BLOCK_FREE, __ATOMIC_RELEASE);
+	munit_assert_ptr_equal(run_worker(&reg), a);
+	return MUNIT_OK;
+}
+
+static MunitTest tests[] = {
+	{"/tl_blocks/free_blocks_go_to_new_threads",
+	 test_free_blocks_go_to_new_threads,
+	 NULL,
+	 NULL,
+	 MUNIT_TEST_OPTION_NONE,
+	 NULL},
+	{"/tl_blocks/detached_blocks_wait_for_their_module",
+	 test_detached_blocks_wait_for_their_module,
+	 NULL,
+	 NULL,
+	 MUNIT_TEST_OPTION_NONE,
+	 NULL},
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+static const MunitSuite suite = {"/tl_blocks", tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
+
+int main(int argc, char* argv[MUNIT_ARRAY_PARAM(argc + 1)])
+{
+	return munit_suite_main(&suite, NULL, argc, argv);
+}
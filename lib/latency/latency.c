@@ -0,0 +1,142 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   latency.c                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/17 14:03:26 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/17 14:03:26 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "latency/latency.h"
+#include "helpers/helpers.h"
+
+#include <pthread.h>
+#include <stdlib.h> /* getenv */
+
+int g_latency_on = 0;
+
+static struct {
+	pthread_mutex_t lock; /* enable/disable */
+	t_tl_registry reg;
+	uint64_t start_ticks; /* clock pair of the first enable, for ticks_per_ns */
+	uint64_t start_ns;
+} g_lat = {PTHREAD_MUTEX_INITIALIZER, FT_TL_REGISTRY_INIT(sizeof(t_lat_block), FT_TL_BLOCK_FREE),
+		   0, 0};
+
+static __thread t_tl_block* tl_block __attribute__((tls_model("initial-exec")));
+
+static uint64_t ft_latency_now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Only the owner thread writes its block; readers load with relaxed atomics
+ * and may see a call half-recorded. */
+void ft_latency_record(int op, uint64_t ticks, uint32_t klass, int slow)
+{
+	t_tl_block* t = tl_block;
+	if (t == FT_TL_BLOCK_GONE)
+		return;
+	if (!t && !(t = ft_tl_block_acquire(&g_lat.reg, &tl_block)))
+		return;
+	t_lat_block* b = (t_lat_block*)t;
+	if (klass >= FT_STATS_NCLASSES)
+		klass = FT_STATS_NCLASSES - 1;
+
+	ft_lat_hist_t* h = &b->hist[op][klass][slow ? FT_LAT_SLOW : FT_LAT_FAST];
+	uint64_t* slot = &h->buckets[ft_lat_bucket(ticks)];
+	__atomic_store_n(slot, *slot + 1, __ATOMIC_RELAXED);
+	__atomic_store_n(&h->sum_ticks, h->sum_ticks + ticks, __ATOMIC_RELAXED);
+	if (ticks > h->max_ticks)
+		__atomic_store_n(&h->max_ticks, ticks, __ATOMIC_RELAXED);
+	__atomic_store_n(&h->count, h->count + 1, __ATOMIC_RELAXED);
+}
+
+/* ---------------- public API ---------------- */
+
+int ft_malloc_latency_enable(int on)
+{
+	pthread_mutex_lock(&g_lat.lock);
+	int was = __atomic_load_n(&g_latency_on, __ATOMIC_RELAXED);
+	if (on)
+		ft_tl_registry_start(&g_lat.reg);
+	if (on && !g_lat.start_ns) {
+		g_lat.start_ticks = ft_latency_ticks();
+		g_lat.start_ns = ft_latency_now_ns();
+	}
+	__atomic_store_n(&g_latency_on, on != 0, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&g_lat.lock);
+	return was;
+}
+
+static void ft_lat_hist_add(ft_lat_hist_t* dst, const ft_lat_hist_t* src)
+{
+	dst->count += __atomic_load_n(&src->count, __ATOMIC_RELAXED);
+	dst->sum_ticks += __atomic_load_n(&src->sum_ticks, __ATOMIC_RELAXED);
+	uint64_t max = __atomic_load_n(&src->max_ticks, __ATOMIC_RELAXED);
+	if (max > dst->max_ticks)
+		dst->max_ticks = max;
+	for (size_t i = 0; i < FT_LAT_BUCKETS; ++i)
+		dst->buckets[i] += __atomic_load_n(&src->buckets[i], __ATOMIC_RELAXED);
+}
+
+void ft_malloc_latency(ft_malloc_latency_t* out)
+{
+	if (!out)
+		return;
+	ft_memset(out, 0, sizeof(*out));
+
+	for (t_tl_block* t = ft_tl_blocks(&g_lat.reg); t; t = t->next) {
+		t_lat_block* b = (t_lat_block*)t;
+		for (int op = 0; op < FT_LAT_NOPS; ++op)
+			for (int k = 0; k < FT_STATS_NCLASSES; ++k)
+				for (int p = 0; p < FT_LAT_NPATHS; ++p)
+					ft_lat_hist_add(&out->hist[op][k][p], &b->hist[op][k][p]);
+	}
+
+	uint64_t start_ns = __atomic_load_n(&g_lat.start_ns, __ATOMIC_ACQUIRE);
+	uint64_t ns = start_ns ? ft_latency_now_ns() - start_ns : 0;
+	if (ns)
+		out->ticks_per_ns = (double)(ft_latency_ticks() - g_lat.start_ticks) / (double)ns;
+}
+
+void ft_malloc_latency_reset(void)
+{
+	for (t_tl_block* t = ft_tl_blocks(&g_lat.reg); t; t = t->next)
+		ft_memset(((t_lat_block*)t)->hist, 0, sizeof(((t_lat_block*)t)->hist));
+}
+
+uint64_t ft_lat_hist_quantile(const ft_lat_hist_t* h, double q)
+{
+	if (!h || !h->count)
+		return 0;
+	if (q < 0)
+		q = 0;
+	uint64_t rank = (uint64_t)(q * (double)h->count);
+	if (rank >= h->count)
+		rank = h->count - 1;
+
+	uint64_t seen = 0;
+	for (size_t i = 0; i < FT_LAT_BUCKETS; ++i) {
+		seen += h->buckets[i];
+		if (seen > rank) {
+			uint64_t top = (i + 1 < FT_LAT_BUCKETS) ? ft_lat_bucket_floor(i + 1) - 1 : h->max_ticks;
+			return top < h->max_ticks ? top : h->max_ticks;
+		}
+	}
+	return h->max_ticks;
+}
+
+/* ---------------- process lifetime ---------------- */
+
+__attribute__((constructor)) static void ft_latency_from_env(void)
+{
+	const char* v = getenv(FT_LATENCY_ENV);
+	if (v && *v && *v != '0')
+		(void)ft_malloc_latency_enable(1);
+}
@@ -0,0 +1,100 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   latency.h                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/17 14:03:26 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/17 14:03:26 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef FT_LATENCY_H
+#define FT_LATENCY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "malloc.h" /* public ft_malloc_latency* API */
+#include "heap/heap.h"
+#include "helpers/tl_blocks.h"
+
+/* In-allocator latency histograms.
+ * - the public entry points take a mark before calling into the heap and
+ *   close it after: rdtsc twice, plus the thread's zone-event count from
+ *   g_heap_op_note to tell the slow path (a zone mapped or unmapped) apart;
+ * - each thread records into its own block of histograms (a per-thread
+ *   block, helpers/tl_blocks.h): no lock, no shared cache line;
+ * - blocks of exited threads are handed to new threads with their counts, so
+ *   the totals never lose a call.
+ * When timing is off, a mark costs one relaxed load and a branch. */
+
+#define FT_LATENCY_ENV "FT_MALLOC_LATENCY"
+
+typedef struct s_lat_block {
+	t_tl_block hdr; /* helpers/tl_blocks.h */
+	ft_lat_hist_t hist[FT_LAT_NOPS][FT_STATS_NCLASSES][FT_LAT_NPATHS];
+} t_lat_block;
+
+typedef struct s_lat_mark {
+	uint64_t start; /* 0: not timing this call */
+	uint32_t zone_events;
+} t_lat_mark;
+
+extern int g_latency_on;
+
+void ft_latency_record(int op, uint64_t ticks, uint32_t klass, int slow);
+
+static inline uint64_t ft_latency_ticks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/* Bucket of a duration: exact below 2^SUB_BITS, log-linear above. */
+static inline size_t ft_lat_bucket(uint64_t v)
+{
+	if (v < (1u << FT_LAT_SUB_BITS))
+		return (size_t)v;
+	unsigned e = 63u - (unsigned)__builtin_clzll(v);
+	if (e > FT_LAT_MAX_LOG2)
+		return FT_LAT_BUCKETS - 1;
+	size_t sub = (size_t)(v >> (e - FT_LAT_SUB_BITS)) & ((1u << FT_LAT_SUB_BITS) - 1);
+	return ((size_t)(e - FT_LAT_SUB_BITS + 1) << FT_LAT_SUB_BITS) | sub;
+}
+
+/* Smallest duration that falls into bucket b. */
+static inline uint64_t ft_lat_bucket_floor(size_t b)
+{
+	if (b < (1u << FT_LAT_SUB_BITS))
+		return (uint64_t)b;
+	unsigned e = (unsigned)(b >> FT_LAT_SUB_BITS) + FT_LAT_SUB_BITS - 1;
+	uint64_t sub = (uint64_t)(b & ((1u << FT_LAT_SUB_BITS) - 1));
+	return ((1ull << FT_LAT_SUB_BITS) | sub) << (e - FT_LAT_SUB_BITS);
+}
+
+/* Called by the public entry points around the heap call. */
+static inline t_lat_mark ft_latency_begin(void)
+{
+	t_lat_mark m = {0, 0};
+	if (__builtin_expect(__atomic_load_n(&g_latency_on, __ATOMIC_RELAXED), 0)) {
+		m.zone_events = g_heap_op_note.zone_events;
+		m.start = ft_latency_ticks();
+	}
+	return m;
+}
+
+static inline void ft_latency_end(int op, t_lat_mark m)
+{
+	if (__builtin_expect(m.start != 0, 0))
+		ft_latency_record(op, ft_latency_ticks() - m.start, g_heap_op_note.klass,
+						  g_heap_op_note.zone_events != m.zone_events);
+}
+
+#endif /* FT_LATENCY_H */
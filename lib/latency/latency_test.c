@@ -0,0 +1,127 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   latency_test.c                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/17 15:40:12 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/17 15:40:12 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "latency/latency.h"
+#include "munit.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+static MunitResult test_buckets_are_log_linear(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+
+	/* exact at the bottom, then 8 buckets per power of two */
+	for (uint64_t v = 0; v < 16; ++v)
+		munit_assert_size(ft_lat_bucket(v), ==, (size_t)v);
+	munit_assert_size(ft_lat_bucket(16), ==, ft_lat_bucket(17));
+	munit_assert_size(ft_lat_bucket(18), ==, ft_lat_bucket(16) + 1);
+	munit_assert_size(ft_lat_bucket(UINT64_MAX), ==, FT_LAT_BUCKETS - 1);
+
+	size_t prev = 0;
+	for (uint64_t v = 1; v < (1ull << 40); v = v * 9 / 8 + 1) {
+		size_t b = ft_lat_bucket(v);
+		munit_assert_size(b, >=, prev);
+		munit_assert_uint64(ft_lat_bucket_floor(b), <=, v);
+		munit_assert_uint64(v - ft_lat_bucket_floor(b), <=, v / 8);
+		munit_assert_size(ft_lat_bucket(ft_lat_bucket_floor(b)), ==, b);
+		prev = b;
+	}
+
+	ft_lat_hist_t h = {0};
+	for (uint64_t v = 1; v <= 1000; ++v) {
+		h.buckets[ft_lat_bucket(v)]++;
+		h.count++;
+		h.max_ticks = v;
+	}
+	uint64_t p50 = ft_lat_hist_quantile(&h, 0.5);
+	munit_assert_uint64(p50, >=, 500);
+	munit_assert_uint64(p50, <=, 500 + 500 / 8);
+	munit_assert_uint64(ft_lat_hist_quantile(&h, 1.0), ==, 1000);
+	return MUNIT_OK;
+}
+
+static void timed_malloc_free(size_t n)
+{
+	t_lat_mark m = ft_latency_begin();
+	void* p = ft_heap_malloc(n);
+	ft_latency_end(FT_LAT_MALLOC, m);
+	m = ft_latency_begin();
+	ft_heap_free(p);
+	ft_latency_end(FT_LAT_FREE, m);
+}
+
+static void* other_thread(void* arg)
+{
+	(void)arg;
+	for (int i = 0; i < 10; ++i)
+		timed_malloc_free(32);
+	return NULL;
+}
+
+static MunitResult test_paths_classes_and_threads(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+	static ft_malloc_latency_t lat;
+
+	ft_heap_init(&g_heap, 0, 0);
+	ft_malloc_latency_reset();
+	munit_assert_int(ft_malloc_latency_enable(1), ==, 0);
+
+	/* first TINY malloc maps a slab: slow; the slab is kept on free: fast */
+	timed_malloc_free(32);
+	timed_malloc_free(32);
+	/* LARGE maps and unmaps every time */
+	timed_malloc_free(100000);
+
+	pthread_t th;
+	munit_assert_int(pthread_create(&th, NULL, other_thread, NULL), ==, 0);
+	pthread_join(th, NULL);
+
+	munit_assert_int(ft_malloc_latency_enable(0), ==, 1);
+	timed_malloc_free(32); /* off: not recorded */
+
+	ft_malloc_latency(&lat);
+	const ft_lat_hist_t(*m)[FT_LAT_NPATHS] = lat.hist[FT_LAT_MALLOC];
+	const ft_lat_hist_t(*f)[FT_LAT_NPATHS] = lat.hist[FT_LAT_FREE];
+	munit_assert_uint64(m[FT_STATS_TINY][FT_LAT_SLOW].count, ==, 1);
+	munit_assert_uint64(m[FT_STATS_TINY][FT_LAT_FAST].count, ==, 11);
+	munit_assert_uint64(f[FT_STATS_TINY][FT_LAT_FAST].count, ==, 12);
+	munit_assert_uint64(m[FT_STATS_LARGE][FT_LAT_SLOW].count, ==, 1);
+	munit_assert_uint64(f[FT_STATS_LARGE][FT_LAT_SLOW].count, ==, 1);
+	munit_assert_uint64(lat.hist[FT_LAT_REALLOC][FT_STATS_TINY][FT_LAT_FAST].count, ==, 0);
+
+	const ft_lat_hist_t* slow = &m[FT_STATS_LARGE][FT_LAT_SLOW];
+	munit_assert_uint64(slow->sum_ticks, ==, slow->max_ticks);
+	munit_assert_uint64(ft_lat_hist_quantile(slow, 0.5), ==, slow->max_ticks);
+	munit_assert_double(lat.ticks_per_ns, >, 0.0);
+
+	ft_malloc_latency_reset();
+	ft_malloc_latency(&lat);
+	munit_assert_uint64(lat.hist[FT_LAT_MALLOC][FT_STATS_TINY][FT_LAT_FAST].count, ==, 0);
+	ft_heap_destroy(&g_heap);
+	return MUNIT_OK;
+}
+
+static MunitTest tests[] = {
+	{"/latency/buckets_are_log_linear", test_buckets_are_log_linear, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/latency/paths_classes_and_threads", test_paths_classes_and_threads, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+static const MunitSuite suite = {"/latency", tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
+
+int main(int argc, char* argv[MUNIT_ARRAY_PARAM(argc + 1)])
+{
+	return munit_suite_main(&suite, NULL, argc, argv);
+}
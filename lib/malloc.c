@@ -12,30 +12,98 @@
 
 #include "malloc.h"
 #include "heap/heap.h"
+#include "latency/latency.h"
+#include "profile/profile.h"
+#include "sizehist/sizehist.h"
+#include "trace/trace.h"
 
 /* Public API just forwards to heap. These must be exported symbols. */
 void free(void* ptr)
 {
+	if (!ptr)
+		return;
+	ft_trace(FT_TRACE_FREE, ptr, NULL, 0, 0);
+	ft_profile_free(ptr);
+	t_lat_mark lat = ft_latency_begin();
 	ft_heap_free(ptr);
+	ft_latency_end(FT_LAT_FREE, lat);
 }
 
 void* malloc(size_t size)
 {
+	ft_sizehist(size);
+	t_lat_mark lat = ft_latency_begin();
 	void* p = ft_heap_malloc(size);
+	ft_latency_end(FT_LAT_MALLOC, lat);
 	if (!p && size)
 		errno = ENOMEM;
+	ft_profile_alloc(p, size, __builtin_frame_address(0));
+	ft_trace(FT_TRACE_MALLOC, NULL, p, size, 0);
 	return p;
 }
 
+/* The old block is dropped from the profile before the call, so a sample
+ * can never outlive the block. A failed realloc thus loses its sample.
+ * Traced in two halves for the same reason: the release before the call,
+ * the result after it. */
 void* realloc(void* ptr, size_t size)
 {
+	if (size)
+		ft_sizehist(size);
+	ft_trace(FT_TRACE_REALLOC, ptr, NULL, size, 0);
+	ft_profile_free(ptr);
+	t_lat_mark lat = ft_latency_begin();
 	void* np = ft_heap_realloc(ptr, size);
+	ft_latency_end(FT_LAT_REALLOC, lat);
 	if (!np && size)
 		errno = ENOMEM;
+	ft_profile_alloc(np, size, __builtin_frame_address(0));
+	ft_trace(FT_TRACE_REALLOC_RET, ptr, np, size, 0);
 	return np;
 }
 
-void show_alloc_mem()
+void* aligned_alloc(size_t alignment, size_t size)
 {
-	ft_heap_show_alloc_mem();
+	if (!alignment || (alignment & (alignment - 1))) {
+		errno = EINVAL;
+		return NULL;
+	}
+	ft_sizehist(size);
+	void* p = ft_heap_alloc_aligned(&g_heap, alignment, size);
+	if (!p)
+		errno = ENOMEM;
+	ft_profile_alloc(p, size, __builtin_frame_address(0));
+	ft_trace(FT_TRACE_ALIGNED_ALLOC, NULL, p, size, alignment);
+	return p;
+}
+
+void free_sized(void* ptr, size_t size)
+{
+	if (ptr)
+		ft_trace(FT_TRACE_FREE, ptr, NULL, size, 0);
+	ft_profile_free(ptr);
+	ft_heap_dealloc_sized(&g_heap, ptr, size, 0);
+}
+
+void free_aligned_sized(void* ptr, size_t alignment, size_t size)
+{
+	if (ptr)
+		ft_trace(FT_TRACE_FREE, ptr, NULL, size, alignment);
+	ft_profile_free(ptr);
+	ft_heap_dealloc_sized(&g_heap, ptr, size, alignment);
+}
+
+void show_alloc_mem(void)
+{
+	ft_heap_show_alloc_mem(&g_heap);
+}
+
+size_t show_alloc_mem_ex(const ft_show_filter_t* filter)
+{
+	return ft_heap_show_alloc_mem_ex(&g_heap, filter);
+}
+
+int malloc_trim(size_t pad)
+{
+	return ft_heap_trim(&g_heap, pad) != 0;
 }
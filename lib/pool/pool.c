@@ -0,0 +1,158 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   pool.c                                             :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/06 10:12:52 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/06 10:12:52 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "pool/pool.h"
+
+size_t ft_pool_natural_align(size_t obj_size)
+{
+	size_t low = obj_size & (~obj_size + 1); /* lowest set bit */
+	return (low && low < FT_ALIGN) ? low : FT_ALIGN;
+}
+
+static size_t ft_pool_span_for(size_t obj_size)
+{
+	const size_t hdr = ft_align_up(sizeof(t_zone), FT_ALIGN);
+	const size_t want = hdr + FT_POOL_MIN_BLOCKS * (obj_size + 1);
+
+	size_t span = FT_POOL_SPAN;
+	while (span < want) {
+		if (span > SIZE_MAX / 2)
+			return 0;
+		span <<= 1;
+	}
+	return span;
+}
+
+ft_pool_t* ft_pool_create(size_t obj_size, size_t align)
+{
+	if (obj_size == 0)
+		return NULL;
+	if (align == 0)
+		align = ft_pool_natural_align(obj_size);
+	if (align > FT_ALIGN || (align & (align - 1)))
+		return NULL;
+
+	const size_t bsz = ft_align_up(obj_size, align);
+	const size_t span = ft_pool_span_for(bsz);
+	if (bsz == SIZE_MAX || span == 0)
+		return NULL;
+
+	t_zone* self = t_zone_new_large(sizeof(t_pool));
+	if (!self)
+		return NULL;
+
+	t_pool* pool = (t_pool*)self->mem_begin;
+	*pool = (t_pool){0};
+	pool->obj_size = bsz;
+	pool->align = align;
+	pool->span = span;
+	pool->self = self;
+	pthread_mutex_init(&pool->lock, NULL);
+	return pool;
+}
+
+static void* ft_pool_alloc_locked(t_pool* pool)
+{
+	t_zone* z = pool->partial ? FT_CONTAINER_OF(pool->partial, t_zone, link) : NULL;
+	if (!z) {
+		z = ft_zone_new_pool(pool->obj_size, pool->align, pool->span);
+		if (!z)
+			return NULL;
+		ft_ll_push_front(&pool->partial, &z->link);
+		pool->n_zones++;
+	}
+
+	void* p = ft_zone_alloc_block(z);
+	if (z->free_count == 0) {
+		ft_ll_remove(&pool->partial, &z->link);
+		ft_ll_push_front(&pool->full, &z->link);
+	}
+	return p;
+}
+
+static void ft_pool_free_locked(t_pool* pool, void* p)
+{
+	t_zone* z = ft_zone_of_pool_block(p, pool->span);
+	const int was_full = (z->free_count == 0);
+
+	ft_zone_free_block(z, p);
+
+	if (was_full) {
+		ft_ll_remove(&pool->full, &z->link);
+		ft_ll_push_front(&pool->partial, &z->link);
+		return;
+	}
+
+	// keep one empty zone as a cushion, drop the others
+	if (z->free_count == z->capacity && (z->link.prev || z->link.next)) {
+		ft_ll_remove(&pool->partial, &z->link);
+		ft_zone_destroy(z);
+		pool->n_zones--;
+	}
+}
+
+void* ft_pool_alloc(ft_pool_t* pool)
+{
+	if (!pool)
+		return NULL;
+
+	pthread_mutex_lock(&pool->lock);
+	void* p = ft_pool_alloc_locked(pool);
+	pthread_mutex_unlock(&pool->lock);
+	return p;
+}
+
+void ft_pool_free(ft_pool_t* pool, void* p)
+{
+	if (!pool || !p)
+		return;
+
+	pthread_mutex_lock(&pool->lock);
+	ft_pool_free_locked(pool, p);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+size_t ft_pool_alloc_bulk(ft_pool_t* pool, void** out, size_t n)
+{
+	if (!pool || !out)
+		return 0;
+
+	size_t got = 0;
+	pthread_mutex_lock(&pool->lock);
+	while (got < n && (out[got] = ft_pool_alloc_locked(pool)))
+		++got;
+	pthread_mutex_unlock(&pool->lock);
+	return got;
+}
+
+void ft_pool_free_bulk(ft_pool_t* pool, void* const* ptrs, size_t n)
+{
+	if (!pool || !ptrs)
+		return;
+
+	pthread_mutex_lock(&pool->lock);
+	for (size_t i = 0; i < n; ++i) {
+		if (ptrs[i])
+			ft_pool_free_locked(pool, ptrs[i]);
+	}
+	pthread_mutex_unlock(&pool->lock);
+}
+
+void ft_pool_destroy(ft_pool_t* pool)
+{
+	if (!pool)
+		return;
+	ft_zone_ll_destroy(&pool->partial);
+	ft_zone_ll_destroy(&pool->full);
+	pthread_mutex_destroy(&pool->lock);
+	ft_zone_destroy(pool->self);
+}
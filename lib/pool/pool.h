@@ -0,0 +1,54 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   pool.h                                             :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/06 10:12:41 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/06 10:12:41 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef FT_POOL_H
+#define FT_POOL_H
+
+#include <stddef.h>
+#include <pthread.h>
+#include "malloc.h" /* public ft_pool_* API */
+#include "zone/zone.h"
+#include "zone/zone_list.h"
+#include "data_structures/linked_list.h"
+
+/* Smallest zone mapping of a pool; grown (power of two) for big objects. */
+#define FT_POOL_SPAN (64 * 1024)
+/* A pool zone holds at least this many objects. */
+#define FT_POOL_MIN_BLOCKS 32
+
+/* Fixed-size object pool:
+ * - every zone is an FT_Z_POOL slab of exactly obj_size-byte blocks;
+ * - zones are 'span'-aligned, so free() finds the zone by masking the pointer
+ *   (no classification, no owner lookup);
+ * - zones with free blocks live in 'partial', full ones in 'full', so alloc
+ *   never scans;
+ * - the descriptor itself lives in a LARGE zone ('self');
+ * - alloc/free (single or bulk) are serialized by 'lock'.
+ */
+typedef struct s_pool {
+	pthread_mutex_t lock;
+
+	t_ll_node* partial;
+	t_ll_node* full;
+
+	size_t obj_size; /* block size (exact fit, multiple of align) */
+	size_t align;	 /* block alignment, power of two <= FT_ALIGN */
+	size_t span;	 /* zone mapping size & alignment */
+	size_t n_zones;
+
+	t_zone* self;
+} t_pool;
+
+/* Natural alignment for an object size: its lowest set bit, capped at FT_ALIGN. */
+size_t ft_pool_natural_align(size_t obj_size);
+
+#endif /* FT_POOL_H */
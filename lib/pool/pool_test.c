@@ -0,0 +1,183 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   pool_test.c                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/06 11:02:17 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/06 11:02:17 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "pool/pool.h"
+#include "zone/zone.h"
+#include "helpers/helpers.h"
+#include "munit.h"
+
+#include <stdint.h>
+#include <string.h>
+
+static MunitResult test_exact_fit_odd_size(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+
+	ft_pool_t* pool = ft_pool_create(72, 0);
+	munit_assert_ptr_not_null(pool);
+	munit_assert_size(pool->obj_size, ==, 72);
+	munit_assert_size(pool->align, ==, 8);
+
+	uint8_t* a = (uint8_t*)ft_pool_alloc(pool);
+	uint8_t* b = (uint8_t*)ft_pool_alloc(pool);
+	munit_assert_ptr_not_null(a);
+	munit_assert_ptr_not_null(b);
+
+	/* blocks are packed back to back, no rounding to 80 or 128 */
+	munit_assert_size((uintptr_t)b - (uintptr_t)a, ==, 72);
+	munit_assert_size((uintptr_t)a % 8, ==, 0);
+	memset(a, 0x11, 72);
+	memset(b, 0x22, 72);
+	munit_assert_uint8(a[71], ==, 0x11);
+
+	ft_pool_free(pool, a);
+	ft_pool_free(pool, b);
+	ft_pool_destroy(pool);
+	return MUNIT_OK;
+}
+
+static MunitResult test_explicit_align(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+
+	ft_pool_t* pool = ft_pool_create(40, 16);
+	munit_assert_ptr_not_null(pool);
+	munit_assert_size(pool->obj_size, ==, 48);
+	for (int i = 0; i < 10; ++i)
+		munit_assert_size((uintptr_t)ft_pool_alloc(pool) % 16, ==, 0);
+	ft_pool_destroy(pool);
+
+	/* bad alignments are rejected */
+	munit_assert_ptr_null(ft_pool_create(64, 3));
+	munit_assert_ptr_null(ft_pool_create(64, 4096));
+	munit_assert_ptr_null(ft_pool_create(0, 8));
+	return MUNIT_OK;
+}
+
+static MunitResult test_owner_by_mask_across_zones(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+
+	ft_pool_t* pool = ft_pool_create(24, 8);
+	munit_assert_ptr_not_null(pool);
+
+	/* fill more than one zone */
+	void* first = ft_pool_alloc(pool);
+	t_zone* z0 = ft_zone_of_pool_block(first, pool->span);
+	size_t n = z0->capacity * 2 + 5;
+	void** ptrs = (void**)malloc(n * sizeof(void*));
+	munit_assert_ptr_not_null(ptrs);
+	ptrs[0] = first;
+	for (size_t i = 1; i < n; ++i) {
+		ptrs[i] = ft_pool_alloc(pool);
+		munit_assert_ptr_not_null(ptrs[i]);
+		t_zone* z = ft_zone_of_pool_block(ptrs[i], pool->span);
+		munit_assert_int(z->klass, ==, FT_Z_POOL);
+		munit_assert_true(ft_zone_contains(z, ptrs[i]));
+	}
+	munit_assert_size(pool->n_zones, ==, 3);
+
+	/* freeing everything keeps a single empty zone */
+	for (size_t i = 0; i < n; ++i)
+		ft_pool_free(pool, ptrs[i]);
+	munit_assert_size(pool->n_zones, ==, 1);
+	munit_assert_ptr_null(pool->full);
+
+	/* and it is reused */
+	void* again = ft_pool_alloc(pool);
+	munit_assert_ptr_not_null(again);
+	munit_assert_size(pool->n_zones, ==, 1);
+
+	free(ptrs);
+	ft_pool_destroy(pool);
+	return MUNIT_OK;
+}
+
+static MunitResult test_full_zone_returns_to_partial(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+
+	ft_pool_t* pool = ft_pool_create(256, 0);
+	munit_assert_ptr_not_null(pool);
+
+	void* p = ft_pool_alloc(pool);
+	t_zone* z = ft_zone_of_pool_block(p, pool->span);
+	for (size_t i = 1; i < z->capacity; ++i)
+		munit_assert_ptr_not_null(ft_pool_alloc(pool));
+	munit_assert_ptr_not_null(pool->full);
+	munit_assert_ptr_null(pool->partial);
+
+	ft_pool_free(pool, p);
+	munit_assert_ptr_null(pool->full);
+	munit_assert_ptr_equal(ft_pool_alloc(pool), p);
+
+	ft_pool_destroy(pool);
+	return MUNIT_OK;
+}
+
+static MunitResult test_bulk_alloc_and_free(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+
+	ft_pool_t* pool = ft_pool_create(48, 0);
+	munit_assert_ptr_not_null(pool);
+
+	enum { N = 500 };
+	void* ptrs[N];
+	munit_assert_size(ft_pool_alloc_bulk(pool, ptrs, N), ==, N);
+	for (size_t i = 0; i < N; ++i) {
+		memset(ptrs[i], (int)(i & 0xFF), 48);
+		for (size_t j = 0; j < i; j += 97)
+			munit_assert_ptr_not_equal(ptrs[i], ptrs[j]);
+	}
+	/* a refill comes out of the same slab, back to back */
+	munit_assert_size((uintptr_t)ptrs[1] - (uintptr_t)ptrs[0], ==, 48);
+
+	ft_pool_free_bulk(pool, ptrs, N);
+	munit_assert_size(pool->n_zones, ==, 1);
+	munit_assert_ptr_null(pool->full);
+
+	ft_pool_destroy(pool);
+	return MUNIT_OK;
+}
+
+/* ---------- test registry ---------- */
+
+static MunitTest tests[] = {
+	{"/pool/exact_fit_odd_size", test_exact_fit_odd_size, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/pool/explicit_align", test_explicit_align, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/pool/owner_by_mask_across_zones",
+	 test_owner_by_mask_across_zones,
+	 NULL,
+	 NULL,
+	 MUNIT_TEST_OPTION_NONE,
+	 NULL},
+	{"/pool/full_zone_returns_to_partial",
+	 test_full_zone_returns_to_partial,
+	 NULL,
+	 NULL,
+	 MUNIT_TEST_OPTION_NONE,
+	 NULL},
+	{"/pool/bulk_alloc_and_free", test_bulk_alloc_and_free, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+static const MunitSuite suite = {"/pool", tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
+
+int main(int argc, char* argv[MUNIT_ARRAY_PARAM(argc + 1)])
+{
+	return munit_suite_main(&suite, NULL, argc, argv);
+}
@@ -0,0 +1,94 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   probe.h                                            :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/18 10:11:04 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/18 10:11:04 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef FT_PROBE_H
+#define FT_PROBE_H
+
+#include <stdint.h>
+
+/* USDT (SystemTap-style) static probes, provider "ft_malloc".
+ *
+ * A probe is a single nop plus an ELF note in .note.stapsdt naming it and
+ * telling the tracer where each argument lives (register, stack slot or
+ * constant). Nothing runs until a tracer patches the nop:
+ *
+ *   bpftrace -e 'usdt:./libft_malloc.so:ft_malloc:zone_new { @[arg1] = count(); }'
+ *   perf buildid-cache --add libft_malloc.so; perf list sdt_ft_malloc:*
+ *
+ * The notes follow the layout of <sys/sdt.h> (version 3); that header is not
+ * needed. Arguments are passed as 64-bit unsigned values. Builds with
+ * FT_NO_PROBES, or on targets other than x86-64/AArch64 ELF, compile the
+ * probes out entirely.
+ *
+ * Probes (arg0.. in order):
+ *   malloc(size, class, ptr)        after an allocation, ptr 0 on failure
+ *   free(ptr, class)                after a free, class of the block freed
+ *   realloc(old, size, class, ptr)  after a realloc
+ *   zone_new(zone, class, bin_size, mapped_bytes)
+ *   zone_destroy(zone, class, bin_size, mapped_bytes)
+ * 'class' is a t_zone_class (TINY 0, SMALL 1, LARGE 2, POOL 3). */
+
+#if !defined(FT_NO_PROBES) && defined(__ELF__) && (defined(__x86_64__) || defined(__aarch64__))
+#define FT_PROBES_ENABLED 1
+#else
+#define FT_PROBES_ENABLED 0
+#endif
+
+#if FT_PROBES_ENABLED
+
+/* _.stapsdt.base lets tools relocate the probe address after prelinking */
+#define FT_PROBE_BASE                                                                              \
+	".ifndef _.stapsdt.base\n"                                                                     \
+	".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n"                        \
+	".weak _.stapsdt.base\n"                                                                       \
+	".hidden _.stapsdt.base\n"                                                                     \
+	"_.stapsdt.base: .space 1\n"                                                                   \
+	".size _.stapsdt.base, 1\n"                                                                    \
+	".popsection\n"                                                                                \
+	".endif\n"
+
+#define FT_PROBE_NOTE(name, args)                                                                  \
+	"990: nop\n"                                                                                   \
+	".pushsection .note.stapsdt,\"?\",\"note\"\n"                                                  \
+	".balign 4\n"                                                                                  \
+	".4byte 992f-991f, 994f-993f, 3\n"                                                             \
+	"991: .asciz \"stapsdt\"\n"                                                                    \
+	"992: .balign 4\n"                                                                             \
+	"993: .8byte 990b\n"                                                                           \
+	".8byte _.stapsdt.base\n"                                                                      \
+	".8byte 0\n"                                                                                   \
+	".asciz \"ft_malloc\"\n"                                                                       \
+	".asciz \"" #name "\"\n"                                                                       \
+	".asciz \"" args "\"\n"                                                                        \
+	"994: .balign 4\n"                                                                             \
+	".popsection\n" FT_PROBE_BASE
+
+#define FT_PROBE_ARG(x) "nor"((uint64_t)(uintptr_t)(x))
+
+#define FT_PROBE2(name, a0, a1)                                                                    \
+	__asm__ __volatile__(FT_PROBE_NOTE(name, "8@%0 8@%1")::FT_PROBE_ARG(a0), FT_PROBE_ARG(a1))
+#define FT_PROBE3(name, a0, a1, a2)                                                                \
+	__asm__ __volatile__(FT_PROBE_NOTE(name, "8@%0 8@%1 8@%2")::FT_PROBE_ARG(a0),                  \
+						 FT_PROBE_ARG(a1), FT_PROBE_ARG(a2))
+#define FT_PROBE4(name, a0, a1, a2, a3)                                                            \
+	__asm__ __volatile__(FT_PROBE_NOTE(name, "8@%0 8@%1 8@%2 8@%3")::FT_PROBE_ARG(a0),             \
+						 FT_PROBE_ARG(a1), FT_PROBE_ARG(a2), FT_PROBE_ARG(a3))
+
+#else
+
+#define FT_PROBE2(name, a0, a1) ((void)(a0), (void)(a1))
+#define FT_PROBE3(name, a0, a1, a2) ((void)(a0), (void)(a1), (void)(a2))
+#define FT_PROBE4(name, a0, a1, a2, a3) ((void)(a0), (void)(a1), (void)(a2), (void)(a3))
+
+#endif
+
+#endif /* FT_PROBE_H */
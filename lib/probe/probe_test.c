@@ -0,0 +1,97 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   probe_test.c                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/18 11:02:47 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/18 11:02:47 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "probe/probe.h"
+#include "munit.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if FT_PROBES_ENABLED
+#include <elf.h>
+
+static const char* const g_probes[] = {"malloc", "free", "realloc", "zone_new", "zone_destroy"};
+#define N_PROBES (sizeof g_probes / sizeof g_probes[0])
+
+/* walk .note.stapsdt of our own executable (heap and zone are linked in) */
+static MunitResult test_notes_describe_every_probe(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+
+	int fd = open("/proc/self/exe", O_RDONLY);
+	munit_assert_int(fd, >=, 0);
+	struct stat st;
+	munit_assert_int(fstat(fd, &st), ==, 0);
+	const unsigned char* img = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	munit_assert_ptr_not_equal(img, MAP_FAILED);
+
+	const Elf64_Ehdr* eh = (const Elf64_Ehdr*)img;
+	const Elf64_Shdr* sh = (const Elf64_Shdr*)(img + eh->e_shoff);
+	const char* shstr = (const char*)img + sh[eh->e_shstrndx].sh_offset;
+	size_t seen[N_PROBES] = {0};
+
+	for (int i = 0; i < eh->e_shnum; ++i) {
+		if (strcmp(shstr + sh[i].sh_name, ".note.stapsdt") != 0)
+			continue;
+		const unsigned char* p = img + sh[i].sh_offset;
+		const unsigned char* end = p + sh[i].sh_size;
+		while (p < end) {
+			const Elf64_Nhdr* nh = (const Elf64_Nhdr*)p;
+			const char* owner = (const char*)(nh + 1);
+			const char* desc = owner + ((nh->n_namesz + 3) & ~3u);
+			munit_assert_uint32(nh->n_type, ==, 3);
+			munit_assert_string_equal(owner, "stapsdt");
+			/* pc, base, semaphore, then provider, name, args */
+			const char* provider = desc + 3 * sizeof(uint64_t);
+			const char* name = provider + strlen(provider) + 1;
+			const char* args = name + strlen(name) + 1;
+			munit_assert_string_equal(provider, "ft_malloc");
+			munit_assert_uint64(*(const uint64_t*)desc, !=, 0);
+			for (size_t k = 0; k < N_PROBES; ++k) {
+				if (strcmp(name, g_probes[k]) == 0) {
+					seen[k]++;
+					munit_assert_not_null(strstr(args, "8@"));
+				}
+			}
+			p = (const unsigned char*)desc + ((nh->n_descsz + 3) & ~3u);
+		}
+	}
+	munmap((void*)img, (size_t)st.st_size);
+
+	for (size_t k = 0; k < N_PROBES; ++k)
+		munit_assert_size(seen[k], >, 0);
+	return MUNIT_OK;
+}
+#else
+static MunitResult test_notes_describe_every_probe(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+	return MUNIT_SKIP;
+}
+#endif
+
+static MunitTest tests[] = {
+	{"/probe/notes_describe_every_probe", test_notes_describe_every_probe, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+static const MunitSuite suite = {"/probe", tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
+
+int main(int argc, char* argv[MUNIT_ARRAY_PARAM(argc + 1)])
+{
+	return munit_suite_main(&suite, NULL, argc, argv);
+}
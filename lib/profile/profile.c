@@ -0,0 +1,381 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   profile.c                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/11 14:02:17 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/11 14:02:17 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "profile/profile.h"
+#include "helpers/helpers.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h> /* getenv */
+#include <time.h>
+
+#define FT_PROF_MIN_SLOTS 1024
+#define FT_PROF_FILTER_SIZE (1u << FT_PROF_FILTER_BITS)
+
+int g_prof_state = FT_PROF_UNINIT;
+size_t g_prof_live = 0;
+
+static struct {
+	pthread_mutex_t lock;
+	size_t interval;	  /* mean bytes between samples, 0 = off */
+	t_prof_sample* slots; /* scratch mapping, 'cap' entries */
+	size_t cap;			  /* power of two */
+	uint16_t filter[FT_PROF_FILTER_SIZE]; /* live samples per hash bucket */
+} g_prof = {PTHREAD_MUTEX_INITIALIZER, 0, NULL, 0, {0}};
+
+/* per-thread countdown; 'interval' detects a restart with another rate */
+typedef struct s_prof_tls {
+	int64_t until;
+	size_t interval;
+	uint64_t rng;
+} t_prof_tls;
+
+static __thread t_prof_tls tl_prof __attribute__((tls_model("initial-exec")));
+
+/* ---------------- hashing ---------------- */
+
+static uint64_t ft_prof_hash(uintptr_t p)
+{
+	uint64_t h = (uint64_t)p >> 4;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33;
+	return h;
+}
+
+static size_t ft_prof_filter_index(uintptr_t p)
+{
+	return (size_t)(ft_prof_hash(p) >> (64 - FT_PROF_FILTER_BITS));
+}
+
+/* ---------------- sampling interval ---------------- */
+
+static uint64_t ft_prof_now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t ft_prof_rand(uint64_t* s)
+{
+	uint64_t x = *s;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	*s = x;
+	return x * 0x2545f4914f6cdd1dull;
+}
+
+/* log2(q) for q >= 1, within ~0.5%: exponent plus a quadratic fit of the
+ * mantissa. Good enough for drawing gaps, and no libm in the allocator. */
+static double ft_prof_log2(uint64_t q)
+{
+	int e = 63 - __builtin_clzll(q);
+	double m = (double)q / (double)(1ull << e) - 1.0;
+	return (double)e + m * (1.3465 - 0.3465 * m);
+}
+
+/* exponential gap of mean 'interval': interval * -ln(u), u in (0, 1] */
+static int64_t ft_prof_next_gap(t_prof_tls* t, size_t interval)
+{
+	if (!t->rng)
+		t->rng = ((uint64_t)(uintptr_t)t ^ ft_prof_now_ns()) | 1;
+
+	uint64_t q = (ft_prof_rand(&t->rng) >> 38) + 1; /* [1, 2^26] */
+	double gap = (26.0 - ft_prof_log2(q)) * 0.6931471805599453 * (double)interval;
+	if (gap >= (double)(INT64_MAX / 2))
+		return INT64_MAX / 2;
+	return (int64_t)gap + 1;
+}
+
+/* ---------------- side table ---------------- */
+
+static t_prof_sample* ft_prof_slot_of(t_prof_sample* slots, size_t cap, uintptr_t p)
+{
+	size_t mask = cap - 1;
+	for (size_t i = (size_t)ft_prof_hash(p) & mask;; i = (i + 1) & mask)
+		if (slots[i].ptr == p || slots[i].ptr == 0)
+			return &slots[i];
+}
+
+static int ft_prof_grow(void)
+{
+	size_t cap = g_prof.cap ? g_prof.cap * 2 : FT_PROF_MIN_SLOTS;
+	int saved_errno = errno;
+	t_prof_sample* slots = (t_prof_sample*)ft_scratch_map(cap * sizeof(*slots));
+	errno = saved_errno;
+	if (!slots)
+		return -1;
+	for (size_t i = 0; i < g_prof.cap; ++i)
+		if (g_prof.slots[i].ptr)
+			*ft_prof_slot_of(slots, cap, g_prof.slots[i].ptr) = g_prof.slots[i];
+	ft_scratch_unmap(g_prof.slots, g_prof.cap * sizeof(*slots));
+	g_prof.slots = slots;
+	g_prof.cap = cap;
+	return 0;
+}
+
+static void ft_prof_insert(const t_prof_sample* s)
+{
+	/* keep the load factor under 1/2 */
+	if ((g_prof_live + 1) * 2 > g_prof.cap && ft_prof_grow() != 0)
+		return;
+	t_prof_sample* slot = ft_prof_slot_of(g_prof.slots, g_prof.cap, s->ptr);
+	if (slot->ptr == 0) {
+		g_prof.filter[ft_prof_filter_index(s->ptr)]++;
+		__atomic_add_fetch(&g_prof_live, 1, __ATOMIC_RELAXED);
+	}
+	*slot = *s;
+}
+
+/* linear-probing delete with backward shift (no tombstones) */
+static void ft_prof_remove(uintptr_t p)
+{
+	if (!g_prof.cap)
+		return;
+	size_t mask = g_prof.cap - 1;
+	t_prof_sample* slots = g_prof.slots;
+	size_t i = (size_t)(ft_prof_slot_of(slots, g_prof.cap, p) - slots);
+	if (slots[i].ptr != p)
+		return;
+
+	g_prof.filter[ft_prof_filter_index(p)]--;
+	__atomic_sub_fetch(&g_prof_live, 1, __ATOMIC_RELAXED);
+	for (size_t j = (i + 1) & mask; slots[j].ptr; j = (j + 1) & mask) {
+		size_t home = (size_t)ft_prof_hash(slots[j].ptr) & mask;
+		/* move j into the hole unless its home lies cyclically in (i, j] */
+		if (i <= j ? (home <= i || home > j) : (home <= i && home > j)) {
+			slots[i] = slots[j];
+			i = j;
+		}
+	}
+	slots[i].ptr = 0;
+}
+
+/* ---------------- stack capture ---------------- */
+
+/* Frame-record walk (x86-64 and AArch64 layout: fp[0] = caller's frame,
+ * fp[1] = return address). Stops at a NULL or implausible frame pointer, so
+ * callers built without frame pointers only truncate the stack. */
+static uint32_t ft_prof_backtrace(uintptr_t* out, const void* frame)
+{
+	const uintptr_t* fp = (const uintptr_t*)frame;
+	uint32_t depth = 0;
+
+	while (fp && depth < FT_PROF_MAX_DEPTH) {
+		uintptr_t ret = fp[1];
+		const uintptr_t* next = (const uintptr_t*)fp[0];
+		if (!ret)
+			break;
+		out[depth++] = ret;
+		if (next <= fp || (uintptr_t)next - (uintptr_t)fp > FT_PROF_MAX_FRAME ||
+			((uintptr_t)next & (sizeof(uintptr_t) - 1)))
+			break;
+		fp = next;
+	}
+	return depth;
+}
+
+/* ---------------- hooks ---------------- */
+
+static void ft_prof_set_interval(size_t interval)
+{
+	__atomic_store_n(&g_prof.interval, interval, __ATOMIC_RELAXED);
+	__atomic_store_n(&g_prof_state, interval ? FT_PROF_ON : FT_PROF_OFF, __ATOMIC_RELAXED);
+}
+
+/* first allocation: pick up FT_MALLOC_SAMPLE=<bytes> (getenv does not allocate) */
+static void ft_prof_init_from_env(void)
+{
+	const char* s = getenv(FT_PROF_ENV);
+	size_t v = 0;
+	while (s && *s >= '0' && *s <= '9' && v < SIZE_MAX / 10)
+		v = v * 10 + (size_t)(*s++ - '0');
+
+	pthread_mutex_lock(&g_prof.lock);
+	if (g_prof_state == FT_PROF_UNINIT)
+		ft_prof_set_interval(v);
+	pthread_mutex_unlock(&g_prof.lock);
+}
+
+void ft_profile_note_alloc(void* p, size_t n, const void* frame)
+{
+	if (__atomic_load_n(&g_prof_state, __ATOMIC_RELAXED) == FT_PROF_UNINIT)
+		ft_prof_init_from_env();
+	size_t interval = __atomic_load_n(&g_prof.interval, __ATOMIC_RELAXED);
+	if (!interval)
+		return;
+
+	t_prof_tls* t = &tl_prof;
+	if (t->interval != interval) {
+		t->interval = interval;
+		t->until = ft_prof_next_gap(t, interval);
+	}
+	t->until -= (n > (size_t)INT64_MAX / 2) ? INT64_MAX / 2 : (int64_t)n;
+	if (t->until > 0)
+		return;
+	t->until = ft_prof_next_gap(t, interval);
+
+	t_prof_sample s;
+	s.ptr = (uintptr_t)p;
+	s.size = n;
+	s.time_ns = ft_prof_now_ns();
+	s.depth = ft_prof_backtrace(s.stack, frame);
+
+	pthread_mutex_lock(&g_prof.lock);
+	if (g_prof.interval)
+		ft_prof_insert(&s);
+	pthread_mutex_unlock(&g_prof.lock);
+}
+
+void ft_profile_note_free(void* p)
+{
+	if (!__atomic_load_n(&g_prof.filter[ft_prof_filter_index((uintptr_t)p)], __ATOMIC_RELAXED))
+		return;
+	pthread_mutex_lock(&g_prof.lock);
+	ft_prof_remove((uintptr_t)p);
+	pthread_mutex_unlock(&g_prof.lock);
+}
+
+size_t ft_profile_live_count(void)
+{
+	return __atomic_load_n(&g_prof_live, __ATOMIC_RELAXED);
+}
+
+int ft_profile_find(const void* p, t_prof_sample* out)
+{
+	int found = 0;
+	pthread_mutex_lock(&g_prof.lock);
+	if (g_prof.cap) {
+		const t_prof_sample* s = ft_prof_slot_of(g_prof.slots, g_prof.cap, (uintptr_t)p);
+		if (s->ptr == (uintptr_t)p) {
+			*out = *s;
+			found = 1;
+		}
+	}
+	pthread_mutex_unlock(&g_prof.lock);
+	return found;
+}
+
+/* ---------------- public API ---------------- */
+
+void ft_malloc_profile_start(size_t interval)
+{
+	pthread_mutex_lock(&g_prof.lock);
+	ft_prof_set_interval(interval);
+	pthread_mutex_unlock(&g_prof.lock);
+}
+
+void ft_malloc_profile_stop(void)
+{
+	pthread_mutex_lock(&g_prof.lock);
+	ft_prof_set_interval(0);
+	ft_scratch_unmap(g_prof.slots, g_prof.cap * sizeof(*g_prof.slots));
+	g_prof.slots = NULL;
+	g_prof.cap = 0;
+	for (size_t i = 0; i < FT_PROF_FILTER_SIZE; ++i)
+		g_prof.filter[i] = 0;
+	__atomic_store_n(&g_prof_live, 0, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&g_prof.lock);
+}
+
+static void ft_prof_put_counts(t_ft_buf* b, size_t count, size_t bytes)
+{
+	ft_buf_putusize(b, count);
+	ft_buf_putstr(b, ": ");
+	ft_buf_putusize(b, bytes);
+	ft_buf_putstr(b, " [");
+	ft_buf_putusize(b, count);
+	ft_buf_putstr(b, ": ");
+	ft_buf_putusize(b, bytes);
+	ft_buf_putstr(b, "] @");
+}
+
+/* pprof needs the mappings to symbolize the addresses */
+static void ft_prof_put_maps(t_ft_buf* b)
+{
+	int fd = open("/proc/self/maps", O_RDONLY);
+	if (fd < 0)
+		return;
+	ft_buf_putstr(b, "\nMAPPED_LIBRARIES:\n");
+	char chunk[1024];
+	ssize_t n;
+	while ((n = read(fd, chunk, sizeof chunk)) > 0)
+		ft_buf_write(b, chunk, (size_t)n);
+	close(fd);
+}
+
+/* Copy of the live samples, taken under the lock so that formatting and
+ * writing them block no sampled malloc or free. Returns the count (*out NULL
+ * when 0), or -1 if no scratch memory could be mapped. */
+static ssize_t ft_prof_snapshot(t_prof_sample** out, size_t* interval)
+{
+	ssize_t n = 0;
+	*out = NULL;
+	pthread_mutex_lock(&g_prof.lock);
+	*interval = g_prof.interval;
+	const size_t live = __atomic_load_n(&g_prof_live, __ATOMIC_RELAXED);
+	if (live) {
+		int saved_errno = errno;
+		*out = (t_prof_sample*)ft_scratch_map(live * sizeof(**out));
+		errno = saved_errno;
+		if (!*out)
+			n = -1;
+		for (size_t i = 0; *out && i < g_prof.cap; ++i)
+			if (g_prof.slots[i].ptr)
+				(*out)[n++] = g_prof.slots[i];
+	}
+	pthread_mutex_unlock(&g_prof.lock);
+	return n;
+}
+
+int ft_malloc_profile_dump(int fd)
+{
+	if (fd < 0) {
+		errno = EBADF;
+		return -1;
+	}
+
+	t_prof_sample* v;
+	size_t interval;
+	const ssize_t n = ft_prof_snapshot(&v, &interval);
+	if (n < 0) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	t_ft_buf b;
+	size_t bytes = 0;
+	for (ssize_t i = 0; i < n; ++i)
+		bytes += v[i].size;
+
+	ft_buf_init(&b, fd);
+	ft_buf_putstr(&b, "heap profile: ");
+	ft_prof_put_counts(&b, (size_t)n, bytes);
+	ft_buf_putstr(&b, " heap_v2/");
+	ft_buf_putusize(&b, interval);
+	ft_buf_putc(&b, '\n');
+	for (ssize_t i = 0; i < n; ++i) {
+		ft_prof_put_counts(&b, 1, v[i].size);
+		for (uint32_t d = 0; d < v[i].depth; ++d) {
+			ft_buf_putc(&b, ' ');
+			ft_buf_puthex_ptr(&b, (const void*)v[i].stack[d]);
+		}
+		ft_buf_putc(&b, '\n');
+	}
+	ft_scratch_unmap(v, (size_t)n * sizeof(*v));
+	ft_prof_put_maps(&b);
+	ft_buf_flush(&b);
+	return 0;
+}
@@ -0,0 +1,75 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   profile.h                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/11 14:02:17 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/11 14:02:17 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef FT_PROFILE_H
+#define FT_PROFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "malloc.h" /* public ft_malloc_profile_* API */
+
+/* Sampling heap profiler (tcmalloc style).
+ * - each thread counts down the bytes it allocates; when the count crosses
+ *   zero the allocation is sampled and a new gap is drawn from an exponential
+ *   distribution of mean 'interval', so samples cannot alias with a periodic
+ *   allocation pattern;
+ * - a sample keeps the pointer, requested size, a CLOCK_MONOTONIC timestamp
+ *   and a frame-pointer backtrace, in an open-addressing table living in its
+ *   own mappings (never in the profiled heap);
+ * - frees look the pointer up only when a small counting filter says it may
+ *   be sampled, so unsampled frees cost one relaxed load and one array read.
+ * Hooks sit in the public entry points (lib/malloc.c), so stacks start at the
+ * application's call to malloc/realloc/free. */
+
+#define FT_PROF_MAX_DEPTH 32
+/* a caller's frame further than this above ours ends the walk */
+#define FT_PROF_MAX_FRAME (1u << 20)
+#define FT_PROF_FILTER_BITS 12
+#define FT_PROF_ENV "FT_MALLOC_SAMPLE"
+
+typedef enum e_prof_state { FT_PROF_UNINIT, FT_PROF_OFF, FT_PROF_ON } t_prof_state;
+
+typedef struct s_prof_sample {
+	uintptr_t ptr; /* 0: empty slot */
+	size_t size;
+	uint64_t time_ns;
+	uint32_t depth;
+	uintptr_t stack[FT_PROF_MAX_DEPTH];
+} t_prof_sample;
+
+extern int g_prof_state;
+extern size_t g_prof_live;
+
+void ft_profile_note_alloc(void* p, size_t n, const void* frame);
+void ft_profile_note_free(void* p);
+
+/* Called by the public entry points; cheap when the profiler is off.
+ * 'frame' is the entry point's own __builtin_frame_address(0): the stack walk
+ * starts there, so the first recorded address is in the caller of malloc. */
+static inline void ft_profile_alloc(void* p, size_t n, const void* frame)
+{
+	if (__builtin_expect(__atomic_load_n(&g_prof_state, __ATOMIC_RELAXED) != FT_PROF_OFF, 0) && p)
+		ft_profile_note_alloc(p, n, frame);
+}
+
+static inline void ft_profile_free(void* p)
+{
+	if (__builtin_expect(__atomic_load_n(&g_prof_live, __ATOMIC_RELAXED) != 0, 0) && p)
+		ft_profile_note_free(p);
+}
+
+/* Number of live samples, and a copy of the sample recorded for p in *out:
+ * returns 1, or 0 if p is not sampled. */
+size_t ft_profile_live_count(void);
+int ft_profile_find(const void* p, t_prof_sample* out);
+
+#endif /* FT_PROFILE_H */
@@ -0,0 +1,196 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   profile_test.c                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/11 15:40:03 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/11 15:40:03 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "profile/profile.h"
+#include "munit.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* The side table is keyed by address only: fake, 64-byte spaced pointers
+ * keep these tests independent of the heap. */
+#define FAKE_PTR(i) ((void*)(uintptr_t)(0x10000000u + (uintptr_t)(i) * 64))
+
+static void teardown(void* fixture)
+{
+	(void)fixture;
+	ft_malloc_profile_stop();
+}
+
+static MunitResult test_records_and_forgets(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+
+	/* mean gap of 1 byte: every 16-byte allocation is sampled */
+	ft_malloc_profile_start(1);
+	for (int i = 0; i < 8; ++i)
+		ft_profile_alloc(FAKE_PTR(i), 16, __builtin_frame_address(0));
+	munit_assert_size(ft_profile_live_count(), ==, 8);
+
+	t_prof_sample s;
+	munit_assert_int(ft_profile_find(FAKE_PTR(3), &s), ==, 1);
+	munit_assert_size(s.size, ==, 16);
+	munit_assert_uint32(s.depth, >=, 1);
+	munit_assert_uint64(s.time_ns, >, 0);
+
+	for (int i = 0; i < 8; ++i)
+		ft_profile_free(FAKE_PTR(i));
+	munit_assert_size(ft_profile_live_count(), ==, 0);
+	munit_assert_int(ft_profile_find(FAKE_PTR(3), &s), ==, 0);
+	return MUNIT_OK;
+}
+
+static MunitResult test_rate_follows_interval(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+
+	/* 640000 bytes at one sample per 4096 bytes: ~156 samples expected */
+	ft_malloc_profile_start(4096);
+	for (int i = 0; i < 10000; ++i)
+		ft_profile_alloc(FAKE_PTR(i), 64, __builtin_frame_address(0));
+	size_t n = ft_profile_live_count();
+	munit_assert_size(n, >=, 78);
+	munit_assert_size(n, <=, 312);
+	return MUNIT_OK;
+}
+
+static MunitResult test_table_grows_and_deletes(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+
+	enum { N = 5000 };
+	ft_malloc_profile_start(1);
+	for (int i = 0; i < N; ++i)
+		ft_profile_alloc(FAKE_PTR(i), 32, __builtin_frame_address(0));
+	munit_assert_size(ft_profile_live_count(), ==, N);
+
+	/* every other removal shifts probe chains; the rest must stay reachable */
+	for (int i = 0; i < N; i += 2)
+		ft_profile_free(FAKE_PTR(i));
+	munit_assert_size(ft_profile_live_count(), ==, N / 2);
+	t_prof_sample s;
+	for (int i = 0; i < N; ++i)
+		munit_assert_int(ft_profile_find(FAKE_PTR(i), &s), ==, i % 2);
+	return MUNIT_OK;
+}
+
+static MunitResult test_dump_is_pprof_heap_v2(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+
+	ft_malloc_profile_start(1);
+	ft_profile_alloc(FAKE_PTR(1), 100, __builtin_frame_address(0));
+	ft_profile_alloc(FAKE_PTR(2), 200, __builtin_frame_address(0));
+	ft_profile_alloc(FAKE_PTR(3), 300, __builtin_frame_address(0));
+
+	int fds[2];
+	munit_assert_int(pipe(fds), ==, 0);
+	munit_assert_int(ft_malloc_profile_dump(fds[1]), ==, 0);
+	close(fds[1]);
+
+	static char out[1 << 16];
+	size_t len = 0;
+	ssize_t n;
+	while (len + 1 < sizeof out && (n = read(fds[0], out + len, sizeof out - 1 - len)) > 0)
+		len += (size_t)n;
+	close(fds[0]);
+	out[len] = '\0';
+
+	munit_assert_ptr_equal(strstr(out, "heap profile: 3: 600 [3: 600] @ heap_v2/1\n"), out);
+	munit_assert_not_null(strstr(out, "\n1: 200 [1: 200] @ 0x"));
+	munit_assert_not_null(strstr(out, "\nMAPPED_LIBRARIES:\n"));
+	return MUNIT_OK;
+}
+
+typedef struct s_dump_reader {
+	int fd;
+	size_t bytes;
+} t_dump_reader;
+
+static void* dump_reader(void* arg)
+{
+	t_dump_reader* r = arg;
+	char buf[4096];
+	ssize_t n;
+	/* let the writer fill the pipe and block in write(2), then free a sampled
+	 * pointer: this takes the profiler lock */
+	usleep(50000);
+	ft_profile_free(FAKE_PTR(0));
+	while ((n = read(r->fd, buf, sizeof buf)) > 0)
+		r->bytes += (size_t)n;
+	return NULL;
+}
+
+static MunitResult test_dump_writes_after_unlock(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+
+	/* more samples than a pipe holds */
+	enum { N = 2000 };
+	ft_malloc_profile_start(1);
+	for (int i = 0; i < N; ++i)
+		ft_profile_alloc(FAKE_PTR(i), 16, __builtin_frame_address(0));
+
+	int fds[2];
+	munit_assert_int(pipe(fds), ==, 0);
+	t_dump_reader r = {fds[0], 0};
+	pthread_t th;
+	munit_assert_int(pthread_create(&th, NULL, dump_reader, &r), ==, 0);
+	alarm(10); /* a dump that writes under the lock never returns */
+	munit_assert_int(ft_malloc_profile_dump(fds[1]), ==, 0);
+	alarm(0);
+	close(fds[1]);
+	pthread_join(th, NULL);
+	close(fds[0]);
+
+	munit_assert_size(r.bytes, >, (size_t)1 << 16);
+	munit_assert_size(ft_profile_live_count(), ==, N - 1);
+	return MUNIT_OK;
+}
+
+static MunitTest tests[] = {
+	{"/profile/records_and_forgets", test_records_and_forgets, NULL, teardown, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/profile/rate_follows_interval",
+	 test_rate_follows_interval,
+	 NULL,
+	 teardown,
+	 MUNIT_TEST_OPTION_NONE,
+	 NULL},
+	{"/profile/table_grows_and_deletes",
+	 test_table_grows_and_deletes,
+	 NULL,
+	 teardown,
+	 MUNIT_TEST_OPTION_NONE,
+	 NULL},
+	{"/profile/dump_is_pprof_heap_v2", test_dump_is_pprof_heap_v2, NULL, teardown, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/profile/dump_writes_after_unlock",
+	 test_dump_writes_after_unlock,
+	 NULL,
+	 teardown,
+	 MUNIT_TEST_OPTION_NONE,
+	 NULL},
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+static const MunitSuite suite = {"/profile", tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
+
+int main(int argc, char* argv[MUNIT_ARRAY_PARAM(argc + 1)])
+{
+	return munit_suite_main(&suite, NULL, argc, argv);
+}
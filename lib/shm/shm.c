@@ -0,0 +1,430 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   shm.c                                              :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/19 20:14:37 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/19 20:14:37 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "shm/shm.h"
+#include "helpers/helpers.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ---------------- locking ---------------- */
+
+int ft_shm_lock(t_shm* s)
+{
+	t_shm_seg* seg = s->seg;
+	int rc = pthread_mutex_lock(&seg->lock);
+#ifndef __APPLE__
+	if (rc == EOWNERDEAD) {
+		/* the owner died inside a call: nothing is rolled back, so a block or
+		 * a zone it was taking or giving may be lost */
+		seg->recovered++;
+		rc = pthread_mutex_consistent(&seg->lock);
+		if (rc)
+			pthread_mutex_unlock(&seg->lock);
+	}
+#endif
+	return rc;
+}
+
+void ft_shm_unlock(t_shm* s)
+{
+	pthread_mutex_unlock(&s->seg->lock);
+}
+
+/* ---------------- zone lists ---------------- */
+
+static t_shm_zone* ft_shm_zone(const t_shm_seg* seg, uint64_t off)
+{
+	return (t_shm_zone*)ft_shm_at(seg, off);
+}
+
+static void ft_shm_push(t_shm_seg* seg, uint64_t* head, t_shm_zone* z)
+{
+	const uint64_t off = ft_shm_off(seg, z);
+	z->link.prev = 0;
+	z->link.next = *head;
+	if (*head)
+		ft_shm_zone(seg, *head)->link.prev = off;
+	*head = off;
+}
+
+static void ft_shm_remove(t_shm_seg* seg, uint64_t* head, t_shm_zone* z)
+{
+	if (z->link.prev)
+		ft_shm_zone(seg, z->link.prev)->link.next = z->link.next;
+	else
+		*head = z->link.next;
+	if (z->link.next)
+		ft_shm_zone(seg, z->link.next)->link.prev = z->link.prev;
+	z->link.prev = z->link.next = 0;
+}
+
+static uint8_t* ft_shm_blocks(t_shm_zone* z)
+{
+	return (uint8_t*)z + FT_SHM_ZONE_HDR;
+}
+
+static uint8_t* ft_shm_occ(t_shm_zone* z)
+{
+	return ft_shm_blocks(z) + z->capacity * z->bin_size;
+}
+
+/* ---------------- zones ---------------- */
+
+static t_shm_zone* ft_shm_zone_new(t_shm_seg* seg, t_zone_class k, size_t bin_size)
+{
+	const size_t ps = ft_page_size();
+	size_t bytes;
+	size_t cap = 1;
+
+	if (k == FT_Z_LARGE) {
+		if (bin_size > SIZE_MAX - FT_SHM_ZONE_HDR - ps)
+			return NULL;
+		bytes = ft_align_up(FT_SHM_ZONE_HDR + bin_size, ps);
+	} else {
+		const size_t min_blocks = (k == FT_Z_TINY) ? TINY_N_BLOCKS : SMALL_N_BLOCKS;
+		cap = ft_slab_capacity(FT_SHM_ZONE_HDR, bin_size, min_blocks, ps, &bytes);
+		if (cap == 0)
+			return NULL;
+	}
+	t_shm_zone* z = (t_shm_zone*)ft_zone_arena_take(&seg->arena, bytes, ps);
+	if (!z)
+		return NULL;
+
+	/* zero-filled by the arena: every occ[] byte starts FT_OCC_FREE */
+	z->klass = (uint32_t)k;
+	z->bin_size = bin_size;
+	z->capacity = cap;
+	z->free_count = (k == FT_Z_LARGE) ? 0 : cap;
+	z->map_bytes = bytes;
+	ft_shm_push(seg, &seg->zones[k], z);
+	return z;
+}
+
+static void ft_shm_zone_destroy(t_shm_seg* seg, t_shm_zone* z)
+{
+	ft_shm_remove(seg, &seg->zones[z->klass], z);
+	ft_zone_arena_give(&seg->arena, z, z->map_bytes);
+}
+
+static void* ft_shm_slab_take(t_shm_zone* z)
+{
+	const size_t i = ft_slab_take(ft_shm_occ(z), z->capacity, &z->next_free_hint);
+	if (i == z->capacity)
+		return NULL;
+	z->free_count--;
+	return ft_shm_blocks(z) + i * z->bin_size;
+}
+
+/* Zone whose blocks hold 'p', or NULL. */
+static t_shm_zone* ft_shm_owner(const t_shm_seg* seg, const void* p)
+{
+	for (int k = 0; k < N_ZONE_CATEGORIES; k++) {
+		for (uint64_t off = seg->zones[k]; off;) {
+			t_shm_zone* z = ft_shm_zone(seg, off);
+			if (ft_slab_holds(ft_shm_blocks(z), z->bin_size, z->capacity, p))
+				return z;
+			off = z->link.next;
+		}
+	}
+	return NULL;
+}
+
+/* ---------------- allocation ---------------- */
+
+static void* ft_shm_alloc_locked(t_shm_seg* seg, size_t n)
+{
+	const size_t need = ft_align_up(n ? n : 1, FT_ALIGN);
+	const t_zone_class k = ft_zone_class_for(need, seg->tiny_bin_size, seg->small_bin_size);
+
+	if (k == FT_Z_LARGE) {
+		t_shm_zone* z = ft_shm_zone_new(seg, k, need);
+		return z ? ft_shm_blocks(z) : NULL;
+	}
+
+	const size_t bin = (k == FT_Z_TINY) ? seg->tiny_bin_size : seg->small_bin_size;
+	t_shm_zone* z = NULL;
+	for (uint64_t off = seg->zones[k]; off && !z; off = ft_shm_zone(seg, off)->link.next)
+		if (ft_shm_zone(seg, off)->free_count)
+			z = ft_shm_zone(seg, off);
+	if (!z)
+		z = ft_shm_zone_new(seg, k, bin);
+	return z ? ft_shm_slab_take(z) : NULL;
+}
+
+static void ft_shm_free_locked(t_shm_seg* seg, void* p)
+{
+	t_shm_zone* z = ft_shm_owner(seg, p);
+	if (!z)
+		return; /* not from this segment: ignore, as free() does */
+
+	if (z->klass == FT_Z_LARGE) {
+		if (p == ft_shm_blocks(z))
+			ft_shm_zone_destroy(seg, z);
+		return;
+	}
+	const size_t off = (size_t)((uint8_t*)p - ft_shm_blocks(z));
+	if (off % z->bin_size || !ft_slab_give(ft_shm_occ(z), off / z->bin_size, &z->next_free_hint))
+		return; /* interior pointer or double free */
+	z->free_count++;
+
+	/* an empty slab goes back to the arena unless it is the last of its class */
+	if (z->free_count == z->capacity && (z->link.prev || z->link.next))
+		ft_shm_zone_destroy(seg, z);
+}
+
+void* ft_shm_alloc(ft_shm_t* s, size_t n)
+{
+	if (!s)
+		return NULL;
+	const int err = ft_shm_lock(s);
+	if (err) {
+		errno = err;
+		return NULL;
+	}
+	void* p = ft_shm_alloc_locked(s->seg, n);
+	ft_shm_unlock(s);
+	if (!p)
+		errno = ENOMEM;
+	return p;
+}
+
+void ft_shm_free(ft_shm_t* s, void* p)
+{
+	if (!s || !p)
+		return;
+	const int err = ft_shm_lock(s);
+	if (err) {
+		errno = err; /* the block stays taken */
+		return;
+	}
+	ft_shm_free_locked(s->seg, p);
+	ft_shm_unlock(s);
+}
+
+size_t ft_shm_used(t_shm* s)
+{
+	const int err = ft_shm_lock(s);
+	if (err) {
+		errno = err;
+		return 0;
+	}
+	size_t used = ft_zone_arena_used(&s->seg->arena);
+	ft_shm_unlock(s);
+	return used;
+}
+
+/* ---------------- offsets and root ---------------- */
+
+uint64_t ft_shm_offset(const ft_shm_t* s, const void* p)
+{
+	if (!s || (uintptr_t)p < (uintptr_t)s->seg || (uintptr_t)p >= (uintptr_t)s->seg + s->size)
+		return 0;
+	return ft_shm_off(s->seg, p);
+}
+
+void* ft_shm_ptr(const ft_shm_t* s, uint64_t off)
+{
+	if (!s || off >= s->size)
+		return NULL;
+	return ft_shm_at(s->seg, off);
+}
+
+uint64_t ft_shm_root(const ft_shm_t* s)
+{
+	return s ? __atomic_load_n(&s->seg->root, __ATOMIC_ACQUIRE) : 0;
+}
+
+void ft_shm_set_root(ft_shm_t* s, uint64_t off)
+{
+	if (s)
+		__atomic_store_n(&s->seg->root, off, __ATOMIC_RELEASE);
+}
+
+/* ---------------- segments ---------------- */
+
+static void ft_shm_format(t_shm_seg* seg, size_t size, size_t hdr)
+{
+	pthread_mutexattr_t attr;
+
+	seg->layout = FT_SHM_LAYOUT;
+	seg->size = size;
+	seg->tiny_bin_size = TINY_BIN_SIZE;
+	seg->small_bin_size = SMALL_BIN_SIZE;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+#ifndef __APPLE__ /* no robust mutexes there: a dead owner blocks the segment */
+	pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+#endif
+	pthread_mutex_init(&seg->lock, &attr);
+	pthread_mutexattr_destroy(&attr);
+	ft_zone_arena_init(&seg->arena, (char*)seg + hdr, size - hdr);
+	/* last: ft_shm_open() of a named segment refuses it until now */
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	memcpy(seg->magic, FT_SHM_MAGIC, sizeof seg->magic);
+}
+
+/* Map 'fd' and wrap it in a handle; takes the descriptor (closed on failure). */
+static t_shm* ft_shm_attach(int fd, size_t size)
+{
+	int err;
+	t_shm_seg* seg = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (seg == MAP_FAILED)
+		goto fail;
+
+	t_zone* self = t_zone_new_large(sizeof(t_shm));
+	if (!self) {
+		err = errno;
+		munmap(seg, size);
+		errno = err;
+		goto fail;
+	}
+	t_shm* s = (t_shm*)self->mem_begin;
+	s->seg = seg;
+	s->size = size;
+	s->fd = fd;
+	s->self = self;
+	return s;
+
+fail:
+	err = errno;
+	close(fd);
+	errno = err;
+	return NULL;
+}
+
+/* An anonymous descriptor: memfd where there is one, else an unlinked name. */
+static int ft_shm_anon_fd(void)
+{
+#ifdef __linux__
+	return memfd_create("ft_shm", MFD_CLOEXEC);
+#else
+	char name[32] = "/ft_shm.";
+	uintptr_t r = (uintptr_t)&name ^ (uintptr_t)getpid() << 20;
+
+	for (int tries = 0; tries < 64; tries++, r = r * 6364136223846793005u + 1442695040888963407u) {
+		char* q = name + 8;
+		for (uintptr_t v = r; v && q < name + sizeof name - 1; v >>= 5)
+			*q++ = "abcdefghijklmnopqrstuvwxyz012345"[v & 31];
+		*q = '\0';
+		int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+		if (fd >= 0) {
+			shm_unlink(name);
+			return fd;
+		}
+		if (errno != EEXIST)
+			return -1;
+	}
+	return -1;
+#endif
+}
+
+ft_shm_t* ft_shm_create(const char* name, size_t size)
+{
+	const size_t ps = ft_page_size();
+	const size_t hdr = ft_align_up(sizeof(t_shm_seg), ps);
+
+	if (size > SIZE_MAX - ps || ft_align_up(size, ps) <= hdr) {
+		errno = EINVAL;
+		return NULL;
+	}
+	size = ft_align_up(size, ps);
+
+	int fd = name ? shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600) : ft_shm_anon_fd();
+	if (fd < 0)
+		return NULL;
+	if (ftruncate(fd, (off_t)size)) {
+		int err = errno;
+		close(fd);
+		if (name)
+			shm_unlink(name);
+		errno = err;
+		return NULL;
+	}
+	t_shm* s = ft_shm_attach(fd, size);
+	if (!s) {
+		if (name) {
+			int err = errno;
+			shm_unlink(name);
+			errno = err;
+		}
+		return NULL;
+	}
+	ft_shm_format(s->seg, size, hdr);
+	return s;
+}
+
+ft_shm_t* ft_shm_open_fd(int fd)
+{
+	struct stat st;
+
+	fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+	if (fd < 0)
+		return NULL;
+	if (fstat(fd, &st) || (size_t)st.st_size < sizeof(t_shm_seg)) {
+		close(fd);
+		errno = EINVAL;
+		return NULL;
+	}
+	/* map it whole and check the header there: shm objects need not support read() */
+	t_shm* s = ft_shm_attach(fd, (size_t)st.st_size);
+	if (s && (memcmp(s->seg->magic, FT_SHM_MAGIC, sizeof s->seg->magic) ||
+				 s->seg->layout != FT_SHM_LAYOUT || s->seg->size != s->size)) {
+		ft_shm_close(s);
+		errno = EINVAL;
+		return NULL;
+	}
+	return s;
+}
+
+ft_shm_t* ft_shm_open(const char* name)
+{
+	if (!name) {
+		errno = EINVAL;
+		return NULL;
+	}
+	int fd = shm_open(name, O_RDWR | O_CLOEXEC, 0600);
+	if (fd < 0)
+		return NULL;
+	ft_shm_t* s = ft_shm_open_fd(fd);
+	int err = errno;
+	close(fd);
+	errno = err;
+	return s;
+}
+
+int ft_shm_fd(const ft_shm_t* s)
+{
+	return s ? s->fd : -1;
+}
+
+void ft_shm_close(ft_shm_t* s)
+{
+	if (!s)
+		return;
+	munmap(s->seg, s->size);
+	close(s->fd);
+	ft_zone_destroy(s->self);
+}
+
+int ft_shm_unlink(const char* name)
+{
+	if (!name) {
+		errno = EINVAL;
+		return -1;
+	}
+	return shm_unlink(name);
+}
@@ -0,0 +1,101 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   shm.h                                              :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/19 20:14:37 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/19 20:14:37 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef FT_SHM_H
+#define FT_SHM_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "malloc.h" /* public ft_shm_* API */
+#include "heap/heap.h"
+#include "zone/zone.h"
+#include "zone/zone_arena.h"
+
+/* Shared-memory heap: the heap's zone layout, with positions instead of
+ * pointers.
+ * - one segment (memfd or shm_open) holds a header, then an arena
+ *   (zone/zone_arena.c) that TINY/SMALL slabs and LARGE zones are carved from;
+ * - a zone's list links and every position the header keeps are offsets from
+ *   the segment base (0: none), so each process may map it anywhere;
+ * - slabs keep their occupancy bytes after their blocks, as t_zone does, and
+ *   run on the same slab core (zone.h);
+ * - one robust, process-shared mutex in the header covers everything; a
+ *   lock taken over from a dead owner is counted in 'recovered'.
+ * The process-local handle (struct s_shm) lives in a LARGE zone of its own,
+ * never in the segment. */
+
+#define FT_SHM_MAGIC "ftshmem1"
+#define FT_SHM_VERSION 1u
+
+typedef struct s_shm_link {
+	uint64_t prev; /* offsets from the segment base, 0: none */
+	uint64_t next;
+} t_shm_link;
+
+/* Header of a zone in the segment; blocks start FT_SHM_ZONE_HDR bytes in. */
+typedef struct s_shm_zone {
+	t_shm_link link;
+	uint32_t klass; /* FT_Z_TINY / FT_Z_SMALL / FT_Z_LARGE */
+	size_t bin_size;
+	size_t capacity;
+	size_t free_count;
+	size_t next_free_hint;
+	size_t map_bytes; /* taken from the arena: header, blocks, occ[] */
+} t_shm_zone;
+
+#define FT_SHM_ZONE_HDR ((sizeof(t_shm_zone) + FT_ALIGN - 1) & ~(size_t)(FT_ALIGN - 1))
+
+typedef struct s_shm_seg {
+	char magic[8];
+	uint64_t layout; /* FT_SHM_LAYOUT of the build that made it */
+	size_t size;
+	pthread_mutex_t lock; /* PTHREAD_PROCESS_SHARED, PTHREAD_MUTEX_ROBUST */
+	uint64_t recovered;	  /* locks taken over from a dead owner */
+	uint64_t root;
+	size_t tiny_bin_size;
+	size_t small_bin_size;
+	uint64_t zones[N_ZONE_CATEGORIES]; /* list heads */
+	t_zone_arena arena;
+} t_shm_seg;
+
+#define FT_SHM_LAYOUT                                                                              \
+	(((uint64_t)sizeof(t_shm_seg) << 32) | ((uint64_t)sizeof(t_shm_zone) << 16) | FT_SHM_VERSION)
+
+typedef struct s_shm {
+	t_shm_seg* seg; /* this process's view */
+	size_t size;
+	int fd;
+	t_zone* self;
+} t_shm;
+
+static inline void* ft_shm_at(const t_shm_seg* seg, uint64_t off)
+{
+	return off ? (void*)((uintptr_t)seg + (uintptr_t)off) : NULL;
+}
+
+static inline uint64_t ft_shm_off(const t_shm_seg* seg, const void* p)
+{
+	return p ? (uint64_t)((uintptr_t)p - (uintptr_t)seg) : 0;
+}
+
+/* Take / drop the segment lock, recovering it from a dead owner. Returns 0,
+ * or the pthread error (ENOTRECOVERABLE once a recovery was given up): the
+ * lock is not held then. */
+int ft_shm_lock(t_shm* s);
+void ft_shm_unlock(t_shm* s);
+
+/* Bytes of the segment handed out to zones; 0 with errno set if the lock
+ * cannot be taken. */
+size_t ft_shm_used(t_shm* s);
+
+#endif /* FT_SHM_H */
@@ -0,0 +1,244 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   shm_test.c                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/19 20:14:37 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/19 20:14:37 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "shm/shm.h"
+#include "helpers/helpers.h"
+#include "munit.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define SHM_TEST_SIZE ((size_t)32 << 20)
+#define SHM_WORKERS 4
+#define SHM_MSGS 300
+
+static void shm_wait_ok(pid_t pid)
+{
+	int status;
+	munit_assert_int(waitpid(pid, &status, 0), ==, pid);
+	munit_assert_true(WIFEXITED(status));
+	munit_assert_int(WEXITSTATUS(status), ==, 0);
+}
+
+/* message 'i' of worker 'w': a size spanning TINY, SMALL and LARGE */
+static size_t shm_msg_size(int w, int i)
+{
+	static const size_t sizes[] = {1, 24, 100, 300, 1000, 5000, 70000};
+	return sizes[(size_t)(w + i) % (sizeof sizes / sizeof sizes[0])];
+}
+
+static MunitResult test_forked_workers_share_blocks(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+
+	ft_shm_t* s = ft_shm_create(NULL, SHM_TEST_SIZE);
+	munit_assert_ptr_not_null(s);
+	const size_t base_used = ft_shm_used(s);
+
+	/* the table of offsets every worker fills its own row of */
+	uint64_t* table = ft_shm_alloc(s, sizeof(uint64_t) * SHM_WORKERS * SHM_MSGS);
+	munit_assert_ptr_not_null(table);
+	ft_shm_set_root(s, ft_shm_offset(s, table));
+
+	pid_t pids[SHM_WORKERS];
+	for (int w = 0; w < SHM_WORKERS; w++) {
+		pids[w] = fork();
+		munit_assert_int(pids[w], >=, 0);
+		if (pids[w] == 0) {
+			/* a view of its own, mapped elsewhere than the inherited one */
+			ft_shm_t* v = ft_shm_open_fd(ft_shm_fd(s));
+			if (!v || (void*)((t_shm*)v)->seg == (void*)((t_shm*)s)->seg)
+				_exit(1);
+			uint64_t* row = (uint64_t*)ft_shm_ptr(v, ft_shm_root(v)) + w * SHM_MSGS;
+			for (int i = 0; i < SHM_MSGS; i++) {
+				const size_t n = shm_msg_size(w, i);
+				uint8_t* m = ft_shm_alloc(v, n);
+				if (!m)
+					_exit(2);
+				memset(m, (w << 4) | (i & 15), n);
+				row[i] = ft_shm_offset(v, m);
+			}
+			ft_shm_close(v);
+			_exit(0);
+		}
+	}
+	for (int w = 0; w < SHM_WORKERS; w++)
+		shm_wait_ok(pids[w]);
+
+	/* read everything through a second view, at another address */
+	ft_shm_t* v = ft_shm_open_fd(ft_shm_fd(s));
+	munit_assert_ptr_not_null(v);
+	munit_assert_ptr_not_equal(((t_shm*)v)->seg, ((t_shm*)s)->seg);
+	const uint64_t* row = ft_shm_ptr(v, ft_shm_root(v));
+	for (int w = 0; w < SHM_WORKERS; w++) {
+		for (int i = 0; i < SHM_MSGS; i++) {
+			const uint64_t off = row[w * SHM_MSGS + i];
+			munit_assert_uint64(off, !=, 0);
+			const uint8_t* m = ft_shm_ptr(v, off);
+			const size_t n = shm_msg_size(w, i);
+			const uint8_t want = (uint8_t)((w << 4) | (i & 15));
+			munit_assert_true(m[0] == want && m[n - 1] == want);
+		}
+	}
+	/* and free it all from the first one */
+	for (int j = 0; j < SHM_WORKERS * SHM_MSGS; j++)
+		ft_shm_free(s, ft_shm_ptr(s, table[j]));
+	ft_shm_free(s, table);
+	munit_assert_size(((t_shm*)s)->seg->recovered, ==, 0);
+
+	/* one empty slab per class is kept, LARGE zones all go back */
+	const size_t slab =
+		ft_align_up(FT_SHM_ZONE_HDR + SMALL_N_BLOCKS * (SMALL_BIN_SIZE + 1), ft_page_size());
+	munit_assert_size(ft_shm_used(v), <=, base_used + 2 * slab);
+
+	ft_shm_close(v);
+	ft_shm_close(s);
+	return MUNIT_OK;
+}
+
+static MunitResult test_dead_lock_owner_is_recovered(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+
+	ft_shm_t* s = ft_shm_create(NULL, SHM_TEST_SIZE);
+	munit_assert_ptr_not_null(s);
+
+	pid_t pid = fork();
+	munit_assert_int(pid, >=, 0);
+	if (pid == 0) {
+		_exit(ft_shm_lock(s) != 0); /* dies holding it */
+	}
+	shm_wait_ok(pid);
+
+	void* p = ft_shm_alloc(s, 64);
+	munit_assert_ptr_not_null(p);
+	munit_assert_uint64(((t_shm*)s)->seg->recovered, ==, 1);
+	ft_shm_free(s, p);
+	munit_assert_uint64(((t_shm*)s)->seg->recovered, ==, 1);
+
+	ft_shm_close(s);
+	return MUNIT_OK;
+}
+
+static MunitResult test_unrecoverable_lock_is_reported(
+	const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+#ifdef __APPLE__
+	return MUNIT_SKIP; /* no robust mutexes */
+#else
+	ft_shm_t* s = ft_shm_create(NULL, SHM_TEST_SIZE);
+	munit_assert_ptr_not_null(s);
+	void* p = ft_shm_alloc(s, 64);
+	munit_assert_ptr_not_null(p);
+
+	pid_t pid = fork();
+	munit_assert_int(pid, >=, 0);
+	if (pid == 0)
+		_exit(ft_shm_lock(s) != 0);
+	shm_wait_ok(pid);
+
+	/* take it over, then drop it without making it consistent */
+	pthread_mutex_t* lock = &((t_shm*)s)->seg->lock;
+	munit_assert_int(pthread_mutex_lock(lock), ==, EOWNERDEAD);
+	pthread_mutex_unlock(lock);
+
+	munit_assert_int(ft_shm_lock(s), ==, ENOTRECOVERABLE);
+	errno = 0;
+	munit_assert_ptr_null(ft_shm_alloc(s, 64));
+	munit_assert_int(errno, ==, ENOTRECOVERABLE);
+	errno = 0;
+	ft_shm_free(s, p);
+	munit_assert_int(errno, ==, ENOTRECOVERABLE);
+	errno = 0;
+	munit_assert_size(ft_shm_used(s), ==, 0);
+	munit_assert_int(errno, ==, ENOTRECOVERABLE);
+
+	ft_shm_close(s);
+	return MUNIT_OK;
+#endif
+}
+
+static MunitResult test_named_segment(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+	char name[64];
+
+	snprintf(name, sizeof name, "/ft_shm_test.%d", (int)getpid());
+	ft_shm_t* s = ft_shm_create(name, SHM_TEST_SIZE);
+	munit_assert_ptr_not_null(s);
+	munit_assert_ptr_null(ft_shm_create(name, SHM_TEST_SIZE));
+	munit_assert_int(errno, ==, EEXIST);
+
+	pid_t pid = fork();
+	munit_assert_int(pid, >=, 0);
+	if (pid == 0) {
+		ft_shm_t* c = ft_shm_open(name);
+		char* msg = c ? ft_shm_alloc(c, 32) : NULL;
+		if (!msg)
+			_exit(1);
+		strcpy(msg, "hello from the child");
+		ft_shm_set_root(c, ft_shm_offset(c, msg));
+		ft_shm_close(c);
+		_exit(0);
+	}
+	shm_wait_ok(pid);
+
+	const char* msg = ft_shm_ptr(s, ft_shm_root(s));
+	munit_assert_ptr_not_null(msg);
+	munit_assert_string_equal(msg, "hello from the child");
+
+	munit_assert_int(ft_shm_unlink(name), ==, 0);
+	munit_assert_ptr_null(ft_shm_open(name));
+	munit_assert_int(errno, ==, ENOENT);
+	/* the mapping outlives the name */
+	munit_assert_string_equal(msg, "hello from the child");
+	ft_shm_close(s);
+	return MUNIT_OK;
+}
+
+static MunitTest tests[] = {
+	{"/shm/forked_workers_share_blocks",
+	 test_forked_workers_share_blocks,
+	 NULL,
+	 NULL,
+	 MUNIT_TEST_OPTION_NONE,
+	 NULL},
+	{"/shm/dead_lock_owner_is_recovered",
+	 test_dead_lock_owner_is_recovered,
+	 NULL,
+	 NULL,
+	 MUNIT_TEST_OPTION_NONE,
+	 NULL},
+	{"/shm/unrecoverable_lock_is_reported",
+	 test_unrecoverable_lock_is_reported,
+	 NULL,
+	 NULL,
+	 MUNIT_TEST_OPTION_NONE,
+	 NULL},
+	{"/shm/named_segment", test_named_segment, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+static const MunitSuite suite = {"/shm", tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
+
+int main(int argc, char* argv[MUNIT_ARRAY_PARAM(argc + 1)])
+{
+	return munit_suite_main(&suite, NULL, argc, argv);
+}
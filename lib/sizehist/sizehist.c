@@ -0,0 +1,188 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   sizehist.c                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/19 16:12:08 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/19 16:12:08 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "sizehist/sizehist.h"
+#include "heap/heap.h"
+#include "helpers/helpers.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h> /* getenv */
+#include <unistd.h>
+
+int g_sizehist_on = 0;
+
+static struct {
+	pthread_mutex_t lock; /* enable, dump at exit */
+	t_tl_registry reg;
+	int fd; /* FT_MALLOC_SIZEHIST file, dumped at exit */
+} g_sh = {PTHREAD_MUTEX_INITIALIZER, FT_TL_REGISTRY_INIT(sizeof(t_sh_block), FT_TL_BLOCK_FREE), -1};
+
+static __thread t_tl_block* tl_block __attribute__((tls_model("initial-exec")));
+
+/* Only the owner thread writes its block; readers load with relaxed atomics. */
+void ft_sizehist_record(size_t n)
+{
+	t_tl_block* t = tl_block;
+	if (t == FT_TL_BLOCK_GONE)
+		return;
+	if (!t && !(t = ft_tl_block_acquire(&g_sh.reg, &tl_block)))
+		return;
+	t_sh_block* blk = (t_sh_block*)t;
+
+	size_t b = ft_sizehist_bucket(n);
+	uint64_t* slot =
+		(b < FT_SIZEHIST_FINE) ? &blk->hist.fine[b] : &blk->hist.coarse[b - FT_SIZEHIST_FINE];
+	__atomic_store_n(slot, *slot + 1, __ATOMIC_RELAXED);
+}
+
+/* count of bucket b (ft_sizehist_bucket numbering), summed over every block */
+static uint64_t ft_sizehist_count(size_t b)
+{
+	uint64_t c = 0;
+	for (t_tl_block* t = ft_tl_blocks(&g_sh.reg); t; t = t->next) {
+		const ft_sizehist_t* h = &((t_sh_block*)t)->hist;
+		const uint64_t* slot = (b < FT_SIZEHIST_FINE) ? &h->fine[b] : &h->coarse[b - FT_SIZEHIST_FINE];
+		c += __atomic_load_n(slot, __ATOMIC_RELAXED);
+	}
+	return c;
+}
+
+/* ---------------- public API ---------------- */
+
+int ft_malloc_sizehist_enable(int on)
+{
+	pthread_mutex_lock(&g_sh.lock);
+	int was = __atomic_load_n(&g_sizehist_on, __ATOMIC_RELAXED);
+	if (on)
+		ft_tl_registry_start(&g_sh.reg);
+	__atomic_store_n(&g_sizehist_on, on != 0, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&g_sh.lock);
+	return was;
+}
+
+void ft_malloc_sizehist(ft_sizehist_t* out)
+{
+	if (!out)
+		return;
+	for (size_t i = 0; i < FT_SIZEHIST_FINE; ++i)
+		out->fine[i] = ft_sizehist_count(i);
+	for (size_t e = 0; e < FT_SIZEHIST_COARSE; ++e)
+		out->coarse[e] = ft_sizehist_count(FT_SIZEHIST_FINE + e);
+}
+
+void ft_malloc_sizehist_reset(void)
+{
+	for (t_tl_block* t = ft_tl_blocks(&g_sh.reg); t; t = t->next)
+		ft_memset(&((t_sh_block*)t)->hist, 0, sizeof(ft_sizehist_t));
+}
+
+int ft_malloc_sizehist_dump(int fd)
+{
+	if (fd < 0) {
+		errno = EBADF;
+		return -1;
+	}
+
+	t_ft_buf b;
+	ft_buf_init(&b, fd);
+	ft_buf_putstr(&b, FT_SIZEHIST_MAGIC "\n");
+	for (size_t i = 0; i < FT_SIZEHIST_FINE; ++i) {
+		uint64_t c = ft_sizehist_count(i);
+		if (!c)
+			continue;
+		ft_buf_putusize(&b, (i + 1) * 16);
+		ft_buf_putc(&b, ' ');
+		ft_buf_putusize(&b, (size_t)c);
+		ft_buf_putc(&b, '\n');
+	}
+	for (size_t e = 0; e < FT_SIZEHIST_COARSE; ++e) {
+		uint64_t c = ft_sizehist_count(FT_SIZEHIST_FINE + e);
+		if (!c)
+			continue;
+		ft_buf_putstr(&b, "2^");
+		ft_buf_putusize(&b, e);
+		ft_buf_putc(&b, ' ');
+		ft_buf_putusize(&b, (size_t)c);
+		ft_buf_putc(&b, '\n');
+	}
+	ft_buf_flush(&b);
+	return 0;
+}
+
+/* ---- environment ---- */
+
+/* "<digits>" at *s, advancing *s; 0 if there is none or it overflows */
+static size_t ft_sizehist_parse_usize(const char** s)
+{
+	size_t v = 0;
+	const char* p = *s;
+	while (*p >= '0' && *p <= '9') {
+		size_t d = (size_t)(*p++ - '0');
+		if (v > (SIZE_MAX - d) / 10)
+			return 0;
+		v = v * 10 + d;
+	}
+	if (p == *s)
+		return 0;
+	*s = p;
+	return v;
+}
+
+__attribute__((constructor)) static void ft_sizehist_from_env(void)
+{
+	const char* path = getenv(FT_SIZEHIST_ENV);
+	if (path && *path) {
+		g_sh.fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (g_sh.fd >= 0)
+			(void)ft_malloc_sizehist_enable(1);
+	}
+
+	const char* bins = getenv(FT_BINS_ENV);
+	if (bins && *bins) {
+		size_t tiny = ft_sizehist_parse_usize(&bins);
+		size_t small = (*bins == ',') ? (++bins, ft_sizehist_parse_usize(&bins)) : 0;
+		if (!*bins)
+			(void)ft_heap_set_bins(&g_heap, tiny, small);
+	}
+}
+
+/* A fork child counts its own requests from zero and dumps nothing at exit:
+ * the counts so far and the FT_MALLOC_SIZEHIST file are the parent's. Only
+ * this thread survives, so the lock is set up afresh rather than taken. */
+static void ft_sizehist_atfork_child(void)
+{
+	pthread_mutex_init(&g_sh.lock, NULL);
+	if (g_sh.fd >= 0) {
+		close(g_sh.fd);
+		g_sh.fd = -1;
+	}
+	ft_tl_registry_after_fork(&g_sh.reg, &tl_block);
+	ft_malloc_sizehist_reset();
+}
+
+__attribute__((constructor)) static void ft_sizehist_register_atfork(void)
+{
+	pthread_atfork(NULL, NULL, ft_sizehist_atfork_child);
+}
+
+__attribute__((destructor)) static void ft_sizehist_at_exit(void)
+{
+	pthread_mutex_lock(&g_sh.lock);
+	if (g_sh.fd >= 0) {
+		(void)ft_malloc_sizehist_dump(g_sh.fd);
+		close(g_sh.fd);
+		g_sh.fd = -1;
+	}
+	pthread_mutex_unlock(&g_sh.lock);
+}
@@ -0,0 +1,84 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   sizehist.h                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/19 16:12:08 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/19 16:12:08 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef FT_SIZEHIST_H
+#define FT_SIZEHIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "malloc.h" /* public ft_malloc_sizehist* API */
+#include "helpers/tl_blocks.h"
+
+/* Request-size histogram and the bin-size tuner built on it.
+ * - the public entry points hand every requested size to ft_sizehist(); when
+ *   recording is on, each thread counts into its own block (a per-thread
+ *   block, helpers/tl_blocks.h), and readers add the blocks up: no lock, no
+ *   shared cache line;
+ * - FT_MALLOC_SIZEHIST=<file> turns recording on at load and dumps at exit
+ *   (a forked child starts from zero and dumps nothing);
+ * - FT_MALLOC_BINS=<tiny>,<small> sets the bins of the default heap at load.
+ * The tuner (sizetune.c) is also linked into bench/sizetune, which reads a
+ * dumped histogram and prints the best bins. */
+
+#define FT_SIZEHIST_ENV "FT_MALLOC_SIZEHIST"
+#define FT_BINS_ENV "FT_MALLOC_BINS"
+#define FT_SIZEHIST_MAGIC "ft_sizehist v1"
+
+typedef struct s_sh_block {
+	t_tl_block hdr; /* helpers/tl_blocks.h */
+	ft_sizehist_t hist;
+} t_sh_block;
+
+extern int g_sizehist_on;
+
+void ft_sizehist_record(size_t n);
+
+/* Called by the public entry points; one relaxed load when recording is off. */
+static inline void ft_sizehist(size_t n)
+{
+	if (__builtin_expect(__atomic_load_n(&g_sizehist_on, __ATOMIC_RELAXED), 0))
+		ft_sizehist_record(n);
+}
+
+/* Bucket of a request: fine below FT_SIZEHIST_MAX, then FT_SIZEHIST_FINE + e
+ * for sizes in [2^e, 2^(e+1)). */
+static inline size_t ft_sizehist_bucket(size_t n)
+{
+	size_t need = n ? (n + 15) / 16 * 16 : 16;
+	if (need <= FT_SIZEHIST_MAX)
+		return need / 16 - 1;
+	return FT_SIZEHIST_FINE + (63u - (unsigned)__builtin_clzll((unsigned long long)need));
+}
+
+/* ---- tuner (sizetune.c, no dependency on the heap) ---- */
+
+typedef struct s_sizetune {
+	size_t tiny;
+	size_t small;
+	uint64_t waste; /* bytes lost to rounding with these bins */
+} t_sizetune;
+
+/* Bytes lost to rounding if every fine bucket of h were served with these
+ * bins: bin - size in a slab; above 'small', the zone header and the rest of
+ * the last page of a LARGE zone. Coarse buckets are LARGE whatever the bins,
+ * and left out. */
+uint64_t ft_sizetune_waste(const ft_sizehist_t* h, size_t tiny, size_t small, size_t page);
+
+/* The pair of bins (multiples of 16, tiny < small <= FT_SIZEHIST_MAX) with
+ * the least waste. Returns 0, or -1 if h has no fine bucket counted. */
+int ft_sizetune(const ft_sizehist_t* h, size_t page, t_sizetune* out);
+
+/* Parse the text of ft_malloc_sizehist_dump() (len bytes) into *out.
+ * Returns 0, or -1 if the header is missing or a line is malformed. */
+int ft_sizehist_parse(const char* text, size_t len, ft_sizehist_t* out);
+
+#endif /* FT_SIZEHIST_H */
@@ -0,0 +1,208 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   sizehist_test.c                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/19 17:20:13 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/19 17:20:13 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "sizehist/sizehist.h"
+#include "heap/heap.h"
+#include "munit.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define PAGE 4096
+
+static ft_sizehist_t g_a;
+static ft_sizehist_t g_b;
+
+static MunitResult test_tune_picks_the_spikes(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+	t_sizetune best;
+
+	memset(&g_a, 0, sizeof g_a);
+	munit_assert_int(ft_sizetune(&g_a, PAGE, &best), ==, -1);
+
+	/* three spikes, two classes: the rare one goes LARGE */
+	g_a.fine[ft_sizehist_bucket(24)] = 1000;
+	g_a.fine[ft_sizehist_bucket(200)] = 1000;
+	g_a.fine[ft_sizehist_bucket(3000)] = 10;
+	g_a.coarse[ft_sizehist_bucket(1u << 20) - FT_SIZEHIST_FINE] = 5; /* ignored */
+	munit_assert_int(ft_sizetune(&g_a, PAGE, &best), ==, 0);
+	munit_assert_size(best.tiny, ==, 32);
+	munit_assert_size(best.small, ==, 208);
+	munit_assert_uint64(best.waste, ==, ft_sizetune_waste(&g_a, 32, 208, PAGE));
+	munit_assert_uint64(best.waste, <, ft_sizetune_waste(&g_a, 208, 3008, PAGE));
+	munit_assert_uint64(best.waste, <, ft_sizetune_waste(&g_a, TINY_BIN_SIZE, SMALL_BIN_SIZE, PAGE));
+
+	/* made common, the big one takes the SMALL class */
+	g_a.fine[ft_sizehist_bucket(3000)] = 100000;
+	munit_assert_int(ft_sizetune(&g_a, PAGE, &best), ==, 0);
+	munit_assert_size(best.small, ==, 3008);
+	return MUNIT_OK;
+}
+
+static MunitResult test_dump_parses_back(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+	static char text[1 << 16];
+	static const size_t sizes[] = {0, 1, 16, 17, 100, 100, 4096, FT_SIZEHIST_MAX,
+								   FT_SIZEHIST_MAX + 1, 1u << 20, (1u << 21) - 1};
+
+	ft_malloc_sizehist_reset();
+	ft_sizehist(100); /* off: not counted */
+	munit_assert_int(ft_malloc_sizehist_enable(1), ==, 0);
+	for (size_t i = 0; i < sizeof sizes / sizeof sizes[0]; ++i)
+		ft_sizehist(sizes[i]);
+	munit_assert_int(ft_malloc_sizehist_enable(0), ==, 1);
+
+	ft_malloc_sizehist(&g_a);
+	munit_assert_uint64(g_a.fine[0], ==, 3);
+	munit_assert_uint64(g_a.fine[1], ==, 1);
+	munit_assert_uint64(g_a.fine[ft_sizehist_bucket(100)], ==, 2);
+	munit_assert_uint64(g_a.fine[FT_SIZEHIST_FINE - 1], ==, 1);
+	munit_assert_uint64(g_a.coarse[15], ==, 1);
+	munit_assert_uint64(g_a.coarse[20], ==, 1);
+	munit_assert_uint64(g_a.coarse[21], ==, 1); /* rounded up to 2^21 */
+
+	int fds[2];
+	munit_assert_int(pipe(fds), ==, 0);
+	munit_assert_int(ft_malloc_sizehist_dump(fds[1]), ==, 0);
+	close(fds[1]);
+	size_t len = 0;
+	ssize_t n;
+	while ((n = read(fds[0], text + len, sizeof text - len)) > 0)
+		len += (size_t)n;
+	close(fds[0]);
+
+	munit_assert_int(ft_sizehist_parse(text, len, &g_b), ==, 0);
+	munit_assert_memory_equal(sizeof g_a, &g_a, &g_b);
+	munit_assert_int(ft_sizehist_parse("ft_sizehist v1\n20 1\n", 20, &g_b), ==, -1);
+	munit_assert_int(ft_sizehist_parse("ft_sizehist v1\n2^64 1\n", 22, &g_b), ==, -1);
+	munit_assert_int(ft_sizehist_parse("16 1\n", 5, &g_b), ==, -1);
+	munit_assert_int(ft_malloc_sizehist_dump(-1), ==, -1);
+	munit_assert_int(errno, ==, EBADF);
+	return MUNIT_OK;
+}
+
+#define SH_THREADS 4
+#define SH_PER_THREAD 10000
+
+static void* count_sizes(void* arg)
+{
+	for (int i = 0; i < SH_PER_THREAD; ++i)
+		ft_sizehist((size_t)(uintptr_t)arg);
+	return NULL;
+}
+
+/* per-thread blocks add up, and survive their threads */
+static MunitResult test_threads_count_apart(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+	pthread_t th[SH_THREADS];
+
+	ft_malloc_sizehist_reset();
+	munit_assert_int(ft_malloc_sizehist_enable(1), ==, 0);
+	for (int t = 0; t < SH_THREADS; ++t)
+		munit_assert_int(
+			pthread_create(&th[t], NULL, count_sizes, (void*)(uintptr_t)(t % 2 ? 100 : 1u << 20)),
+			==, 0);
+	for (int t = 0; t < SH_THREADS; ++t)
+		pthread_join(th[t], NULL);
+	/* a new thread takes over an exited one's block */
+	munit_assert_int(pthread_create(&th[0], NULL, count_sizes, (void*)(uintptr_t)100), ==, 0);
+	pthread_join(th[0], NULL);
+	munit_assert_int(ft_malloc_sizehist_enable(0), ==, 1);
+
+	ft_malloc_sizehist(&g_a);
+	munit_assert_uint64(g_a.fine[ft_sizehist_bucket(100)], ==, 3 * SH_PER_THREAD);
+	munit_assert_uint64(g_a.coarse[20], ==, 2 * SH_PER_THREAD);
+
+	ft_malloc_sizehist_reset();
+	ft_malloc_sizehist(&g_a);
+	munit_assert_uint64(g_a.fine[ft_sizehist_bucket(100)], ==, 0);
+	munit_assert_uint64(g_a.coarse[20], ==, 0);
+	return MUNIT_OK;
+}
+
+/* a forked child counts from zero; the parent keeps its counts */
+static MunitResult test_fork_child_starts_empty(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+
+	ft_malloc_sizehist_reset();
+	munit_assert_int(ft_malloc_sizehist_enable(1), ==, 0);
+	for (int i = 0; i < 10; ++i)
+		ft_sizehist(100);
+	pid_t pid = fork();
+	munit_assert_int(pid, >=, 0);
+	if (pid == 0) {
+		ft_malloc_sizehist(&g_a);
+		int ok = g_a.fine[ft_sizehist_bucket(100)] == 0;
+		ft_sizehist(100);
+		ft_malloc_sizehist(&g_a);
+		_exit(!(ok && g_a.fine[ft_sizehist_bucket(100)] == 1));
+	}
+	int status;
+	munit_assert_int(waitpid(pid, &status, 0), ==, pid);
+	munit_assert_true(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	munit_assert_int(ft_malloc_sizehist_enable(0), ==, 1);
+	ft_malloc_sizehist(&g_a);
+	munit_assert_uint64(g_a.fine[ft_sizehist_bucket(100)], ==, 10);
+	ft_malloc_sizehist_reset();
+	return MUNIT_OK;
+}
+
+static MunitResult test_set_bins_only_on_empty_heap(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+	ft_heap_t* h = ft_heap_create(NULL);
+
+	munit_assert_int(ft_heap_set_bins(h, 48, 40), ==, -1);
+	munit_assert_int(errno, ==, EINVAL);
+	munit_assert_int(ft_heap_set_bins(h, 40, 208), ==, -1);
+	munit_assert_int(ft_heap_set_bins(h, 48, FT_SIZEHIST_MAX + 16), ==, -1);
+
+	void* large = ft_heap_alloc(h, 100000); /* LARGE zones do not matter */
+	munit_assert_int(ft_heap_set_bins(h, 48, 208), ==, 0);
+	void* p = ft_heap_alloc(h, 200);
+	munit_assert_int(ft_heap_find_owner(h, p)->klass, ==, FT_Z_SMALL);
+	munit_assert_size(ft_heap_find_owner(h, p)->bin_size, ==, 208);
+
+	munit_assert_int(ft_heap_set_bins(h, 64, 256), ==, -1);
+	munit_assert_int(errno, ==, EBUSY);
+	ft_heap_dealloc(h, p);
+	ft_heap_dealloc(h, large);
+	ft_heap_destroy(h);
+	return MUNIT_OK;
+}
+
+static MunitTest tests[] = {
+	{"/sizehist/tune_picks_the_spikes", test_tune_picks_the_spikes, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/sizehist/dump_parses_back", test_dump_parses_back, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/sizehist/threads_count_apart", test_threads_count_apart, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/sizehist/fork_child_starts_empty", test_fork_child_starts_empty, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/sizehist/set_bins_only_on_empty_heap", test_set_bins_only_on_empty_heap, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+static const MunitSuite suite = {"/sizehist", tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
+
+int main(int argc, char* argv[MUNIT_ARRAY_PARAM(argc + 1)])
+{
+	return munit_suite_main(&suite, NULL, argc, argv);
+}
@@ -0,0 +1,147 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   sizetune.c                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/19 16:40:31 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/19 16:40:31 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "sizehist/sizehist.h"
+#include "zone/zone.h" /* sizeof(t_zone): header of a LARGE zone */
+
+/* Fine bucket i holds requests rounded up to (i + 1) * 16 bytes; every one of
+ * its requests is costed at that size. */
+#define FT_BUCKET_BYTES(i) ((uint64_t)((i) + 1) * 16)
+
+static uint64_t ft_sizetune_large_waste(uint64_t need, size_t page)
+{
+	const uint64_t hdr = (sizeof(t_zone) + 15) / 16 * 16;
+	const uint64_t total = (hdr + need + page - 1) / page * page;
+	return total - need;
+}
+
+uint64_t ft_sizetune_waste(const ft_sizehist_t* h, size_t tiny, size_t small, size_t page)
+{
+	uint64_t waste = 0;
+
+	for (size_t i = 0; i < FT_SIZEHIST_FINE; ++i) {
+		uint64_t need = FT_BUCKET_BYTES(i);
+		if (!h->fine[i])
+			continue;
+		if (need <= tiny)
+			waste += (tiny - need) * h->fine[i];
+		else if (need <= small)
+			waste += (small - need) * h->fine[i];
+		else
+			waste += ft_sizetune_large_waste(need, page) * h->fine[i];
+	}
+	return waste;
+}
+
+/* With prefix sums of counts (pc), bytes (ps) and LARGE waste (pl) over the
+ * buckets below k, the waste of bins (16 (a + 1), 16 (b + 1)) is
+ *   tiny * pc[a+1] - ps[a+1]                          (TINY)
+ * + small * (pc[b+1] - pc[a+1]) - (ps[b+1] - ps[a+1]) (SMALL)
+ * + pl[F] - pl[b+1]                                   (LARGE)
+ * so every pair is costed in O(1): 2M pairs for 32 KiB of fine buckets. */
+int ft_sizetune(const ft_sizehist_t* h, size_t page, t_sizetune* out)
+{
+	uint64_t pc[FT_SIZEHIST_FINE + 1];
+	uint64_t ps[FT_SIZEHIST_FINE + 1];
+	uint64_t pl[FT_SIZEHIST_FINE + 1];
+
+	pc[0] = ps[0] = pl[0] = 0;
+	for (size_t i = 0; i < FT_SIZEHIST_FINE; ++i) {
+		uint64_t need = FT_BUCKET_BYTES(i);
+		pc[i + 1] = pc[i] + h->fine[i];
+		ps[i + 1] = ps[i] + need * h->fine[i];
+		pl[i + 1] = pl[i] + ft_sizetune_large_waste(need, page) * h->fine[i];
+	}
+	if (!pc[FT_SIZEHIST_FINE])
+		return -1;
+
+	t_sizetune best = {0, 0, UINT64_MAX};
+	for (size_t a = 0; a + 1 < FT_SIZEHIST_FINE; ++a) {
+		uint64_t tiny = FT_BUCKET_BYTES(a);
+		uint64_t w_tiny = tiny * pc[a + 1] - ps[a + 1];
+		if (w_tiny >= best.waste)
+			break; /* only grows with a */
+		for (size_t b = a + 1; b < FT_SIZEHIST_FINE; ++b) {
+			uint64_t small = FT_BUCKET_BYTES(b);
+			uint64_t w = w_tiny + small * (pc[b + 1] - pc[a + 1]) - (ps[b + 1] - ps[a + 1]) +
+						 (pl[FT_SIZEHIST_FINE] - pl[b + 1]);
+			if (w < best.waste)
+				best = (t_sizetune){(size_t)tiny, (size_t)small, w};
+		}
+	}
+	*out = best;
+	return 0;
+}
+
+/* ---- dump parser ---- */
+
+static int ft_sizehist_parse_u64(const char** s, const char* end, uint64_t* v)
+{
+	const char* p = *s;
+	uint64_t x = 0;
+	while (p < end && *p >= '0' && *p <= '9') {
+		uint64_t d = (uint64_t)(*p++ - '0');
+		if (x > (UINT64_MAX - d) / 10)
+			return -1;
+		x = x * 10 + d;
+	}
+	if (p == *s)
+		return -1;
+	*s = p;
+	*v = x;
+	return 0;
+}
+
+static int ft_sizehist_parse_line(const char* p, const char* end, ft_sizehist_t* out)
+{
+	int coarse = (end - p >= 2 && p[0] == '2' && p[1] == '^');
+	uint64_t key, count;
+
+	if (coarse)
+		p += 2;
+	if (ft_sizehist_parse_u64(&p, end, &key) || p == end || *p++ != ' ' ||
+		ft_sizehist_parse_u64(&p, end, &count) || p != end)
+		return -1;
+	if (coarse) {
+		if (key >= FT_SIZEHIST_COARSE)
+			return -1;
+		out->coarse[key] += count;
+		return 0;
+	}
+	if (!key || key % 16 || key > FT_SIZEHIST_MAX)
+		return -1;
+	out->fine[key / 16 - 1] += count;
+	return 0;
+}
+
+int ft_sizehist_parse(const char* text, size_t len, ft_sizehist_t* out)
+{
+	const char* end = text + len;
+	const char* magic = FT_SIZEHIST_MAGIC "\n";
+	size_t mlen = sizeof(FT_SIZEHIST_MAGIC);
+
+	*out = (ft_sizehist_t){{0}, {0}};
+	if (len < mlen)
+		return -1;
+	for (size_t i = 0; i < mlen; ++i)
+		if (text[i] != magic[i])
+			return -1;
+	for (const char* p = text + mlen; p < end;) {
+		const char* eol = p;
+		while (eol < end && *eol != '\n')
+			eol++;
+		if (eol > p && ft_sizehist_parse_line(p, eol, out))
+			return -1;
+		p = eol + 1;
+	}
+	return 0;
+}
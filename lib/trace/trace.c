@@ -0,0 +1,280 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   trace.c                                            :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/13 09:21:50 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/13 09:21:50 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "trace/trace.h"
+#include "helpers/helpers.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h> /* getenv */
+#include <sys/syscall.h>
+#include <time.h>
+
+#define FT_TRACE_WRITE_BATCH 256 /* records per write(2) */
+
+int g_trace_on = 0;
+
+static struct {
+	pthread_mutex_t lock; /* start/stop */
+	int running;
+	int stop;
+	int fd;
+	pthread_t writer;
+	t_tl_registry reg;
+	uint64_t n_records;
+	uint64_t n_dropped;
+	uint64_t start_tsc;
+	uint64_t start_ns;
+} g_trace = {.lock = PTHREAD_MUTEX_INITIALIZER,
+			   .fd = -1,
+			   .reg = FT_TL_REGISTRY_INIT(sizeof(t_trace_ring), FT_TL_BLOCK_DETACHED)};
+
+static __thread t_tl_block* tl_ring __attribute__((tls_model("initial-exec")));
+
+/* ---------------- clocks ---------------- */
+
+static uint64_t ft_trace_now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t ft_trace_tsc(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#else
+	return ft_trace_now_ns();
+#endif
+}
+
+static uint32_t ft_trace_tid(void)
+{
+#ifdef SYS_gettid
+	return (uint32_t)syscall(SYS_gettid);
+#else
+	return (uint32_t)(uintptr_t)pthread_self();
+#endif
+}
+
+/* ---------------- rings ---------------- */
+
+int ft_trace_ring_push(t_trace_ring* r, const t_trace_rec* rec)
+{
+	uint64_t h = r->head;
+	if (h - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) == FT_TRACE_RING_RECS) {
+		__atomic_add_fetch(&r->dropped, 1, __ATOMIC_RELAXED);
+		return -1;
+	}
+	r->recs[h & (FT_TRACE_RING_RECS - 1)] = *rec;
+	__atomic_store_n(&r->head, h + 1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+size_t ft_trace_ring_drain(t_trace_ring* r, t_trace_rec* out, size_t max)
+{
+	uint64_t t = r->tail;
+	uint64_t h = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+	size_t n = 0;
+	while (t != h && n < max)
+		out[n++] = r->recs[t++ & (FT_TRACE_RING_RECS - 1)];
+	__atomic_store_n(&r->tail, t, __ATOMIC_RELEASE);
+	return n;
+}
+
+void ft_trace_record(t_trace_op op, const void* ptr, const void* ret, size_t size, size_t align)
+{
+	t_tl_block* t = tl_ring;
+	if (t == FT_TL_BLOCK_GONE)
+		return;
+	if (!t) {
+		if (!(t = ft_tl_block_acquire(&g_trace.reg, &tl_ring)))
+			return;
+		((t_trace_ring*)t)->tid = ft_trace_tid();
+	}
+	t_trace_ring* r = (t_trace_ring*)t;
+
+	t_trace_rec rec;
+	rec.tsc = ft_trace_tsc();
+	rec.ptr = (uint64_t)(uintptr_t)ptr;
+	rec.ret = (uint64_t)(uintptr_t)ret;
+	rec.size = (uint64_t)size;
+	rec.tid = r->tid;
+	rec.op = (uint16_t)op;
+	rec.align_log2 = align ? (uint16_t)__builtin_ctzll((unsigned long long)align) : 0;
+	ft_trace_ring_push(r, &rec);
+}
+
+/* ---------------- writer ---------------- */
+
+static void ft_trace_write_all(const void* buf, size_t len)
+{
+	const char* p = (const char*)buf;
+	while (len) {
+		ssize_t n = write(g_trace.fd, p, len);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return;
+		p += n;
+		len -= (size_t)n;
+	}
+}
+
+/* one pass over every ring; returns the number of records written */
+static size_t ft_trace_drain_all(void)
+{
+	t_trace_rec batch[FT_TRACE_WRITE_BATCH];
+	size_t total = 0;
+
+	for (t_tl_block* t = ft_tl_blocks(&g_trace.reg); t; t = t->next) {
+		t_trace_ring* r = (t_trace_ring*)t;
+		int detached = __atomic_load_n(&t->state, __ATOMIC_ACQUIRE) == FT_TL_BLOCK_DETACHED;
+		size_t n;
+		while ((n = ft_trace_ring_drain(r, batch, FT_TRACE_WRITE_BATCH)) > 0) {
+			ft_trace_write_all(batch, n * sizeof(*batch));
+			total += n;
+		}
+		g_trace.n_dropped += __atomic_exchange_n(&r->dropped, 0, __ATOMIC_RELAXED);
+		/* the owner is gone and pushed its last record before detaching */
+		if (detached)
+			__atomic_store_n(&t->state, FT_TL_BLOCK_FREE, __ATOMIC_RELEASE);
+	}
+	g_trace.n_records += total;
+	return total;
+}
+
+static void* ft_trace_writer_main(void* arg)
+{
+	(void)arg;
+	tl_ring = FT_TL_BLOCK_GONE; /* the writer's own allocations are not traced */
+	while (!__atomic_load_n(&g_trace.stop, __ATOMIC_ACQUIRE)) {
+		if (ft_trace_drain_all() == 0) {
+			struct timespec ts = {0, FT_TRACE_FLUSH_NS};
+			nanosleep(&ts, NULL);
+		}
+	}
+	return NULL;
+}
+
+static void ft_trace_write_header(uint64_t tsc_per_sec)
+{
+	t_trace_file_header hdr = {{0}, FT_TRACE_VERSION, sizeof(t_trace_rec), 0, 0, 0, 0};
+	ft_memcpy(hdr.magic, FT_TRACE_MAGIC, sizeof hdr.magic);
+	hdr.n_records = g_trace.n_records;
+	hdr.n_dropped = g_trace.n_dropped;
+	hdr.tsc_per_sec = tsc_per_sec;
+	hdr.start_tsc = g_trace.start_tsc;
+	(void)!pwrite(g_trace.fd, &hdr, sizeof hdr, 0);
+}
+
+int ft_trace_start(const char* path)
+{
+	pthread_mutex_lock(&g_trace.lock);
+	if (g_trace.running) {
+		pthread_mutex_unlock(&g_trace.lock);
+		errno = EBUSY;
+		return -1;
+	}
+	g_trace.fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (g_trace.fd < 0) {
+		pthread_mutex_unlock(&g_trace.lock);
+		return -1;
+	}
+	ft_tl_registry_start(&g_trace.reg);
+
+	g_trace.n_records = 0;
+	g_trace.n_dropped = 0;
+	g_trace.start_tsc = ft_trace_tsc();
+	g_trace.start_ns = ft_trace_now_ns();
+	ft_trace_write_header(0);
+	(void)lseek(g_trace.fd, sizeof(t_trace_file_header), SEEK_SET);
+
+	g_trace.stop = 0;
+	int err = pthread_create(&g_trace.writer, NULL, ft_trace_writer_main, NULL);
+	if (err) {
+		close(g_trace.fd);
+		g_trace.fd = -1;
+		pthread_mutex_unlock(&g_trace.lock);
+		errno = err;
+		return -1;
+	}
+	g_trace.running = 1;
+	__atomic_store_n(&g_trace_on, 1, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&g_trace.lock);
+	return 0;
+}
+
+void ft_trace_stop(void)
+{
+	pthread_mutex_lock(&g_trace.lock);
+	if (!g_trace.running) {
+		pthread_mutex_unlock(&g_trace.lock);
+		return;
+	}
+	__atomic_store_n(&g_trace_on, 0, __ATOMIC_RELEASE);
+	__atomic_store_n(&g_trace.stop, 1, __ATOMIC_RELEASE);
+	pthread_join(g_trace.writer, NULL);
+	ft_trace_drain_all();
+
+	uint64_t ticks = ft_trace_tsc() - g_trace.start_tsc;
+	uint64_t ns = ft_trace_now_ns() - g_trace.start_ns;
+	uint64_t rate = ns ? (uint64_t)((double)ticks * 1e9 / (double)ns) : 0;
+	ft_trace_write_header(rate);
+	close(g_trace.fd);
+	g_trace.fd = -1;
+	g_trace.running = 0;
+	pthread_mutex_unlock(&g_trace.lock);
+}
+
+/* ---------------- process lifetime ---------------- */
+
+/* A fork child has neither the writer nor a file of its own: the fd and the
+ * header are the parent's, and so are the records left in the rings. It
+ * records nothing and leaves all three alone. Only this thread survives, so
+ * the lock is set up afresh rather than taken. */
+static void ft_trace_atfork_child(void)
+{
+	__atomic_store_n(&g_trace_on, 0, __ATOMIC_RELAXED);
+	pthread_mutex_init(&g_trace.lock, NULL);
+	if (g_trace.running) {
+		close(g_trace.fd);
+		g_trace.fd = -1;
+		g_trace.running = 0;
+	}
+	for (t_tl_block* t = ft_tl_blocks(&g_trace.reg); t; t = t->next) {
+		t_trace_ring* r = (t_trace_ring*)t;
+		r->tail = r->head;
+		r->dropped = 0;
+	}
+	/* a ring taken again gets this process's tid */
+	ft_tl_registry_after_fork(&g_trace.reg, &tl_ring);
+}
+
+__attribute__((constructor)) static void ft_trace_register_atfork(void)
+{
+	pthread_atfork(NULL, NULL, ft_trace_atfork_child);
+}
+
+__attribute__((constructor)) static void ft_trace_from_env(void)
+{
+	const char* path = getenv(FT_TRACE_ENV);
+	if (path && *path)
+		(void)ft_trace_start(path);
+}
+
+__attribute__((destructor)) static void ft_trace_at_exit(void)
+{
+	ft_trace_stop();
+}
@@ -0,0 +1,71 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   trace.h                                            :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/13 09:21:50 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/13 09:21:50 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef FT_TRACE_H
+#define FT_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "helpers/tl_blocks.h"
+#include "trace/trace_format.h"
+
+/* Allocation trace recorder.
+ * - FT_MALLOC_TRACE=<path> in the environment starts it when the library is
+ *   loaded; it stops (and finalizes the file header) at exit;
+ * - every thread owns a single-producer/single-consumer ring of records in a
+ *   scratch mapping: recording is a few stores and one release store, no lock,
+ *   no syscall. A full ring drops the event and counts it;
+ * - a writer thread drains all rings every FT_TRACE_FLUSH_NS into the file;
+ * - rings of exited threads are drained one last time, then reused;
+ * - a forked child stops recording and drops what it inherited: the file and
+ *   its header stay the parent's.
+ * When tracing is off the hooks cost a single, predictable branch. */
+
+#define FT_TRACE_ENV "FT_MALLOC_TRACE"
+#define FT_TRACE_RING_RECS 4096 /* power of two */
+#define FT_TRACE_FLUSH_NS (10 * 1000 * 1000)
+
+/* A per-thread block (helpers/tl_blocks.h). Its owner's exit leaves it
+ * DETACHED: it may still hold records, and the writer frees it once drained. */
+typedef struct s_trace_ring {
+	t_tl_block hdr;
+	uint32_t tid;
+	uint64_t dropped;
+	uint64_t head __attribute__((aligned(64))); /* written by the owner only */
+	uint64_t tail __attribute__((aligned(64))); /* written by the writer only */
+	t_trace_rec recs[FT_TRACE_RING_RECS];
+} t_trace_ring;
+
+extern int g_trace_on;
+
+void ft_trace_record(t_trace_op op, const void* ptr, const void* ret, size_t size, size_t align);
+
+/* Called by the public entry points: before the operation for what releases
+ * a block, after it for what returns one (see trace_format.h). */
+static inline void
+ft_trace(t_trace_op op, const void* ptr, const void* ret, size_t size, size_t align)
+{
+	if (__builtin_expect(__atomic_load_n(&g_trace_on, __ATOMIC_RELAXED), 0))
+		ft_trace_record(op, ptr, ret, size, align);
+}
+
+/* Start recording into 'path' (truncated). Returns 0, or -1 (errno set) if
+ * the file or the writer thread cannot be created or a trace is running. */
+int ft_trace_start(const char* path);
+/* Stop the writer, drain every ring and rewrite the header. */
+void ft_trace_stop(void);
+
+/* ring primitives (exposed for tests) */
+int ft_trace_ring_push(t_trace_ring* r, const t_trace_rec* rec);
+size_t ft_trace_ring_drain(t_trace_ring* r, t_trace_rec* out, size_t max);
+
+#endif /* FT_TRACE_H */
@@ -0,0 +1,67 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   trace_format.h                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/13 09:21:50 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/13 09:21:50 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef FT_TRACE_FORMAT_H
+#define FT_TRACE_FORMAT_H
+
+/* On-disk allocation trace, shared by the recorder (lib/trace) and the tools
+ * that read it (bench/). Host byte order, no padding:
+ *
+ *   t_trace_file_header
+ *   t_trace_rec * n_records
+ *
+ * Records of one thread are in program order; records of different threads
+ * are in the order the writer drained them, so sort by tsc for a global
+ * order. Frees are stamped before the block is released and allocations
+ * after they got it, so an address is never reused before it was freed.
+ * A realloc is both: FT_TRACE_REALLOC is stamped before the call, and the
+ * same thread's next record is its FT_TRACE_REALLOC_RET, stamped after.
+ * The header is rewritten when the recorder stops: a trace whose n_records
+ * is 0 was cut short, and readers then go by the file size. */
+
+#include <stdint.h>
+
+#define FT_TRACE_MAGIC "FTTRACE1"
+#define FT_TRACE_VERSION 2
+
+typedef enum e_trace_op {
+	FT_TRACE_MALLOC = 1,	/* size -> ret */
+	FT_TRACE_FREE,			/* ptr (size: free_sized hint, else 0) */
+	FT_TRACE_REALLOC,		/* ptr, size: the old block is about to go */
+	FT_TRACE_ALIGNED_ALLOC, /* align, size -> ret */
+	FT_TRACE_REALLOC_RET	/* ptr, size -> ret: the realloc returned */
+} t_trace_op;
+
+typedef struct s_trace_file_header {
+	char magic[8];		  /* FT_TRACE_MAGIC, not NUL-terminated */
+	uint32_t version;	  /* FT_TRACE_VERSION */
+	uint32_t record_size; /* sizeof(t_trace_rec) */
+	uint64_t n_records;	  /* records that follow */
+	uint64_t n_dropped;	  /* events lost to full rings */
+	uint64_t tsc_per_sec; /* rate of the tsc field (1e9 when it is in ns) */
+	uint64_t start_tsc;
+} t_trace_file_header;
+
+typedef struct s_trace_rec {
+	uint64_t tsc;
+	uint64_t ptr;  /* argument pointer (free/realloc) */
+	uint64_t ret;  /* returned pointer (malloc/realloc/aligned_alloc) */
+	uint64_t size; /* requested size */
+	uint32_t tid;
+	uint16_t op;	 /* t_trace_op */
+	uint16_t align_log2; /* aligned_alloc only */
+} t_trace_rec;
+
+_Static_assert(sizeof(t_trace_file_header) == 48, "trace header layout");
+_Static_assert(sizeof(t_trace_rec) == 40, "trace record layout");
+
+#endif /* FT_TRACE_FORMAT_H */
@@ -0,0 +1,146 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   trace_test.c                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/13 11:05:12 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/13 11:05:12 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "trace/trace.h"
+#include "helpers/helpers.h"
+#include "munit.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static MunitResult test_ring_fifo_and_drop(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+
+	t_trace_ring* r = (t_trace_ring*)ft_scratch_map(sizeof(*r));
+	munit_assert_not_null(r);
+
+	t_trace_rec rec = {0};
+	for (uint64_t i = 0; i < FT_TRACE_RING_RECS; ++i) {
+		rec.size = i;
+		munit_assert_int(ft_trace_ring_push(r, &rec), ==, 0);
+	}
+	/* full: the event is dropped and counted, nothing is overwritten */
+	munit_assert_int(ft_trace_ring_push(r, &rec), ==, -1);
+	munit_assert_uint64(r->dropped, ==, 1);
+
+	t_trace_rec out[100];
+	munit_assert_size(ft_trace_ring_drain(r, out, 100), ==, 100);
+	munit_assert_uint64(out[0].size, ==, 0);
+	munit_assert_uint64(out[99].size, ==, 99);
+
+	/* drained slots are writable again, order is preserved across the wrap */
+	rec.size = 12345;
+	munit_assert_int(ft_trace_ring_push(r, &rec), ==, 0);
+	size_t left = 0, n;
+	while ((n = ft_trace_ring_drain(r, out, 100)) > 0) {
+		left += n;
+		rec = out[n - 1];
+	}
+	munit_assert_size(left, ==, FT_TRACE_RING_RECS - 100 + 1);
+	munit_assert_uint64(rec.size, ==, 12345);
+
+	ft_scratch_unmap(r, sizeof(*r));
+	return MUNIT_OK;
+}
+
+static void* traced_thread(void* arg)
+{
+	(void)arg;
+	for (int i = 0; i < 1000; ++i)
+		ft_trace(FT_TRACE_MALLOC, NULL, (void*)(uintptr_t)(0x1000 + i), 24, 0);
+	return NULL;
+}
+
+static MunitResult test_file_roundtrip(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+
+	char path[] = "/tmp/ft_trace_testXXXXXX";
+	int fd = mkstemp(path);
+	munit_assert_int(fd, >=, 0);
+	close(fd);
+
+	munit_assert_int(ft_trace_start(path), ==, 0);
+	munit_assert_int(ft_trace_start(path), ==, -1); /* already running */
+
+	ft_trace(FT_TRACE_ALIGNED_ALLOC, NULL, (void*)0x4000, 100, 64);
+	ft_trace(FT_TRACE_REALLOC, (void*)0x4000, NULL, 200, 0);
+	ft_trace(FT_TRACE_REALLOC_RET, (void*)0x4000, (void*)0x8000, 200, 0);
+	ft_trace(FT_TRACE_FREE, (void*)0x8000, NULL, 0, 0);
+	pthread_t th;
+	munit_assert_int(pthread_create(&th, NULL, traced_thread, NULL), ==, 0);
+	pthread_join(th, NULL);
+	ft_trace_stop();
+
+	/* off: nothing more is recorded */
+	ft_trace(FT_TRACE_FREE, (void*)0x1000, NULL, 0, 0);
+
+	fd = open(path, O_RDONLY);
+	munit_assert_int(fd, >=, 0);
+	t_trace_file_header hdr;
+	munit_assert_int(read(fd, &hdr, sizeof hdr), ==, (int)sizeof hdr);
+	munit_assert_memory_equal(8, hdr.magic, FT_TRACE_MAGIC);
+	munit_assert_uint32(hdr.version, ==, FT_TRACE_VERSION);
+	munit_assert_uint32(hdr.record_size, ==, sizeof(t_trace_rec));
+	munit_assert_uint64(hdr.n_records, ==, 1004);
+	munit_assert_uint64(hdr.n_dropped, ==, 0);
+	munit_assert_uint64(hdr.tsc_per_sec, >, 0);
+
+	static t_trace_rec recs[1100];
+	ssize_t got = read(fd, recs, sizeof recs);
+	close(fd);
+	unlink(path);
+	munit_assert_int((int)got, ==, (int)(1004 * sizeof(t_trace_rec)));
+
+	uint32_t main_tid = 0, thread_tid = 0;
+	size_t n_thread = 0;
+	for (size_t i = 0; i < 1004; ++i) {
+		if (recs[i].op == FT_TRACE_ALIGNED_ALLOC) {
+			munit_assert_uint16(recs[i].align_log2, ==, 6);
+			munit_assert_uint64(recs[i].ret, ==, 0x4000);
+			main_tid = recs[i].tid;
+		} else if (recs[i].op == FT_TRACE_REALLOC_RET) {
+			/* the thread's previous record is its release half */
+			size_t k = i;
+			while (k-- > 0 && recs[k].tid != recs[i].tid)
+				;
+			munit_assert_size(k, <, i);
+			munit_assert_uint16(recs[k].op, ==, FT_TRACE_REALLOC);
+			munit_assert_uint64(recs[k].tsc, <=, recs[i].tsc);
+			munit_assert_uint64(recs[i].ret, ==, 0x8000);
+		} else if (recs[i].op == FT_TRACE_MALLOC) {
+			thread_tid = recs[i].tid;
+			n_thread++;
+		}
+	}
+	munit_assert_size(n_thread, ==, 1000);
+	munit_assert_uint32(main_tid, !=, thread_tid);
+	return MUNIT_OK;
+}
+
+static MunitTest tests[] = {
+	{"/trace/ring_fifo_and_drop", test_ring_fifo_and_drop, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/trace/file_roundtrip", test_file_roundtrip, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+static const MunitSuite suite = {"/trace", tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
+
+int main(int argc, char* argv[MUNIT_ARRAY_PARAM(argc + 1)])
+{
+	return munit_suite_main(&suite, NULL, argc, argv);
+}
@@ -11,6 +11,7 @@
 /* ************************************************************************** */
 
 #include "zone.h"
+#include "probe/probe.h"
 #include <sys/mman.h>
 #include <unistd.h>
 
@@ -35,10 +36,10 @@
 
 // static declarations
 
-static size_t ft_zone_find_first_free_block(t_zone* z);
-static t_zone* ft_zone_make_large(size_t hdr, size_t ps, size_t need);
-static t_zone*
-ft_zone_make_slab(t_zone_class klass, size_t hdr, size_t ps, size_t bsz, size_t min_blocks);
+static t_zone* ft_zone_make_large(
+	size_t hdr, size_t ps, size_t need, size_t room, size_t align, t_zone_arena* arena);
+static t_zone* ft_zone_make_slab(
+	t_zone_class klass, size_t hdr, size_t ps, size_t bsz, size_t min_blocks, t_zone_arena* arena);
 
 /* ---------------- internal mmap helpers ---------------- */
 
@@ -54,6 +55,39 @@ static void ft_unmap(void* p, size_t bytes)
 		(void)munmap(p, bytes);
 }
 
+/* map 'bytes' at an address that is a multiple of 'align' (power of two):
+ * over-map by 'align' then give back the unaligned head and the tail. */
+static void* ft_map_aligned(size_t bytes, size_t align)
+{
+	if (align <= ft_page_size())
+		return ft_map(bytes);
+	if (bytes > SIZE_MAX - align)
+		return NULL;
+
+	uintptr_t raw = (uintptr_t)ft_map(bytes + align);
+	if (!raw)
+		return NULL;
+
+	uintptr_t base = (raw + align - 1) & ~(uintptr_t)(align - 1);
+	ft_unmap((void*)raw, base - raw);
+	ft_unmap((void*)(base + bytes), (raw + align) - base);
+	return (void*)base;
+}
+
+/* mapping of a new zone: carved from the arena if there is one */
+static void* ft_zone_map(t_zone_arena* arena, size_t bytes, size_t align)
+{
+	return arena ? ft_zone_arena_take(arena, bytes, align) : ft_map_aligned(bytes, align);
+}
+
+static void ft_zone_unmap(t_zone_arena* arena, void* p, size_t bytes)
+{
+	if (arena)
+		ft_zone_arena_give(arena, p, bytes);
+	else
+		ft_unmap(p, bytes);
+}
+
 /* ---------------- zone creation/destruction ---------------- */
 
 // t_zone_new: create either a slab (FT_Z_TINY/FT_Z_SMALL) or a large zone (FT_Z_LARGE).
@@ -63,24 +97,63 @@ static void ft_unmap(void* p, size_t bytes)
 // in zone.c.
 
 t_zone* ft_zone_new(t_zone_class klass, size_t bin_size, size_t min_blocks)
+{
+	return ft_zone_new_aligned(klass, bin_size, FT_ALIGN, min_blocks, NULL);
+}
+
+t_zone* ft_zone_new_aligned(
+	t_zone_class klass, size_t bin_size, size_t align, size_t min_blocks, t_zone_arena* arena)
 {
 	const size_t ps = ft_page_size();
-	const size_t hdr = ft_align_up(sizeof(t_zone), FT_ALIGN); // keep payload aligned
 
+	if (align < FT_ALIGN)
+		align = FT_ALIGN;
+	if (align & (align - 1))
+		return NULL;
+
+	const size_t hdr = ft_align_up(sizeof(t_zone), align); // keep payload aligned
+
+	t_zone* z;
 	if (klass == FT_Z_LARGE) {
 		const size_t need = ft_align_up(bin_size ? bin_size : 1, FT_ALIGN);
-		return ft_zone_make_large(hdr, ps, need);
+		if (need > SIZE_MAX - hdr - ps)
+			return NULL;
+		z = ft_zone_make_large(hdr, ps, need, need, align, arena);
+	} else {
+		// slab blocks are aligned through the page-aligned base of the mapping
+		if (align > ps)
+			return NULL;
+		const size_t bsz = ft_align_up(bin_size ? bin_size : 1, align);
+		const size_t mb = min_blocks ? min_blocks : 1;
+		z = ft_zone_make_slab(klass, hdr, ps, bsz, mb, arena);
 	}
+	if (z)
+		FT_PROBE4(zone_new, z, z->klass, z->bin_size, ft_zone_mapped_bytes(z));
+	return z;
+}
+
+t_zone* ft_zone_new_large_room(size_t bin_size, size_t room, t_zone_arena* arena)
+{
+	const size_t ps = ft_page_size();
+	const size_t hdr = ft_align_up(sizeof(t_zone), FT_ALIGN);
+	const size_t need = ft_align_up(bin_size ? bin_size : 1, FT_ALIGN);
 
-	const size_t bsz = ft_align_up(bin_size ? bin_size : 1, FT_ALIGN);
-	const size_t mb = min_blocks ? min_blocks : 1;
-	return ft_zone_make_slab(klass, hdr, ps, bsz, mb);
+	if (room < need)
+		room = need;
+	if (room > SIZE_MAX - hdr - ps)
+		return NULL;
+	t_zone* z = ft_zone_make_large(hdr, ps, need, room, FT_ALIGN, arena);
+	if (z)
+		FT_PROBE4(zone_new, z, z->klass, z->bin_size, ft_zone_mapped_bytes(z));
+	return z;
 }
 
-static t_zone* ft_zone_make_large(size_t hdr, size_t ps, size_t need)
+/* payload of 'need' bytes in a mapping with room for 'room' */
+static t_zone* ft_zone_make_large(
+	size_t hdr, size_t ps, size_t need, size_t room, size_t align, t_zone_arena* arena)
 {
-	const size_t total = ft_align_up(hdr + need, ps);
-	t_zone* z = (t_zone*)ft_map(total);
+	const size_t total = ft_align_up(hdr + room, ps);
+	t_zone* z = (t_zone*)ft_zone_map(arena, total, align);
 	if (!z)
 		return NULL;
 
@@ -93,23 +166,21 @@ static t_zone* ft_zone_make_large(size_t hdr, size_t ps, size_t need)
 	z->mem_end = (void*)((uintptr_t)z->mem_begin + need);
 	z->occ = NULL;
 	z->map_end = (void*)((uintptr_t)z + total);
+	z->arena = arena;
 	return z;
 }
 
-static t_zone*
-ft_zone_make_slab(t_zone_class klass, size_t hdr, size_t ps, size_t bsz, size_t min_blocks)
+static t_zone* ft_zone_make_slab(
+	t_zone_class klass, size_t hdr, size_t ps, size_t bsz, size_t min_blocks, t_zone_arena* arena)
 {
-	// each block costs: payload (bsz) + 1 byte in occ[]
-	const size_t total_min = hdr + min_blocks * (bsz + 1);
-	const size_t total = ft_align_up(total_min, ps);
-	const size_t raw = total - hdr;
-	const size_t cap = raw / (bsz + 1);
+	size_t total;
+	const size_t cap = ft_slab_capacity(hdr, bsz, min_blocks, ps, &total);
 	if (cap == 0)
 		return NULL;
 
 	const size_t pay_bytes = cap * bsz;
 
-	t_zone* z = (t_zone*)ft_map(total);
+	t_zone* z = (t_zone*)ft_zone_map(arena, total, ps);
 	if (!z)
 		return NULL;
 
@@ -126,7 +197,41 @@ ft_zone_make_slab(t_zone_class klass, size_t hdr, size_t ps, size_t bsz, size_t
 	z->occ = (uint8_t*)z->mem_end;
 
 	z->map_end = (void*)((uintptr_t)z + total);
+	z->arena = arena;
+
+	return z;
+}
+
+t_zone* ft_zone_new_pool(size_t obj_size, size_t align, size_t span)
+{
+	const size_t hdr = ft_align_up(sizeof(t_zone), FT_ALIGN);
+
+	if (!obj_size || !align || align > FT_ALIGN || (align & (align - 1)) || obj_size % align)
+		return NULL;
+	if (!span || (span & (span - 1)) || span % ft_page_size() || span <= hdr)
+		return NULL;
 
+	const size_t cap = (span - hdr) / (obj_size + 1);
+	if (cap == 0)
+		return NULL;
+
+	t_zone* z = (t_zone*)ft_map_aligned(span, span);
+	if (!z)
+		return NULL;
+
+	ft_ll_init(&z->link);
+	z->klass = FT_Z_POOL;
+	z->bin_size = obj_size;
+	z->capacity = cap;
+	z->free_count = cap;
+	z->next_free_hint = 0;
+
+	z->mem_begin = (void*)((uintptr_t)z + hdr);
+	z->mem_end = (void*)((uintptr_t)z->mem_begin + cap * obj_size);
+	z->occ = (uint8_t*)z->mem_end;
+	z->map_end = (void*)((uintptr_t)z + span);
+	z->arena = NULL;
+	FT_PROBE4(zone_new, z, z->klass, z->bin_size, span);
 	return z;
 }
 
@@ -134,7 +239,8 @@ void ft_zone_destroy(t_zone* z)
 {
 	if (!z)
 		return;
-	ft_unmap(z, ft_zone_mapped_bytes(z));
+	FT_PROBE4(zone_destroy, z, z->klass, z->bin_size, ft_zone_mapped_bytes(z));
+	ft_zone_unmap(z->arena, z, ft_zone_mapped_bytes(z));
 }
 
 /* ---------------- slab block ops ---------------- */
@@ -144,14 +250,12 @@ void* ft_zone_alloc_block(t_zone* z)
 	if (!z || z->klass == FT_Z_LARGE || !(z->free_count))
 		return NULL;
 
-	size_t free_blk_idx = ft_zone_find_first_free_block(z);
+	size_t free_blk_idx = ft_slab_take(z->occ, z->capacity, &z->next_free_hint);
 
 	if (free_blk_idx == FT_MALLOC_ERR_SLAB_INDEX(z))
 		return NULL;
 
 	z->free_count--;
-
-	z->occ[free_blk_idx] = FT_OCC_USED;
 	return (void*)((char*)z->mem_begin + free_blk_idx * z->bin_size);
 }
 
@@ -170,13 +274,73 @@ void ft_zone_free_block(t_zone* z, void* p)
 	if (idx >= z->capacity)
 		return;
 
-	if (z->occ[idx] == FT_OCC_USED) {
-		z->occ[idx] = FT_OCC_FREE;
+	if (ft_slab_give(z->occ, idx, &z->next_free_hint))
 		z->free_count++;
-		if (idx < z->next_free_hint)
-			z->next_free_hint = idx;
+}
+
+/* Bytes of the whole pages strictly inside [block i, block j). */
+static size_t ft_zone_run_pages(const t_zone* z, size_t i, size_t j, size_t ps)
+{
+	uintptr_t beg = ft_align_up((uintptr_t)ft_zone_block_at(z, i), ps);
+	uintptr_t end = (uintptr_t)ft_zone_block_at(z, j) / ps * ps;
+	return (end > beg) ? end - beg : 0;
+}
+
+t_zone* ft_zone_large_of(const void* p, size_t align)
+{
+	const size_t hdr = ft_align_up(sizeof(t_zone), (align > FT_ALIGN) ? align : FT_ALIGN);
+
+	if ((uintptr_t)p <= hdr || ((uintptr_t)p - hdr) % ft_page_size())
+		return NULL;
+	t_zone* z = (t_zone*)((uintptr_t)p - hdr);
+	return (z->klass == FT_Z_LARGE && z->mem_begin == p) ? z : NULL;
+}
+
+size_t ft_zone_release_free_pages(t_zone* z)
+{
+	if (!z || z->klass == FT_Z_LARGE || !z->free_count)
+		return 0;
+
+	const size_t ps = ft_page_size();
+	size_t released = 0;
+	size_t i = 0;
+
+	while (i < z->capacity) {
+		if (z->occ[i] == FT_OCC_USED) {
+			++i;
+			continue;
+		}
+		size_t j = i;
+		while (j < z->capacity && z->occ[j] != FT_OCC_USED)
+			++j;
+
+		// pages inside runs of blocks trimmed before are gone already
+		const size_t run = ft_zone_run_pages(z, i, j, ps);
+		size_t bytes = run;
+		for (size_t a = i; a < j;) {
+			size_t b = a;
+			while (b < j && z->occ[b] == z->occ[a])
+				++b;
+			if (z->occ[a] == FT_OCC_TRIMMED)
+				bytes -= ft_zone_run_pages(z, a, b, ps);
+			a = b;
+		}
+		if (bytes) {
+			void* beg = (void*)ft_align_up((uintptr_t)ft_zone_block_at(z, i), ps);
+			int rc = z->arena ? ft_zone_arena_release(beg, run) : madvise(beg, run, MADV_DONTNEED);
+			if (rc != 0) {
+				i = j;
+				continue;
+			}
+		}
+		if (run)
+			ft_memset(&z->occ[i], FT_OCC_TRIMMED, j - i);
+		released += bytes;
+		i = j;
 	}
+	return released;
 }
+
 /* ---------------- helpers ---------------- */
 
 int ft_zone_contains(const t_zone* z, const void* p)
@@ -188,6 +352,34 @@ int ft_zone_contains(const t_zone* z, const void* p)
 	return (a >= (uintptr_t)z->mem_begin) && (a < (uintptr_t)z->mem_end);
 }
 
+int ft_zone_large_resize(t_zone* z, size_t need)
+{
+	if (!z || z->klass != FT_Z_LARGE || need > ft_zone_large_room(z))
+		return -1;
+	z->bin_size = need;
+	z->mem_end = (void*)((uintptr_t)z->mem_begin + need);
+	return 0;
+}
+
+size_t ft_zone_large_trim(t_zone* z, size_t need, size_t min_release)
+{
+	if (!z || z->klass != FT_Z_LARGE || need > z->bin_size)
+		return 0;
+	const size_t ps = ft_page_size();
+	uintptr_t keep = ft_align_up((uintptr_t)z->mem_begin + need, ps);
+	size_t release = (size_t)((uintptr_t)z->map_end - keep);
+	if (release < min_release)
+		return 0;
+
+	z->bin_size = need;
+	z->mem_end = (void*)((uintptr_t)z->mem_begin + need);
+	if (release) {
+		ft_zone_unmap(z->arena, (void*)keep, release);
+		z->map_end = (void*)keep;
+	}
+	return release;
+}
+
 size_t ft_zone_mapped_bytes(const t_zone* z)
 {
 	if (!z)
@@ -200,114 +392,110 @@ int ft_zone_has_space(const t_zone* z)
 	return z && z->free_count > 0;
 }
 
-static size_t ft_zone_find_first_free_block(t_zone* z)
+/* ---------------- slab core ---------------- */
+
+size_t ft_slab_capacity(size_t hdr, size_t bsz, size_t min_blocks, size_t ps, size_t* total)
 {
-	if (!z || z->capacity == 0)
-		return FT_MALLOC_ERR_SLAB_INDEX(z);
+	// each block costs: payload (bsz) + 1 byte in occ[]
+	if (!bsz || min_blocks > (SIZE_MAX - hdr - ps) / (bsz + 1))
+		return 0;
+	*total = ft_align_up(hdr + min_blocks * (bsz + 1), ps);
+	return (*total - hdr) / (bsz + 1);
+}
 
-	size_t i = z->next_free_hint;
-	for (size_t seen = 0; seen < z->capacity; ++seen) {
-		if (z->occ[i] == FT_OCC_FREE) {
+size_t ft_slab_take(uint8_t* occ, size_t capacity, size_t* hint)
+{
+	size_t i = *hint;
+	for (size_t seen = 0; seen < capacity; ++seen) {
+		if (occ[i] != FT_OCC_USED) {
+			occ[i] = FT_OCC_USED;
 			/* advance hint for next call */
-			z->next_free_hint = (i + 1 == z->capacity) ? 0 : i + 1;
+			*hint = (i + 1 == capacity) ? 0 : i + 1;
 			return i;
 		}
 		/* ++i with explicit wrap avoids any addition overflow concerns */
-		if (++i == z->capacity)
+		if (++i == capacity)
 			i = 0;
 	}
-	return FT_MALLOC_ERR_SLAB_INDEX(z);
+	return capacity;
 }
 
-/* find min base (zone pointer) in list; return NULL if empty */
-static const t_zone* find_min_zone(t_ll_node* head)
+int ft_slab_give(uint8_t* occ, size_t i, size_t* hint)
 {
-	const t_zone* minz = NULL;
-	FT_LL_FOR_EACH(it, head)
-	{
-		const t_zone* z = FT_CONTAINER_OF(it, t_zone, link);
-		if (!minz || (uintptr_t)z < (uintptr_t)minz)
-			minz = z;
-	}
-	return minz;
+	if (occ[i] != FT_OCC_USED)
+		return 0;
+	occ[i] = FT_OCC_FREE;
+	if (i < *hint)
+		*hint = i;
+	return 1;
 }
 
-/* find next zone with base > last, among those not yet printed */
-static const t_zone* find_next_zone_after(t_ll_node* head, uintptr_t last)
+static void ft_zone_put_range(t_ft_buf* b, uintptr_t beg, uintptr_t end)
 {
-	const t_zone* best = NULL;
-	FT_LL_FOR_EACH(it, head)
-	{
-		const t_zone* z = FT_CONTAINER_OF(it, t_zone, link);
-		uintptr_t base = (uintptr_t)z;
-		if (base > last && (!best || base < (uintptr_t)best))
-			best = z;
-	}
-	return best;
+	ft_buf_puthex_ptr(b, (const void*)beg);
+	ft_buf_putstr(b, " - ");
+	ft_buf_puthex_ptr(b, (const void*)end);
+	ft_buf_putstr(b, " : ");
+	ft_buf_putusize(b, end - beg);
+	ft_buf_putstr(b, " bytes\n");
 }
 
-size_t ft_zone_ll_show_class(const char* label, t_ll_node* head)
+size_t ft_zone_print_blocks(const t_zone* z)
 {
-	size_t total = 0;
+	t_ft_buf b;
+	ft_buf_init(&b, 1);
+	size_t total = ft_zone_print_blocks_buf(&b, z);
+	ft_buf_flush(&b);
+	return total;
+}
 
-	if (!head) {
-		return 0;
-	}
+size_t ft_zone_print_blocks_buf(t_ft_buf* b, const t_zone* z)
+{
+	return ft_zone_print_ranges_buf(b, z, 0, UINTPTR_MAX, 0);
+}
 
-	const t_zone* first = find_min_zone(head);
-	if (!first)
+/* first block index whose start is >= addr (capacity if none) */
+static size_t ft_zone_first_index_from(const t_zone* z, uintptr_t addr)
+{
+	uintptr_t mb = (uintptr_t)z->mem_begin;
+	if (addr <= mb)
 		return 0;
-
-	ft_putstr(label);
-	ft_putstr(" : ");
-	ft_puthex_ptr(first);
-	ft_putstr("\n");
-
-	uintptr_t last = 0;
-	const t_zone* z = NULL;
-	while ((z = find_next_zone_after(head, last))) {
-		total += ft_zone_print_blocks(z);
-		last = (uintptr_t)z;
-	}
-	return total;
+	size_t i = (size_t)((addr - mb + z->bin_size - 1) / z->bin_size);
+	return (i < z->capacity) ? i : z->capacity;
 }
 
-size_t ft_zone_print_blocks(const t_zone* z)
+size_t ft_zone_print_ranges_buf(
+	t_ft_buf* b, const t_zone* z, uintptr_t lo, uintptr_t hi, int coalesce)
 {
 	if (!z)
 		return 0;
 
-	if (z->klass != FT_Z_LARGE && z->free_count == z->capacity) {
-		return 0;
-	}
-
-	size_t total = 0;
-
+	uintptr_t mb = (uintptr_t)z->mem_begin;
 	if (z->klass == FT_Z_LARGE) {
-
-		void* beg = z->mem_begin;
-		void* end = (void*)((char*)beg + z->bin_size);
-		ft_puthex_ptr(beg);
-		ft_putstr(" - ");
-		ft_puthex_ptr(end);
-		ft_putstr(" : ");
-		ft_putusize(z->bin_size);
-		ft_putstr(" bytes\n");
+		if (mb < lo || mb >= hi)
+			return 0;
+		ft_zone_put_range(b, mb, mb + z->bin_size);
 		return z->bin_size;
 	}
+	if (z->free_count == z->capacity)
+		return 0;
 
-	for (size_t i = 0; i < z->capacity; ++i) {
-		if (z->occ[i] == FT_OCC_USED) {
-			void* beg = (void*)((char*)z->mem_begin + i * z->bin_size);
-			void* end = (void*)((char*)beg + z->bin_size);
-			ft_puthex_ptr(beg);
-			ft_putstr(" - ");
-			ft_puthex_ptr(end);
-			ft_putstr(" : ");
-			ft_putusize(z->bin_size);
-			ft_putstr(" bytes\n");
-			total += z->bin_size;
+	size_t total = 0;
+	size_t end = ft_zone_first_index_from(z, hi);
+	size_t i = ft_zone_first_index_from(z, lo);
+	while (i < end) {
+		if (z->occ[i] != FT_OCC_USED) {
+			++i;
+			continue;
 		}
+		size_t j = i + 1;
+		if (coalesce)
+			while (j < end && z->occ[j] == FT_OCC_USED)
+				++j;
+		uintptr_t beg = mb + i * z->bin_size;
+		ft_zone_put_range(b, beg, mb + j * z->bin_size);
+		total += (j - i) * z->bin_size;
+		i = j;
 	}
 	return total;
 }
@@ -17,13 +17,16 @@
 #include <stdint.h>						 /* uintptr_t, uint8_t */
 #include "data_structures/linked_list.h" /* t_ll_node */
 #include "helpers/helpers.h"
+#include "zone/zone_arena.h"
 
-/* Zone classes: slab for TINY/SMALL, capacity-1 for LARGE */
-typedef enum t_zone_class { FT_Z_TINY, FT_Z_SMALL, FT_Z_LARGE } t_zone_class;
+/* Zone classes: slab for TINY/SMALL, capacity-1 for LARGE.
+ * FT_Z_POOL is an exact-fit slab owned by an object pool (never in heap lists). */
+typedef enum t_zone_class { FT_Z_TINY, FT_Z_SMALL, FT_Z_LARGE, FT_Z_POOL } t_zone_class;
 
 /* Occupancy convention for slab zones */
 #define FT_OCC_FREE 0u // mmap gives zero-filled pages → free by default
 #define FT_OCC_USED 1u
+#define FT_OCC_TRIMMED 2u // free, and the whole pages of its run were already released
 
 #if FT_OCC_FREE != 0
 #error "FT_OCC_FREE must be 0 to leverage mmap zero-fill."
@@ -40,6 +43,7 @@ typedef struct s_zone {
 	size_t capacity;	   /* # of blocks (slab); 1 for LARGE */
 	size_t free_count;	   /* # of free blocks (slab); 0 for LARGE */
 	size_t next_free_hint; /* index to start the next search */
+	size_t grow_moves;	   /* LARGE: reallocs that moved this block to grow it */
 
 	/* ---- mapping & payload bounds (within the same mmap) ---- */
 	void* mem_begin; /* first block/payload byte (aligned to FT_ALIGN) */
@@ -48,14 +52,54 @@ typedef struct s_zone {
 
 	/* ---- slab occupancy (array-of-bytes), unused for LARGE ----
 	Stored INSIDE this mapping, right after the payload region.
-	Length == capacity; values are FT_OCC_FREE or FT_OCC_USED.
+	Length == capacity; values are FT_OCC_FREE, FT_OCC_USED or FT_OCC_TRIMMED.
 	*/
 	uint8_t* occ; /* NULL for LARGE */
+
+	/* ---- where the mapping came from ---- */
+	t_zone_arena* arena; /* NULL: its own mmap */
 } t_zone;
 
 // an index that is not valid for an array of size capacity, used for error returns
 #define FT_MALLOC_ERR_SLAB_INDEX(z) (z->capacity)
 
+/* ---- slab core ----
+ * Geometry, occupancy and class choice of a slab, apart from how its zones
+ * are linked: t_zone lists use pointers, the segment of lib/shm offsets. Both
+ * put their blocks after a header and occ[capacity] right after the blocks. */
+
+/* Blocks of 'bsz' bytes (one occ[] byte each) that fit after a 'hdr'-byte
+ * header in the fewest pages holding min_blocks of them; the mapping size
+ * goes to *total. 0 if none fits. */
+size_t ft_slab_capacity(size_t hdr, size_t bsz, size_t min_blocks, size_t ps, size_t* total);
+
+/* First block not in use from *hint on (wrapping): marked FT_OCC_USED, *hint
+ * moved past it. Returns its index, or capacity if every block is used. */
+size_t ft_slab_take(uint8_t* occ, size_t capacity, size_t* hint);
+
+/* Mark block i free, lowering *hint to it. Returns 1, or 0 if it was not in
+ * use (double free): nothing changes then. */
+int ft_slab_give(uint8_t* occ, size_t i, size_t* hint);
+
+/* True if p is within the 'capacity' blocks of 'bsz' bytes from 'begin'. */
+static inline int ft_slab_holds(const void* begin, size_t bsz, size_t capacity, const void* p)
+{
+	return (uintptr_t)p >= (uintptr_t)begin &&
+		   (uintptr_t)p - (uintptr_t)begin < (uintptr_t)(capacity * bsz);
+}
+
+/* Class serving an n-byte request with these slab bins. */
+static inline t_zone_class ft_zone_class_for(size_t n, size_t tiny_bin, size_t small_bin)
+{
+	if (n == 0)
+		n = 1;
+	if (n <= tiny_bin)
+		return FT_Z_TINY;
+	if (n <= small_bin)
+		return FT_Z_SMALL;
+	return FT_Z_LARGE;
+}
+
 /* --- zone lifecycle (no list management here) --- */
 
 /* Unified constructor:
@@ -66,6 +110,13 @@ typedef struct s_zone {
  */
 t_zone* ft_zone_new(t_zone_class klass, size_t bin_size, size_t min_blocks);
 
+/* Same, with payload blocks aligned to 'align' (power of two, >= FT_ALIGN):
+ * slab bin_size is rounded up to a multiple of align (align <= page size);
+ * a LARGE payload may have any alignment. The zone is carved from 'arena'
+ * when not NULL (and given back to it when destroyed or trimmed). */
+t_zone* ft_zone_new_aligned(
+	t_zone_class klass, size_t bin_size, size_t align, size_t min_blocks, t_zone_arena* arena);
+
 /* Convenience wrappers (optional, keep for clarity) */
 static inline t_zone* t_zone_new_slab(t_zone_class k, size_t bin_size, size_t min_blocks)
 {
@@ -76,7 +127,37 @@ static inline t_zone* t_zone_new_large(size_t req_bytes)
 	return ft_zone_new(FT_Z_LARGE, req_bytes, 1);
 }
 
-/* Destroy the whole zone (munmap). */
+/* LARGE zone whose mapping has room for a payload of 'room' bytes (at least
+ * bin_size): the block can later grow in place up to that. */
+t_zone* ft_zone_new_large_room(size_t bin_size, size_t room, t_zone_arena* arena);
+
+/* Payload bytes a LARGE zone can hold without a new mapping. */
+static inline size_t ft_zone_large_room(const t_zone* z)
+{
+	return (size_t)((uintptr_t)z->map_end - (uintptr_t)z->mem_begin);
+}
+
+/* Set the payload size of a LARGE zone (need a multiple of FT_ALIGN), within
+ * its room. Returns 0, or -1 if it does not fit. */
+int ft_zone_large_resize(t_zone* z, size_t need);
+
+/* Shrink a LARGE payload to 'need' bytes (<= bin_size, multiple of FT_ALIGN)
+ * and unmap the whole pages past it, if they add up to min_release bytes at
+ * least; otherwise nothing changes. Returns the bytes unmapped. */
+size_t ft_zone_large_trim(t_zone* z, size_t need, size_t min_release);
+
+/* Pool slab: blocks of exactly obj_size bytes (obj_size must be a multiple of
+ * align, align a power of two <= FT_ALIGN). The mapping is 'span' bytes long
+ * and starts at a multiple of 'span' (a power of two), so the zone owning a
+ * block is recovered by masking: see ft_zone_of_pool_block(). */
+t_zone* ft_zone_new_pool(size_t obj_size, size_t align, size_t span);
+
+static inline t_zone* ft_zone_of_pool_block(const void* p, size_t span)
+{
+	return (t_zone*)((uintptr_t)p & ~(uintptr_t)(span - 1));
+}
+
+/* Destroy the whole zone (munmap, or back to its arena). */
 void ft_zone_destroy(t_zone* z);
 
 /* --- slab block ops (no heap/container logic) --- */
@@ -90,11 +171,26 @@ void* ft_zone_alloc_block(t_zone* z);
  * Undefined for LARGE. */
 void ft_zone_free_block(t_zone* z, void* p);
 
+/* Release the pages fully covered by runs of free blocks back to the OS
+ * (madvise MADV_DONTNEED; for a zone of an arena, ft_zone_arena_release(), and
+ * nothing is released if its mapping does not allow it). The mapping, header
+ * and occ[] are left intact.
+ * Blocks of a released run are marked FT_OCC_TRIMMED until handed out again,
+ * so a later call only counts pages it has not released before.
+ * Returns the number of bytes newly released; 0 for LARGE or full slabs. */
+size_t ft_zone_release_free_pages(t_zone* z);
+
 /* --- helpers --- */
 
 /* True if p is within [mem_begin, mem_end) of this zone (payload region). */
 int ft_zone_contains(const t_zone* z, const void* p);
 
+/* The LARGE zone whose payload starts at p, found from p alone: its header
+ * sits at the page-aligned start of the same mapping. 'align' is the alignment
+ * p was allocated with (0 = FT_ALIGN). NULL if the header there does not
+ * describe p; p must be a block of some zone (the header page is read). */
+t_zone* ft_zone_large_of(const void* p, size_t align);
+
 /* Total bytes mapped for this zone (header + metadata + payload). */
 size_t ft_zone_mapped_bytes(const t_zone* z);
 
@@ -119,6 +215,15 @@ size_t ft_zone_print_blocks(const t_zone* z);
  * Returns total bytes accounted for this zone.
  */
 
+/* Same, appended to 'b' instead of written to stdout right away. */
+size_t ft_zone_print_blocks_buf(t_ft_buf* b, const t_zone* z);
+
+/* Print the used blocks that start in [lo, hi). With 'coalesce', a run of
+ * adjacent used blocks is printed as one "begin - end : bytes" line.
+ * Returns the bytes printed. */
+size_t ft_zone_print_ranges_buf(
+	t_ft_buf* b, const t_zone* z, uintptr_t lo, uintptr_t hi, int coalesce);
+
 /* Recover zone pointer from intrusive list node. */
 inline struct s_zone* ft_zone_from_link(t_ll_node* n)
 {
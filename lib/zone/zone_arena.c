@@ -0,0 +1,140 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   zone_arena.c                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/19 18:05:44 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/19 18:05:44 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "zone/zone_arena.h"
+#include "helpers/helpers.h"
+
+#include <sys/mman.h>
+
+/* offset <-> address, modulo 2^64: the region may sit below the arena */
+#define FT_ARENA_AT(a, off) ((uintptr_t)(a) + (uintptr_t)(off))
+#define FT_ARENA_OFF(a, p) ((uint64_t)((uintptr_t)(p) - (uintptr_t)(a)))
+
+void ft_zone_arena_init(t_zone_arena* a, void* base, size_t size)
+{
+	a->begin = FT_ARENA_OFF(a, base);
+	a->size = size - size % ft_page_size();
+	a->brk = 0;
+	a->fresh = 0;
+	a->runs = 0;
+}
+
+int ft_zone_arena_release(void* p, size_t bytes)
+{
+#ifdef MADV_REMOVE
+	return madvise(p, bytes, MADV_REMOVE);
+#else
+	(void)p;
+	(void)bytes;
+	return -1;
+#endif
+}
+
+/* Zero pages handed out before: released if the mapping allows it, written
+ * over otherwise. */
+static void ft_arena_zero(uintptr_t p, size_t bytes)
+{
+	if (ft_zone_arena_release((void*)p, bytes) != 0)
+		ft_memset((void*)p, 0, bytes);
+}
+
+/* Insert a run in address order, merged with the runs it touches; a run that
+ * ends at brk is folded into it. */
+static void ft_arena_insert(t_zone_arena* a, uintptr_t p, size_t bytes)
+{
+	uint64_t* link = &a->runs;
+	t_arena_run* prev = NULL;
+
+	while (*link && FT_ARENA_AT(a, *link) < p) {
+		prev = ft_zone_arena_run(a, *link);
+		link = &prev->next;
+	}
+	t_arena_run* next = ft_zone_arena_run(a, *link);
+	if (prev && (uintptr_t)prev + prev->size == p) {
+		prev->size += bytes;
+	} else {
+		t_arena_run* r = (t_arena_run*)p;
+		r->size = bytes;
+		r->next = *link;
+		*link = FT_ARENA_OFF(a, r);
+		prev = r;
+	}
+	if (next && (uintptr_t)prev + prev->size == (uintptr_t)next) {
+		prev->size += next->size;
+		prev->next = next->next;
+	}
+	if (!prev->next && (uintptr_t)prev + prev->size == FT_ARENA_AT(a, a->begin) + a->brk) {
+		a->brk -= prev->size;
+		for (link = &a->runs; ft_zone_arena_run(a, *link) != prev;
+			 link = &ft_zone_arena_run(a, *link)->next)
+			;
+		*link = 0;
+	}
+}
+
+void* ft_zone_arena_take(t_zone_arena* a, size_t bytes, size_t align)
+{
+	const size_t ps = ft_page_size();
+
+	if (!bytes || bytes > SIZE_MAX - ps)
+		return NULL;
+	bytes = ft_align_up(bytes, ps);
+	if (align < ps)
+		align = ps;
+
+	for (uint64_t* link = &a->runs; *link; link = &ft_zone_arena_run(a, *link)->next) {
+		t_arena_run* r = ft_zone_arena_run(a, *link);
+		uintptr_t begin = (uintptr_t)r;
+		uintptr_t end = begin + r->size;
+		uintptr_t start = ft_align_up(begin, align);
+		if (start < begin || start > end || end - start < bytes)
+			continue;
+		*link = r->next;
+		if (start > begin)
+			ft_arena_insert(a, begin, start - begin);
+		if (end > start + bytes)
+			ft_arena_insert(a, start + bytes, end - (start + bytes));
+		ft_arena_zero(start, bytes);
+		return (void*)start;
+	}
+
+	const uintptr_t base = FT_ARENA_AT(a, a->begin);
+	uintptr_t top = base + a->brk;
+	uintptr_t start = ft_align_up(top, align);
+	if (start < top || start - base > a->size || a->size - (start - base) < bytes)
+		return NULL;
+	a->brk = start + bytes - base;
+	if (start > top)
+		ft_arena_insert(a, top, start - top);
+	if (start < base + a->fresh) { /* below the high-water mark: used before */
+		size_t used = base + a->fresh - start;
+		ft_arena_zero(start, used < bytes ? used : bytes);
+	}
+	if (a->brk > a->fresh)
+		a->fresh = a->brk;
+	return (void*)start;
+}
+
+void ft_zone_arena_give(t_zone_arena* a, void* p, size_t bytes)
+{
+	if (!p || !bytes)
+		return;
+	ft_arena_insert(a, (uintptr_t)p, ft_align_up(bytes, ft_page_size()));
+}
+
+size_t ft_zone_arena_used(const t_zone_arena* a)
+{
+	size_t used = a->brk;
+	for (const t_arena_run* r = ft_zone_arena_run(a, a->runs); r; r = ft_zone_arena_run(a, r->next))
+		used -= r->size;
+	return used;
+}
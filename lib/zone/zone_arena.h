@@ -0,0 +1,69 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   zone_arena.h                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: frthierr <frthierr@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/10/19 18:05:44 by frthierr          #+#    #+#             */
+/*   Updated: 2025/10/19 18:05:44 by frthierr         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef FT_ZONE_ARENA_H
+#define FT_ZONE_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Page allocator over one region mapped by someone else (a heap file, a
+ * shared memory segment): zones created with an arena take their mapping
+ * from it instead of mmap, and give it back instead of munmap.
+ * - the region is handed out from the bottom ('brk'); given back runs are kept
+ *   in an address-ordered list stored in the runs themselves, coalesced with
+ *   their neighbours, and a run ending at brk lowers it;
+ * - memory taken is always zero-filled, as fresh anonymous mappings are:
+ *   slabs rely on it for their occupancy bytes;
+ * - positions are offsets from the arena struct itself, which lives in the
+ *   same mapping as the region: the arena works wherever that mapping is,
+ *   even at a different address in each process sharing it.
+ * Not locked: the owner's lock covers it. */
+
+typedef struct s_arena_run {
+	size_t size;   /* bytes, a multiple of the page size */
+	uint64_t next; /* next run, offset from the arena; 0: none */
+} t_arena_run;
+
+typedef struct s_zone_arena {
+	uint64_t begin; /* first managed byte (page aligned), offset from the arena */
+	size_t size;	/* bytes managed */
+	size_t brk;		/* bytes handed out from begin so far */
+	size_t fresh;	/* highest brk ever: pages above were never touched */
+	uint64_t runs;	/* first given back run, offset from the arena; 0: none */
+} t_zone_arena;
+
+void ft_zone_arena_init(t_zone_arena* a, void* base, size_t size);
+
+/* 'bytes' (rounded up to pages) at a multiple of 'align' (a power of two, at
+ * least the page size), zero-filled; NULL if the region is full. */
+void* ft_zone_arena_take(t_zone_arena* a, size_t bytes, size_t align);
+
+/* Give back [p, p + bytes) (page aligned, from ft_zone_arena_take()). */
+void ft_zone_arena_give(t_zone_arena* a, void* p, size_t bytes);
+
+/* Free the memory behind [p, p + bytes) (page aligned, in the region), which
+ * then reads back as zeros: MADV_REMOVE punches a hole in the file or shared
+ * memory behind the mapping, where MADV_DONTNEED would free nothing. Returns
+ * 0, or -1 if the mapping does not allow it (nothing changed then). */
+int ft_zone_arena_release(void* p, size_t bytes);
+
+/* Bytes currently handed out (brk minus the runs below it). */
+size_t ft_zone_arena_used(const t_zone_arena* a);
+
+/* Address of the run at offset 'off' (0: NULL). */
+static inline t_arena_run* ft_zone_arena_run(const t_zone_arena* a, uint64_t off)
+{
+	return off ? (t_arena_run*)((uintptr_t)a + (uintptr_t)off) : NULL;
+}
+
+#endif /* FT_ZONE_ARENA_H */
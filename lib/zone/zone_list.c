@@ -47,57 +47,170 @@ t_zone* ft_zone_ll_first_with_space(t_ll_node* head)
 	return NULL;
 }
 
-/* find the zone with the smallest mem_begin strictly greater than 'after' */
-static t_zone* min_zone_after(t_ll_node* head, const void* after)
+t_zone* ft_zone_ll_first_with_space_aligned(t_ll_node* head, size_t align)
 {
-	t_zone* best = NULL;
-	uintptr_t cutoff = (uintptr_t)after;
-
 	FT_LL_FOR_EACH(it, head)
 	{
 		t_zone* z = FT_CONTAINER_OF(it, t_zone, link);
-		uintptr_t mb = (uintptr_t)z->mem_begin;
-		if (mb > cutoff && (!best || mb < (uintptr_t)best->mem_begin))
-			best = z;
+		if (ft_zone_has_space(z) && (uintptr_t)z->mem_begin % align == 0 &&
+			z->bin_size % align == 0)
+			return z;
 	}
-	return best;
+	return NULL;
 }
 
-size_t ft_zone_ll_print_sorted(const char* label, t_ll_node* head)
+/* ---------------- sorted views ---------------- */
+
+static void ft_zone_sift_down(t_zone** v, size_t root, size_t n)
 {
-	if (!head)
+	for (;;) {
+		size_t child = 2 * root + 1;
+		if (child >= n)
+			return;
+		if (child + 1 < n && (uintptr_t)v[child + 1] > (uintptr_t)v[child])
+			++child;
+		if ((uintptr_t)v[root] >= (uintptr_t)v[child])
+			return;
+		t_zone* tmp = v[root];
+		v[root] = v[child];
+		v[child] = tmp;
+		root = child;
+	}
+}
+
+/* in-place heap sort by zone address: O(n log n), no allocation */
+static void ft_zone_sort(t_zone** v, size_t n)
+{
+	for (size_t i = n / 2; i-- > 0;)
+		ft_zone_sift_down(v, i, n);
+	for (size_t end = n; end-- > 1;) {
+		t_zone* tmp = v[0];
+		v[0] = v[end];
+		v[end] = tmp;
+		ft_zone_sift_down(v, 0, end);
+	}
+}
+
+size_t ft_zone_ll_sorted(t_ll_node* head, t_zone*** out)
+{
+	*out = NULL;
+	size_t n = ft_ll_len(&head);
+	if (n == 0)
+		return 0;
+
+	t_zone** v = (t_zone**)ft_scratch_map(n * sizeof(*v));
+	if (!v)
+		return 0;
+	size_t i = 0;
+	FT_LL_FOR_EACH(it, head)
+	{
+		v[i++] = FT_CONTAINER_OF(it, t_zone, link);
+	}
+	ft_zone_sort(v, n);
+	*out = v;
+	return n;
+}
+
+void ft_zone_ll_sorted_release(t_zone** v, size_t n)
+{
+	ft_scratch_unmap(v, n * sizeof(*v));
+}
+
+/* ---------------- printing ---------------- */
+
+static int ft_zone_passes(const t_zone* z, const t_zone_filter* f)
+{
+	if (z->bin_size < f->min_size)
+		return 0;
+	uintptr_t mb = (uintptr_t)z->mem_begin;
+	uintptr_t me = (uintptr_t)z->mem_end;
+	return mb < f->hi && me > f->lo;
+}
+
+static size_t ft_zone_show_one(t_ft_buf* b, const char* label, const t_zone* z,
+							   const t_zone_filter* f, int* header)
+{
+	if (!ft_zone_passes(z, f))
 		return 0;
+	if (!*header) {
+		ft_buf_putstr(b, label);
+		ft_buf_putstr(b, " : ");
+		ft_buf_puthex_ptr(b, z);
+		ft_buf_putstr(b, "\n");
+		*header = 1;
+	}
+	return ft_zone_print_ranges_buf(b, z, f->lo, f->hi, f->coalesce);
+}
 
+size_t ft_zone_ll_show_filtered(t_ft_buf* b, const char* label, t_ll_node* head,
+								const t_zone_filter* f)
+{
+	t_zone** v;
+	size_t n = ft_zone_ll_sorted(head, &v);
 	size_t total = 0;
-	size_t nz = ft_ll_len(&head);
-	const void* last = (const void*)0; /* -∞ for our purposes */
+	int header = 0;
+
+	if (v) {
+		for (size_t i = 0; i < n; ++i)
+			total += ft_zone_show_one(b, label, v[i], f, &header);
+		ft_zone_ll_sorted_release(v, n);
+		return total;
+	}
+	/* no scratch memory for the sort: list order is still a complete dump */
+	FT_LL_FOR_EACH(it, head)
+	{
+		total += ft_zone_show_one(b, label, FT_CONTAINER_OF(it, t_zone, link), f, &header);
+	}
+	return total;
+}
+
+size_t ft_zone_ll_show_class_buf(t_ft_buf* b, const char* label, t_ll_node* head)
+{
+	const t_zone_filter all = {0, UINTPTR_MAX, 0, 0};
+	return ft_zone_ll_show_filtered(b, label, head, &all);
+}
+
+size_t ft_zone_ll_show_class(const char* label, t_ll_node* head)
+{
+	t_ft_buf b;
+	ft_buf_init(&b, 1);
+	size_t total = ft_zone_ll_show_class_buf(&b, label, head);
+	ft_buf_flush(&b);
+	return total;
+}
+
+size_t ft_zone_ll_print_sorted(const char* label, t_ll_node* head)
+{
+	t_zone** v;
+	size_t n = ft_zone_ll_sorted(head, &v);
+	if (!v)
+		return 0;
 
-	for (size_t i = 0; i < nz; ++i) {
-		t_zone* z = min_zone_after(head, last);
-		if (!z)
-			break;
+	t_ft_buf b;
+	ft_buf_init(&b, 1);
+	size_t total = 0;
+	for (size_t i = 0; i < n; ++i) {
+		const t_zone* z = v[i];
 
 		/* header line for this zone */
 		if (label) {
-			ft_putstr(label);
-			ft_putstr(" : ");
+			ft_buf_putstr(&b, label);
+			ft_buf_putstr(&b, " : ");
 		}
-		ft_puthex_ptr(z->mem_begin);
-		ft_putstr("\n");
-
-		// in ft_zone_ll_print_sorted, right before ft_zone_print_blocks(z)
-		ft_putstr("  [cap=");
-		ft_putusize(z->capacity);
-		ft_putstr(" free=");
-		ft_putusize(z->free_count);
-		ft_putstr(" bin=");
-		ft_putusize(z->bin_size);
-		ft_putstr("]\n");
-
-		/* zone-level printing (your function) */
-		total += ft_zone_print_blocks(z);
-
-		last = z->mem_begin;
+		ft_buf_puthex_ptr(&b, z->mem_begin);
+		ft_buf_putstr(&b, "\n");
+
+		ft_buf_putstr(&b, "  [cap=");
+		ft_buf_putusize(&b, z->capacity);
+		ft_buf_putstr(&b, " free=");
+		ft_buf_putusize(&b, z->free_count);
+		ft_buf_putstr(&b, " bin=");
+		ft_buf_putusize(&b, z->bin_size);
+		ft_buf_putstr(&b, "]\n");
+
+		total += ft_zone_print_blocks_buf(&b, z);
 	}
+	ft_buf_flush(&b);
+	ft_zone_ll_sorted_release(v, n);
 	return total;
-}
\ No newline at end of file
+}
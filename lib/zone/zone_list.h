@@ -28,6 +28,31 @@ t_zone* ft_zone_ll_find_container_of(t_ll_node* head, const void* p);
 /* Return the first zone in list that currently has space (calls ft_zone_has_space). */
 t_zone* ft_zone_ll_first_with_space(t_ll_node* head);
 
+/* Same, restricted to zones whose blocks all start on an 'align' boundary. */
+t_zone* ft_zone_ll_first_with_space_aligned(t_ll_node* head, size_t align);
+
+/* Snapshot the zones of a list into a scratch mapping, sorted by address
+ * (one O(n log n) sort instead of a scan per zone). Returns the count; *out is
+ * NULL when the list is empty or no scratch memory could be mapped.
+ * Give the array back with ft_zone_ll_sorted_release(). */
+size_t ft_zone_ll_sorted(t_ll_node* head, t_zone*** out);
+void ft_zone_ll_sorted_release(t_zone** v, size_t n);
+
+/* What ft_zone_ll_show_filtered() prints: zones whose blocks are at least
+ * min_size bytes, and within them the used blocks starting in [lo, hi). */
+typedef struct s_zone_filter {
+	uintptr_t lo;
+	uintptr_t hi;
+	size_t min_size;
+	int coalesce; /* print runs of adjacent used blocks as one range */
+} t_zone_filter;
+
+/* Buffered, filtered ft_zone_ll_show_class(). The class header names the
+ * first zone that passes the filter and is omitted when none does. */
+size_t ft_zone_ll_show_filtered(t_ft_buf* b, const char* label, t_ll_node* head,
+								const t_zone_filter* f);
+size_t ft_zone_ll_show_class_buf(t_ft_buf* b, const char* label, t_ll_node* head);
+
 /* Print a class header and all zones' blocks in ascending zone-base order.
  * Header format: "<LABEL> : 0x<min-zone-base>\n"
  * Returns total bytes printed for this class.
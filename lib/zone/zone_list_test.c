@@ -332,6 +332,94 @@ static MunitResult test_print_sorted_large(const MunitParameter params[], void*
 	return MUNIT_OK;
 }
 
+static MunitResult test_sorted_many(const MunitParameter params[], void* user_data)
+{
+	(void)params;
+	(void)user_data;
+
+	enum { NZ = 64 };
+	t_zone* zs[NZ];
+	t_ll_node* head = NULL;
+	for (int i = 0; i < NZ; ++i) {
+		zs[i] = ft_zone_new(FT_Z_TINY, 16, 8);
+		munit_assert_not_null(zs[i]);
+		/* alternate ends so the list is far from address order */
+		if (i % 2)
+			ft_ll_push_front(&head, &zs[i]->link);
+		else
+			ft_ll_push_back(&head, &zs[i]->link);
+	}
+
+	t_zone** v;
+	size_t n = ft_zone_ll_sorted(head, &v);
+	munit_assert_size(n, ==, NZ);
+	munit_assert_not_null(v);
+	for (size_t i = 1; i < n; ++i)
+		munit_assert_true((uintptr_t)v[i - 1] < (uintptr_t)v[i]);
+	ft_zone_ll_sorted_release(v, n);
+
+	ft_zone_ll_destroy(&head);
+	return MUNIT_OK;
+}
+
+static t_zone_filter g_filter;
+
+static size_t show_filtered_stdout(const char* label, t_ll_node* head)
+{
+	t_ft_buf b;
+	ft_buf_init(&b, STDOUT_FILENO);
+	size_t total = ft_zone_ll_show_filtered(&b, label, head, &g_filter);
+	ft_buf_flush(&b);
+	return total;
+}
+
+static MunitResult test_show_filtered_coalesces(const MunitParameter params[], void* user_data)
+{
+	(void)params;
+	(void)user_data;
+
+	t_zone* z = ft_zone_new(FT_Z_TINY, 16, 8);
+	munit_assert_not_null(z);
+	void* b[5];
+	for (int i = 0; i < 5; ++i)
+		b[i] = ft_zone_alloc_block(z);
+	ft_zone_free_block(z, b[3]); /* used: 0 1 2 _ 4 */
+
+	t_ll_node* head = NULL;
+	ft_ll_push_front(&head, &z->link);
+
+	char run[96], single[96];
+	size_t outlen = 0;
+
+	g_filter = (t_zone_filter){0, UINTPTR_MAX, 0, 1};
+	char* out = capture_call_size(&outlen, show_filtered_stdout, "TINY", head);
+	munit_assert_not_null(out);
+	snprintf(run, sizeof run, "%p - %p : 48 bytes\n", b[0], (char*)b[2] + 16);
+	snprintf(single, sizeof single, "%p - %p : 16 bytes\n", b[4], (char*)b[4] + 16);
+	munit_assert_ptr_not_null(strstr(out, run));
+	munit_assert_ptr_not_null(strstr(out, single));
+	free(out);
+
+	/* address window [b1, b4): blocks 1 and 2 only */
+	g_filter = (t_zone_filter){(uintptr_t)b[1], (uintptr_t)b[4], 0, 1};
+	out = capture_call_size(&outlen, show_filtered_stdout, "TINY", head);
+	munit_assert_not_null(out);
+	snprintf(run, sizeof run, "%p - %p : 32 bytes\n", b[1], (char*)b[2] + 16);
+	munit_assert_ptr_not_null(strstr(out, run));
+	munit_assert_ptr_null(strstr(out, " : 16 bytes"));
+	free(out);
+
+	/* min_size above the bin drops the zone, header included */
+	g_filter = (t_zone_filter){0, UINTPTR_MAX, 32, 1};
+	out = capture_call_size(&outlen, show_filtered_stdout, "TINY", head);
+	munit_assert_not_null(out);
+	munit_assert_size(outlen, ==, 0);
+	free(out);
+
+	ft_zone_ll_destroy(&head);
+	return MUNIT_OK;
+}
+
 /* ---------------- registry ---------------- */
 
 static MunitTest tests[] = {
@@ -382,6 +470,18 @@ static MunitTest tests[] = {
 	 NULL,
 	 MUNIT_TEST_OPTION_NONE,
 	 NULL},
+	{"/zone_list/sorted_many",
+	 test_sorted_many,
+	 NULL,
+	 NULL,
+	 MUNIT_TEST_OPTION_NONE,
+	 NULL},
+	{"/zone_list/show_filtered_coalesces",
+	 test_show_filtered_coalesces,
+	 NULL,
+	 NULL,
+	 MUNIT_TEST_OPTION_NONE,
+	 NULL},
 	{"/zone_list/print_sorted_large",
 	 test_print_sorted_large,
 	 NULL,
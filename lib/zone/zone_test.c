@@ -15,6 +15,9 @@
 #include "munit.h"
 
 #include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #define ALIGN_OK(p, a) (((uintptr_t)(p)) % (a) == 0)
 
@@ -184,6 +187,18 @@ static MunitResult test_large_zone_layout(const MunitParameter params[], void* d
 	munit_assert_true(ft_zone_contains(z, z->mem_begin));
 	munit_assert_false(ft_zone_contains(z, z->mem_end));
 
+	/* the header is found back from the payload, with the alignment used */
+	munit_assert_ptr_equal(ft_zone_large_of(z->mem_begin, 0), z);
+	t_zone* a = ft_zone_new_aligned(FT_Z_LARGE, req, 8192, 1, NULL);
+	munit_assert_ptr_not_null(a);
+	munit_assert_ptr_equal(ft_zone_large_of(a->mem_begin, 8192), a);
+	munit_assert_ptr_null(ft_zone_large_of(a->mem_begin, 0));
+	t_zone* s = ft_zone_new(FT_Z_SMALL, 1024, 8);
+	munit_assert_ptr_not_null(s);
+	munit_assert_ptr_null(ft_zone_large_of(ft_zone_alloc_block(s), 0));
+
+	ft_zone_destroy(s);
+	ft_zone_destroy(a);
 	ft_zone_destroy(z);
 	return MUNIT_OK;
 }
@@ -226,6 +241,46 @@ static MunitResult test_free_ignores_outside_ptrs(const MunitParameter params[],
 	return MUNIT_OK;
 }
 
+static MunitResult test_release_free_pages(const MunitParameter params[], void* data)
+{
+	(void)params;
+	(void)data;
+
+	const size_t ps = ft_page_size();
+	t_zone* z = ft_zone_new(FT_Z_SMALL, 1024, 64);
+	munit_assert_ptr_not_null(z);
+
+	/* full slab: nothing to release */
+	size_t cap = z->capacity;
+	for (size_t i = 0; i < cap; ++i)
+		memset(ft_zone_alloc_block(z), 0xAB, z->bin_size);
+	munit_assert_size(ft_zone_release_free_pages(z), ==, 0);
+
+	/* free a run in the middle: at least one whole page inside it goes away */
+	const size_t lo = 4, hi = cap - 4;
+	for (size_t i = lo; i < hi; ++i)
+		ft_zone_free_block(z, ft_zone_block_at(z, i));
+
+	size_t released = ft_zone_release_free_pages(z);
+	munit_assert_size(released, >, 0);
+	munit_assert_size(released % ps, ==, 0);
+	munit_assert_size(released, <=, (hi - lo) * z->bin_size);
+
+	/* released pages are not released (nor counted) again */
+	munit_assert_size(ft_zone_release_free_pages(z), ==, 0);
+
+	/* neighbours and metadata are untouched, released blocks are reusable */
+	munit_assert_uint8(((uint8_t*)ft_zone_block_at(z, lo - 1))[z->bin_size - 1], ==, 0xAB);
+	munit_assert_uint8(((uint8_t*)ft_zone_block_at(z, hi))[0], ==, 0xAB);
+	munit_assert_size(z->free_count, ==, hi - lo);
+	for (size_t i = lo; i < hi; ++i)
+		memset(ft_zone_alloc_block(z), 0xCD, z->bin_size);
+	munit_assert_size(z->free_count, ==, 0);
+
+	ft_zone_destroy(z);
+	return MUNIT_OK;
+}
+
 /* capture stdout into heap buffer; returns malloc'd string the test must free */
 static char* cap_stdout(void (*fn)(void*), void* arg)
 {
@@ -315,6 +370,122 @@ static MunitResult test_zone_print_large(const MunitParameter params[], void* us
 	return MUNIT_OK;
 }
 
+static MunitResult test_arena_take_give(const MunitParameter params[], void* user_data)
+{
+	(void)params;
+	(void)user_data;
+
+	const size_t ps = ft_page_size();
+	const size_t span = 64 * ps;
+	char* region = mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	munit_assert_ptr_not_equal(region, MAP_FAILED);
+	t_zone_arena a;
+	ft_zone_arena_init(&a, region, span);
+
+	char* p1 = ft_zone_arena_take(&a, 1, ps);
+	char* p2 = ft_zone_arena_take(&a, 2 * ps, ps);
+	char* p3 = ft_zone_arena_take(&a, ps, ps);
+	munit_assert_ptr_equal(p1, region);
+	munit_assert_ptr_equal(p2, region + ps);
+	munit_assert_ptr_equal(p3, region + 3 * ps);
+	munit_assert_size(ft_zone_arena_used(&a), ==, 4 * ps);
+
+	/* runs merge, and the first fit is reused zero-filled */
+	memset(p2, 0xab, 2 * ps);
+	ft_zone_arena_give(&a, p2, 2 * ps);
+	ft_zone_arena_give(&a, p1, ps);
+	const t_arena_run* r = ft_zone_arena_run(&a, a.runs);
+	munit_assert_not_null(r);
+	munit_assert_ptr_equal(r, region);
+	munit_assert_size(r->size, ==, 3 * ps);
+	munit_assert_uint64(r->next, ==, 0);
+	char* p4 = ft_zone_arena_take(&a, 2 * ps, ps);
+	munit_assert_ptr_equal(p4, region);
+	for (size_t i = 0; i < 2 * ps; ++i)
+		munit_assert_char(p4[i], ==, 0);
+
+	/* an aligned take skips to the next boundary; a run at the top lowers brk */
+	char* p5 = ft_zone_arena_take(&a, ps, 16 * ps);
+	munit_assert_size((uintptr_t)p5 % (16 * ps), ==, 0);
+	ft_zone_arena_give(&a, p5, ps);
+	munit_assert_size(a.brk, ==, 4 * ps);
+	munit_assert_null(ft_zone_arena_take(&a, span, ps));
+
+	/* zones carved from the arena go back to it */
+	t_zone* z = ft_zone_new_aligned(FT_Z_SMALL, 512, FT_ALIGN, 8, &a);
+	munit_assert_not_null(z);
+	munit_assert_ptr_equal(z->arena, &a);
+	munit_assert_size((uintptr_t)z - (uintptr_t)region, <, span);
+	munit_assert_size(z->free_count, ==, z->capacity);
+	ft_zone_destroy(z);
+	ft_zone_arena_give(&a, p4, 2 * ps);
+	ft_zone_arena_give(&a, p3, ps);
+	munit_assert_size(ft_zone_arena_used(&a), ==, 0);
+	munit_assert_size(a.brk, ==, 0);
+
+	munmap(region, span);
+	return MUNIT_OK;
+}
+
+/* free slab pages of a zone in a shared arena are punched out of the file;
+ * a private mapping cannot, and nothing is counted then */
+static MunitResult test_arena_release_free_pages(const MunitParameter params[], void* user_data)
+{
+	(void)params;
+	(void)user_data;
+
+	const size_t ps = ft_page_size();
+	const size_t span = 64 * ps;
+	int fd = memfd_create("zone_test", MFD_CLOEXEC);
+	munit_assert_int(fd, >=, 0);
+	munit_assert_int(ftruncate(fd, (off_t)span), ==, 0);
+	char* region = mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	munit_assert_ptr_not_equal(region, MAP_FAILED);
+	t_zone_arena a;
+	ft_zone_arena_init(&a, region, span);
+
+	t_zone* z = ft_zone_new_aligned(FT_Z_SMALL, 1024, FT_ALIGN, 32, &a);
+	munit_assert_not_null(z);
+	const size_t cap = z->capacity;
+	for (size_t i = 0; i < cap; ++i)
+		memset(ft_zone_alloc_block(z), 0xAB, z->bin_size);
+	struct stat before;
+	munit_assert_int(fstat(fd, &before), ==, 0);
+	for (size_t i = 1; i < cap - 1; ++i)
+		ft_zone_free_block(z, ft_zone_block_at(z, i));
+
+	size_t released = ft_zone_release_free_pages(z);
+#ifdef MADV_REMOVE
+	struct stat after;
+	munit_assert_size(released, >, 0);
+	munit_assert_int(fstat(fd, &after), ==, 0);
+	munit_assert_llong((long long)after.st_blocks * 512, <=,
+					   (long long)before.st_blocks * 512 - (long long)released);
+	const uint8_t* mid = ft_zone_block_at(z, cap / 2);
+	for (size_t i = 0; i < z->bin_size; ++i)
+		munit_assert_uint8(mid[i], ==, 0);
+#endif
+	munit_assert_size(ft_zone_release_free_pages(z), ==, 0);
+	ft_zone_destroy(z);
+	munmap(region, span);
+	close(fd);
+
+	region = mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	munit_assert_ptr_not_equal(region, MAP_FAILED);
+	ft_zone_arena_init(&a, region, span);
+	z = ft_zone_new_aligned(FT_Z_SMALL, 1024, FT_ALIGN, 32, &a);
+	munit_assert_not_null(z);
+	for (size_t i = 0; i < cap; ++i)
+		memset(ft_zone_alloc_block(z), 0xAB, z->bin_size);
+	for (size_t i = 1; i < cap - 1; ++i)
+		ft_zone_free_block(z, ft_zone_block_at(z, i));
+	munit_assert_size(ft_zone_release_free_pages(z), ==, 0);
+	munit_assert_uint8(z->occ[cap / 2], ==, FT_OCC_FREE);
+	ft_zone_destroy(z);
+	munmap(region, span);
+	return MUNIT_OK;
+}
+
 /* ---------- test registry ---------- */
 
 static MunitTest tests[] = {
@@ -350,8 +521,21 @@ static MunitTest tests[] = {
 	 NULL,
 	 MUNIT_TEST_OPTION_NONE,
 	 NULL},
+	{"/zone/release_free_pages",
+	 test_release_free_pages,
+	 NULL,
+	 NULL,
+	 MUNIT_TEST_OPTION_NONE,
+	 NULL},
 	{"/zone/show/slab", test_zone_print_slab, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
 	{"/zone/show/large", test_zone_print_large, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/zone/arena_take_give", test_arena_take_give, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{"/zone/arena_release_free_pages",
+	 test_arena_release_free_pages,
+	 NULL,
+	 NULL,
+	 MUNIT_TEST_OPTION_NONE,
+	 NULL},
 	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
 	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
 